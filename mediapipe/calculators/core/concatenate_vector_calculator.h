@@ -49,6 +49,7 @@ class ConcatenateVectorCalculator : public api2::Node {
 
   static absl::Status UpdateContract(CalculatorContract* cc) {
     RET_CHECK_GE(kIn(cc).Count(), 1);
+    cc->SetRunInline(true);
     return absl::OkStatus();
   }
 
@@ -138,6 +138,8 @@ class GateCalculator : public CalculatorBase {
       cc->Outputs().Tag(kStateChangeTag).Set<bool>();
     }
 
+    cc->SetRunInline(true);
+
     return absl::OkStatus();
   }
 
@@ -56,6 +56,7 @@ class PassThroughCalculator : public CalculatorBase {
             &cc->InputSidePackets().Get(id));
       }
     }
+    cc->SetRunInline(true);
     return absl::OkStatus();
   }
 
@@ -104,6 +104,8 @@ class SplitVectorCalculator : public CalculatorBase {
       }
     }
 
+    cc->SetRunInline(true);
+
     return absl::OkStatus();
   }
 
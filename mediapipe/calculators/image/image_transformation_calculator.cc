@@ -502,8 +502,10 @@ absl::Status ImageTransformationCalculator::RenderCpu(CalculatorContext* cc) {
 
   cv::Mat rotated_mat;
   cv::Size rotated_size(output_width, output_height);
-  if (input_mat.size() == rotated_size) {
-    const int angle = RotationModeToDegrees(rotation_);
+  const int angle = RotationModeToDegrees(rotation_);
+  if (input_mat.size() == rotated_size && angle == 0) {
+    rotated_mat = input_mat;
+  } else if (input_mat.size() == rotated_size) {
     cv::Point2f src_center(input_mat.cols / 2.0, input_mat.rows / 2.0);
     cv::Mat rotation_mat = cv::getRotationMatrix2D(src_center, angle, 1.0);
     cv::warpAffine(input_mat, rotated_mat, rotation_mat, rotated_size);
@@ -525,10 +527,27 @@ absl::Status ImageTransformationCalculator::RenderCpu(CalculatorContext* cc) {
     }
   }
 
+  const int flip_code =
+      flip_horizontally_ && flip_vertically_ ? -1 : flip_horizontally_;
+  if (rotated_mat.data == input.PixelData()) {
+    // The image was neither scaled nor rotated, so the input frame becomes the
+    // output frame if this calculator holds its only reference.  Otherwise
+    // ConsumeOrCopy makes the single copy that the output needs.
+    ASSIGN_OR_RETURN(
+        std::unique_ptr<ImageFrame> output_frame,
+        cc->Inputs().Tag(kImageFrameTag).Value().ConsumeOrCopy<ImageFrame>());
+    if (flip_horizontally_ || flip_vertically_) {
+      cv::Mat output_mat = formats::MatView(output_frame.get());
+      cv::flip(output_mat, output_mat, flip_code);
+    }
+    cc->Outputs()
+        .Tag(kImageFrameTag)
+        .Add(output_frame.release(), cc->InputTimestamp());
+    return absl::OkStatus();
+  }
+
   cv::Mat flipped_mat;
   if (flip_horizontally_ || flip_vertically_) {
-    const int flip_code =
-        flip_horizontally_ && flip_vertically_ ? -1 : flip_horizontally_;
     cv::flip(rotated_mat, flipped_mat, flip_code);
   } else {
     flipped_mat = rotated_mat;
@@ -0,0 +1,124 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/calculators/image/image_transformation_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr int kWidth = 4;
+constexpr int kHeight = 3;
+
+// Returns an SRGB frame in which every byte of a row holds the row index.
+std::unique_ptr<ImageFrame> MakeRowIndexFrame() {
+  auto frame =
+      absl::make_unique<ImageFrame>(ImageFormat::SRGB, kWidth, kHeight);
+  for (int row = 0; row < kHeight; ++row) {
+    uint8* row_data = frame->MutablePixelData() + row * frame->WidthStep();
+    std::fill(row_data, row_data + kWidth * frame->NumberOfChannels(), row);
+  }
+  return frame;
+}
+
+// Expects every byte of row i of |frame| to hold |row_values[i]|.
+void ExpectRowValues(const ImageFrame& frame,
+                     const std::vector<int>& row_values) {
+  ASSERT_EQ(frame.Height(), row_values.size());
+  for (int row = 0; row < frame.Height(); ++row) {
+    const uint8* row_data = frame.PixelData() + row * frame.WidthStep();
+    for (int i = 0; i < frame.Width() * frame.NumberOfChannels(); ++i) {
+      ASSERT_EQ(row_data[i], row_values[row]) << "row " << row << " byte " << i;
+    }
+  }
+}
+
+// Sends |input| through an ImageTransformationCalculator that only flips it
+// vertically, and stores the resulting packet in |output|.
+void FlipVertically(Packet input, Packet* output) {
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input_image"
+    node {
+      calculator: "ImageTransformationCalculator"
+      input_stream: "IMAGE:input_image"
+      output_stream: "IMAGE:output_image"
+      options {
+        [mediapipe.ImageTransformationCalculatorOptions.ext] {
+          flip_vertically: true
+        }
+      }
+    }
+  )pb")));
+  std::vector<Packet> output_packets;
+  MP_ASSERT_OK(graph.ObserveOutputStream(
+      "output_image", [&output_packets](const Packet& packet) {
+        output_packets.push_back(packet);
+        return absl::OkStatus();
+      }));
+  MP_ASSERT_OK(graph.StartRun({}));
+  MP_ASSERT_OK(graph.AddPacketToInputStream("input_image", std::move(input)));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(output_packets.size(), 1);
+  *output = output_packets[0];
+}
+
+TEST(ImageTransformationCalculatorTest, FlipsSoleOwnedFrameInPlace) {
+  auto frame = MakeRowIndexFrame();
+  const uint8* pixel_data = frame->PixelData();
+  const PacketConsumeStats before = GetPacketConsumeStats();
+
+  Packet output;
+  FlipVertically(Adopt(frame.release()).At(Timestamp(0)), &output);
+
+  const PacketConsumeStats after = GetPacketConsumeStats();
+  EXPECT_EQ(after.consumed - before.consumed, 1);
+  EXPECT_EQ(after.copied - before.copied, 0);
+  const auto& output_frame = output.Get<ImageFrame>();
+  EXPECT_EQ(output_frame.PixelData(), pixel_data);
+  ExpectRowValues(output_frame, {2, 1, 0});
+}
+
+TEST(ImageTransformationCalculatorTest, FlipsCopyOfSharedFrame) {
+  Packet input = Adopt(MakeRowIndexFrame().release()).At(Timestamp(0));
+  const PacketConsumeStats before = GetPacketConsumeStats();
+
+  Packet output;
+  FlipVertically(input, &output);
+
+  const PacketConsumeStats after = GetPacketConsumeStats();
+  EXPECT_EQ(after.consumed - before.consumed, 0);
+  EXPECT_EQ(after.copied - before.copied, 1);
+  const auto& output_frame = output.Get<ImageFrame>();
+  EXPECT_NE(output_frame.PixelData(), input.Get<ImageFrame>().PixelData());
+  ExpectRowValues(output_frame, {2, 1, 0});
+  // The frame still held by the test is left untouched.
+  ExpectRowValues(input.Get<ImageFrame>(), {0, 1, 2});
+}
+
+}  // namespace
+
+}  // namespace mediapipe
@@ -7,12 +7,14 @@
 #include <algorithm>
 #include <chrono>
 #include <condition_variable>
+#include <exception>
 #include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <openvino/openvino.hpp>
@@ -23,6 +25,8 @@
 
 typedef std::function<void(size_t id, const std::exception_ptr& ptr)>
     QueueCallbackFunction;
+typedef std::function<void(const std::exception_ptr& ptr)>
+    CompletionCallbackFunction;
 
 /// @brief Wrapper class for InferenceEngine::InferRequest. Handles asynchronous callbacks and calculates execution
 /// time.
@@ -37,6 +41,13 @@ public:
               _id(id),
               _callbackQueue(callbackQueue) {
       _request.set_callback([&](const std::exception_ptr &ptr) {
+          // The completion callback runs before the request is returned to
+          // the queue, so it can still read the output tensors.
+          if (_completion) {
+            CompletionCallbackFunction completion = std::move(_completion);
+            _completion = nullptr;
+            completion(ptr);
+          }
           _callbackQueue(_id, ptr);
       });
     }
@@ -45,6 +56,13 @@ public:
       _request.start_async();
     }
 
+    // Starts the request and calls `completion` from the inference thread
+    // once it finishes, before the request becomes idle again.
+    void start_async(CompletionCallbackFunction completion) {
+      _completion = std::move(completion);
+      _request.start_async();
+    }
+
     void wait() {
       _request.wait();
     }
@@ -54,6 +72,19 @@ public:
       _callbackQueue(_id, nullptr);
     }
 
+    // Runs the request on the calling thread and calls `completion` once it
+    // finishes, before the request becomes idle again.
+    void infer(CompletionCallbackFunction completion) {
+      std::exception_ptr error;
+      try {
+        _request.infer();
+      } catch (...) {
+        error = std::current_exception();
+      }
+      completion(error);
+      _callbackQueue(_id, error);
+    }
+
     void set_shape(const std::string& name, const ov::Shape& dims) {
       // TODO check return status
       _request.get_tensor(name).set_shape(dims);
@@ -75,6 +106,10 @@ public:
       _request.set_input_tensor(i, data);
     }
 
+    void set_output_tensor(size_t i, const ov::Tensor& data) {
+      _request.set_output_tensor(i, data);
+    }
+
 //    // in case of using GPU memory we need to allocate CL buffer for
 //    // output blobs. By encapsulating cl buffer inside InferReqWrap
 //    // we will control the number of output buffers and access to it.
@@ -86,6 +121,7 @@ private:
     ov::InferRequest _request;
     size_t _id;
     QueueCallbackFunction _callbackQueue;
+    CompletionCallbackFunction _completion;
 //    std::map<std::string, ::gpu::BufferType> outputClBuffer;
 };
 
@@ -17,12 +17,18 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <openvino/openvino.hpp>
 
-#include "absl/base/thread_annotations.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
-#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "mediapipe/calculators/openvino/openvino_inference_calculator.pb.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_framework.h"
@@ -32,10 +38,90 @@
 namespace {
     constexpr char kTensorsTag[] = "TENSORS";
     constexpr char kRemoteTensorsTag[] = "TENSORS_REMOTE";
+
+    std::string GetDeviceName(
+        const ::mediapipe::OpenVINOInferenceCalculatorOptions::Device& device) {
+      if (device.has_gpu()) return "GPU";
+      if (device.has_auto_()) return "AUTO";
+      return "CPU";
+    }
+
+    ov::hint::PerformanceMode GetPerformanceMode(
+        const ::mediapipe::OpenVINOInferenceCalculatorOptions& options) {
+      using Options = ::mediapipe::OpenVINOInferenceCalculatorOptions;
+      switch (options.performance_mode()) {
+        case Options::LATENCY:
+          return ov::hint::PerformanceMode::LATENCY;
+        case Options::THROUGHPUT:
+          return ov::hint::PerformanceMode::THROUGHPUT;
+        case Options::CUMULATIVE_THROUGHPUT:
+          return ov::hint::PerformanceMode::CUMULATIVE_THROUGHPUT;
+        default:
+          // Throughput mode lets the device run several requests at once,
+          // which only pays off when there are several requests.
+          return options.num_infer_requests() > 1
+                     ? ov::hint::PerformanceMode::THROUGHPUT
+                     : ov::hint::PerformanceMode::LATENCY;
+      }
+    }
+
+    // Returns the properties to compile the model with.
+    ov::AnyMap GetCompileConfig(
+        const ::mediapipe::OpenVINOInferenceCalculatorOptions& options) {
+      using Options = ::mediapipe::OpenVINOInferenceCalculatorOptions;
+      ov::AnyMap config;
+      config.emplace(ov::hint::performance_mode(GetPerformanceMode(options)));
+      if (options.num_streams() > 0) {
+        config.emplace(ov::num_streams(options.num_streams()));
+      }
+      switch (options.inference_precision()) {
+        case Options::F32:
+          config.emplace(ov::hint::inference_precision(ov::element::f32));
+          break;
+        case Options::F16:
+          config.emplace(ov::hint::inference_precision(ov::element::f16));
+          break;
+        case Options::BF16:
+          config.emplace(ov::hint::inference_precision(ov::element::bf16));
+          break;
+        default:
+          break;
+      }
+      if (!options.cache_dir().empty()) {
+        config.emplace(ov::cache_dir(options.cache_dir()));
+      }
+      return config;
+    }
+
+    std::string GetExceptionMessage(const std::exception_ptr& error) {
+      try {
+        std::rethrow_exception(error);
+      } catch (const std::exception& ex) {
+        return ex.what();
+      } catch (...) {
+        return "unknown error";
+      }
+    }
 }  // namespace
 
 namespace mediapipe {
 
+// Runs an OpenVINO model on the input tensors. Each Process() call waits for
+// its own inference request, so inference is only pipelined when the node
+// sets max_in_flight above its default of 1, e.g.:
+//
+// node {
+//   calculator: "OpenVINOInferenceCalculator"
+//   input_stream: "TENSORS:input_tensors"
+//   output_stream: "TENSORS:output_tensors"
+//   max_in_flight: 4
+//   options {
+//     [mediapipe.OpenVINOInferenceCalculatorOptions.ext] {
+//       model_path: "model.xml"
+//       num_infer_requests: 4
+//     }
+//   }
+// }
 class OpenVINOInferenceCalculator : public CalculatorBase {
 public:
     OpenVINOInferenceCalculator() {
@@ -81,15 +167,34 @@ public:
       RET_CHECK(!options.model_path().empty())
         << "Model path should be defined in options";
 
-      // TODO: process device message
+      RET_CHECK_GE(options.num_infer_requests(), 0);
+      RET_CHECK_GE(options.num_streams(), 0);
 
       ov::Core core;
-      model_ = core.compile_model(options.model_path(), "CPU");
+      try {
+        model_ = core.compile_model(options.model_path(),
+                                    GetDeviceName(options.device()),
+                                    GetCompileConfig(options));
+      } catch (const std::exception& ex) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Failed to compile OpenVINO model ", options.model_path(), ": ",
+            ex.what()));
+      }
+      outputs_ = model_.outputs();
 
-      // TODO: add perf hints
-      // TODO: get nireq from perf hints
-      size_t nireq = 4;
-      infer_requests_queue_ = std::make_unique<InferRequestsQueue>(model_, nireq);
+      size_t nireq = options.num_infer_requests();
+      if (nireq == 0) {
+        try {
+          nireq = model_.get_property(ov::optimal_number_of_infer_requests);
+        } catch (const std::exception& ex) {
+          return absl::InternalError(absl::StrCat(
+              "Failed to get the optimal number of OpenVINO requests: ",
+              ex.what()));
+        }
+      }
+      num_infer_requests_ = std::max<size_t>(nireq, 1);
+      infer_requests_queue_ =
+          std::make_unique<InferRequestsQueue>(model_, num_infer_requests_);
       return absl::OkStatus();
     }
 
@@ -99,8 +204,17 @@ public:
         return absl::OkStatus();
       }
 
-      // Get infer request
-      auto infer_request = infer_requests_queue_->get_idle_request();
+      // Get infer request, waiting for one to finish if all are busy. With
+      // max_in_flight > 1 on the node, Process() calls run concurrently, each
+      // on its own request, and the InOrderOutputStreamHandler sends their
+      // results in timestamp order.
+      InferReqWrap::Ptr infer_request;
+      try {
+        infer_request = infer_requests_queue_->get_idle_request();
+      } catch (const std::exception& ex) {
+        return absl::InternalError(
+            absl::StrCat("OpenVINO inference failed: ", ex.what()));
+      }
       if (!infer_request) {
         return absl::InternalError("No idle inference requests available");
       }
@@ -111,26 +225,48 @@ public:
       // TODO: add support for models with >1 inputs
 //      RET_CHECK_GT(input_tensors.size(), 0);
       RET_CHECK_EQ(input_tensors.size(), 1);
-      for (int i = 0; i < input_tensors.size(); ++i) {
-        infer_request->set_input_tensor(i, input_tensors[i]);
-      }
-//        RET_CHECK(input_tensor->data.raw);
-
-      // TODO: use async inference
-      infer_request->infer();
 
-      // Process output tensors
-      auto output_tensors = absl::make_unique<std::vector<ov::Tensor>>();
-      for (int i = 0; i < model_.outputs().size(); ++i) {
-        ov::Tensor out_tensor = infer_request->get_output_tensor(i);
-        output_tensors->emplace_back(out_tensor);
+      // The outputs are collected by the completion callback, which runs
+      // before the request goes back to the idle queue, where a concurrent
+      // Process() call could take it and bind new outputs.
+      std::unique_ptr<std::vector<ov::Tensor>> output_tensors;
+      std::exception_ptr error;
+      absl::Notification done;
+      auto on_done = [&, request = infer_request.get()](
+                         const std::exception_ptr& request_error) {
+        if (!request_error) {
+          output_tensors = CollectOutputTensors(*request);
+        }
+        error = request_error;
+        done.Notify();
+      };
+      try {
+        for (int i = 0; i < input_tensors.size(); ++i) {
+          infer_request->set_input_tensor(i, input_tensors[i]);
+        }
+//        RET_CHECK(input_tensor->data.raw);
+        BindOutputTensors(*infer_request);
+        if (num_infer_requests_ == 1) {
+          // Nothing can overlap with a single request, so run it on this
+          // thread rather than handing it to an inference thread.
+          infer_request->infer(on_done);
+        } else {
+          infer_request->start_async(on_done);
+        }
+      } catch (const std::exception& ex) {
+        return absl::InternalError(
+            absl::StrCat("OpenVINO inference failed: ", ex.what()));
+      }
+      done.WaitForNotification();
+      if (error) {
+        return absl::InternalError(absl::StrCat(
+            "OpenVINO inference failed: ", GetExceptionMessage(error)));
       }
 
       // Prepare calculator output
       cc->Outputs()
         .Tag(kTensorsTag)
         .Add(output_tensors.release(), cc->InputTimestamp());
-
       return absl::OkStatus();
     }
 
@@ -139,7 +275,41 @@ public:
     }
 
 private:
+    // Gives the request new tensors for its outputs with a static shape, so
+    // that tensors sent downstream are not overwritten when it is reused.
+    void BindOutputTensors(InferReqWrap& infer_request) {
+      for (size_t i = 0; i < outputs_.size(); ++i) {
+        if (outputs_[i].get_partial_shape().is_static()) {
+          infer_request.set_output_tensor(
+              i, ov::Tensor(outputs_[i].get_element_type(),
+                            outputs_[i].get_shape()));
+        }
+      }
+    }
+
+    std::unique_ptr<std::vector<ov::Tensor>> CollectOutputTensors(
+        InferReqWrap& infer_request) {
+      auto output_tensors = absl::make_unique<std::vector<ov::Tensor>>();
+      for (size_t i = 0; i < outputs_.size(); ++i) {
+        ov::Tensor out_tensor = infer_request.get_output_tensor(i);
+        if (!outputs_[i].get_partial_shape().is_static()) {
+          // Dynamically shaped outputs are owned by the request.
+          ov::Tensor copy(out_tensor.get_element_type(),
+                          out_tensor.get_shape());
+          out_tensor.copy_to(copy);
+          out_tensor = copy;
+        }
+        output_tensors->emplace_back(out_tensor);
+      }
+      return output_tensors;
+    }
+
     ov::CompiledModel model_;
+    std::vector<ov::Output<const ov::Node>> outputs_;
+    size_t num_infer_requests_ = 1;
+
+    // Declared last so that it is destroyed first: destroying the requests
+    // waits for running ones, whose callbacks use the members above.
     std::unique_ptr<InferRequestsQueue> infer_requests_queue_;
 };
 
@@ -13,10 +13,44 @@
 // limitations under the License.
 //
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
 #include "mediapipe/calculators/openvino/openvino_inference_calculator_test_common.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/file_helpers.h"
 namespace mediapipe {
 
+constexpr char kConcurrentGraph[] = R"(
+  input_stream: "tensor_in"
+  max_queue_size: 4
+  num_threads: 4
+  node {
+    calculator: "OpenVINOInferenceCalculator"
+    input_stream: "TENSORS:tensor_in"
+    output_stream: "TENSORS:tensor_out"
+    max_in_flight: $max_in_flight
+    options {
+      [mediapipe.OpenVINOInferenceCalculatorOptions.ext] {
+        model_path: "mediapipe/calculators/openvino/testdata/add.xml"
+        device { cpu {} }
+        num_infer_requests: $max_in_flight
+      }
+    }
+  }
+)";
+
+Packet MakeInputPacket(uint8_t value, Timestamp timestamp) {
+  ov::Tensor input_tensor(ov::element::u8, {1, 3, 8, 8});
+  std::fill_n(input_tensor.data<uint8_t>(), input_tensor.get_size(), value);
+  return MakePacket<std::vector<ov::Tensor>>(
+             std::vector<ov::Tensor>{input_tensor})
+      .At(timestamp);
+}
+
 // Tests a simple add model that adds two input tensors
 TEST(OpenVINOInferenceCalculatorTest, SmokeTest) {
   std::string graph_proto = R"(
@@ -40,6 +74,124 @@ TEST(OpenVINOInferenceCalculatorTest, SmokeTest) {
 //      graph_proto, {{"$device", "device { cpu {} }"}}));
 }
 
+TEST(OpenVINOInferenceCalculatorTest, SmokeTestWithCompileOptions) {
+  std::string graph_proto = R"(
+    input_stream: "tensor_in"
+    node {
+      calculator: "OpenVINOInferenceCalculator"
+      input_stream: "TENSORS:tensor_in"
+      output_stream: "TENSORS:tensor_out"
+      options {
+        [mediapipe.OpenVINOInferenceCalculatorOptions.ext] {
+          model_path: "mediapipe/calculators/openvino/testdata/add.xml"
+          device { cpu {} }
+          performance_mode: THROUGHPUT
+          num_streams: 2
+          inference_precision: F32
+          cache_dir: "$cache_dir"
+        }
+      }
+    }
+  )";
+  const std::string cache_dir =
+      file::JoinPath(::testing::TempDir(), "openvino_cache");
+  graph_proto =
+      absl::StrReplaceAll(graph_proto, {{"$cache_dir", cache_dir}});
+
+  // The first run compiles the model and stores it in the cache.
+  DoSmokeTest<uint8_t>(graph_proto);
+  std::vector<std::string> cached_blobs;
+  MP_ASSERT_OK(file::MatchFileTypeInDirectory(cache_dir, ".blob",
+                                              &cached_blobs));
+  ASSERT_FALSE(cached_blobs.empty());
+
+  // The second run loads the model from the cache instead of adding a blob.
+  DoSmokeTest<uint8_t>(graph_proto);
+  std::vector<std::string> blobs_after_second_run;
+  MP_ASSERT_OK(file::MatchFileTypeInDirectory(cache_dir, ".blob",
+                                              &blobs_after_second_run));
+  EXPECT_THAT(blobs_after_second_run,
+              ::testing::UnorderedElementsAreArray(cached_blobs));
+}
+
+// Runs a stream of inputs through kConcurrentGraph and expects the results
+// in timestamp order, each one computed from its own input.
+void ExpectOrderedResults(int max_in_flight) {
+  constexpr int kNumInputs = 16;
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+          kConcurrentGraph, {{"$max_in_flight", absl::StrCat(max_in_flight)}}));
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < kNumInputs; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "tensor_in", MakeInputPacket(i, Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(output_packets.size(), kNumInputs);
+  for (int i = 0; i < kNumInputs; ++i) {
+    EXPECT_EQ(output_packets[i].Timestamp(), Timestamp(i));
+    const auto& result_vec = output_packets[i].Get<std::vector<ov::Tensor>>();
+    ASSERT_EQ(result_vec.size(), 1);
+    const uint8_t* result_buffer = result_vec[0].data<uint8_t>();
+    for (int j = 0; j < result_vec[0].get_size(); ++j) {
+      ASSERT_EQ(result_buffer[j], 2 * i);
+    }
+  }
+}
+
+// A single request runs synchronously on the calculator thread.
+TEST(OpenVINOInferenceCalculatorTest, SyncInferenceKeepsTimestampOrder) {
+  ExpectOrderedResults(1);
+}
+
+// Requests run concurrently with max_in_flight, but results still come out
+// in timestamp order.
+TEST(OpenVINOInferenceCalculatorTest, ConcurrentInferenceKeepsTimestampOrder) {
+  ExpectOrderedResults(4);
+}
+
+// Measures the throughput of a stream of inputs with synchronous inference
+// on a single request and with asynchronous inference on max_in_flight
+// concurrent requests. The input queue is bounded, so the loop keeps the
+// calculator busy without queueing every input up front.
+void BM_OpenVINOInferenceThroughput(benchmark::State& state) {
+  const int max_in_flight = state.range(0);
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+          kConcurrentGraph, {{"$max_in_flight", absl::StrCat(max_in_flight)}}));
+  CalculatorGraph graph;
+  CHECK_OK(graph.Initialize(graph_config));
+  graph.SetGraphInputStreamAddMode(
+      CalculatorGraph::GraphInputStreamAddMode::WAIT_TILL_NOT_FULL);
+  int64 num_outputs = 0;
+  CHECK_OK(graph.ObserveOutputStream("tensor_out", [&](const Packet&) {
+    ++num_outputs;
+    return absl::OkStatus();
+  }));
+  CHECK_OK(graph.StartRun({}));
+  int64 num_inputs = 0;
+  for (auto _ : state) {
+    CHECK_OK(graph.AddPacketToInputStream(
+        "tensor_in", MakeInputPacket(1, Timestamp(num_inputs++))));
+  }
+  CHECK_OK(graph.CloseInputStream("tensor_in"));
+  CHECK_OK(graph.WaitUntilDone());
+  CHECK_EQ(num_outputs, num_inputs);
+  state.SetItemsProcessed(num_inputs);
+  state.SetLabel(max_in_flight == 1 ? "sync" : "async");
+}
+
+BENCHMARK(BM_OpenVINOInferenceThroughput)
+    ->ArgName("max_in_flight")
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime();
+
 // TEST(OpenVINOInferenceCalculatorTest, SmokeTest_ModelAsInputSidePacket) {
 //   std::string graph_proto = R"(
 //     input_stream: "tensor_in"
@@ -24,6 +24,7 @@
 #include "mediapipe/calculators/tensor/inference_calculator.pb.h"
 #include "mediapipe/framework/api2/packet.h"
 #include "mediapipe/framework/tool/subgraph_expansion.h"
+#include "mediapipe/util/tflite/tflite_model_cache.h"
 #include "tensorflow/lite/core/api/op_resolver.h"
 
 namespace mediapipe {
@@ -65,6 +66,12 @@ class InferenceCalculatorSelectorImpl
       if (!mediapipe::CalculatorBaseRegistry::IsRegistered(impl)) continue;
       CalculatorGraphConfig::Node impl_node = subgraph_node;
       impl_node.set_calculator(impl);
+      const bool runs_on_cpu = suffix == "Cpu" || suffix == "Xnnpack";
+      if (runs_on_cpu && options.num_interpreters() > 1 &&
+          impl_node.max_in_flight() == 0) {
+        // Gives every interpreter its own Process() call.
+        impl_node.set_max_in_flight(options.num_interpreters());
+      }
       return tool::MakeSingleNodeGraph(std::move(impl_node));
     }
     return absl::UnimplementedError("no implementation available");
@@ -75,7 +82,11 @@ absl::StatusOr<Packet<TfLiteModelPtr>> InferenceCalculator::GetModelAsPacket(
     CalculatorContext* cc) {
   const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
   if (!options.model_path().empty()) {
-    return TfLiteModelLoader::LoadFromPath(options.model_path());
+    // Models are shared with the other calculators that load the same file.
+    ASSIGN_OR_RETURN(
+        std::string model_blob,
+        TfLiteModelLoader::LoadContentsFromPath(options.model_path()));
+    return TfLiteModelCache::GetInstance().GetModel(std::move(model_blob));
   }
   if (!kSideInModel(cc).IsEmpty()) return kSideInModel(cc);
   return absl::Status(mediapipe::StatusCode::kNotFound,
@@ -94,5 +105,30 @@ InferenceCalculator::GetOpResolverAsPacket(CalculatorContext* cc) {
           tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates>());
 }
 
+absl::Status InferenceCalculator::RunBatch(CalculatorContext* cc,
+                                           InferenceRunner* runner) {
+  const auto& input = cc->Inputs().Tag(kInTensors.Tag());
+  std::vector<const std::vector<Tensor>*> batch;
+  std::vector<Timestamp> timestamps;
+  for (int i = 0; i < cc->BatchSize(); ++i) {
+    const mediapipe::Packet& packet = input.BatchValue(i);
+    if (packet.IsEmpty()) continue;
+    const auto& input_tensors = packet.Get<std::vector<Tensor>>();
+    RET_CHECK(!input_tensors.empty());
+    batch.push_back(&input_tensors);
+    timestamps.push_back(cc->BatchTimestamp(i));
+  }
+  if (batch.empty()) {
+    return absl::OkStatus();
+  }
+  ASSIGN_OR_RETURN(std::vector<std::vector<Tensor>> outputs,
+                   runner->RunBatch(cc, batch));
+  RET_CHECK_EQ(outputs.size(), batch.size());
+  for (int i = 0; i < outputs.size(); ++i) {
+    kOutTensors(cc).Send(std::move(outputs[i]), timestamps[i]);
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace api2
 }  // namespace mediapipe
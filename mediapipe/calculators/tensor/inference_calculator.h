@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "mediapipe/calculators/tensor/inference_calculator.pb.h"
+#include "mediapipe/calculators/tensor/inference_runner.h"
 #include "mediapipe/framework/api2/node.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/tensor.h"
@@ -90,6 +91,9 @@ namespace api2 {
 // IMPORTANT Notes:
 //  Tensors are assumed to be ordered correctly (sequentially added to model).
 //  Input tensors are assumed to be of the correct size and already normalized.
+//  On CPU, "max_batch_size" in the options lets a single interpreter invocation
+//  process several queued input timestamps, e.g. the ROIs of a
+//  BeginLoopCalculator loop. Outputs are still sent at each input timestamp.
 
 class InferenceCalculator : public NodeIntf {
  public:
@@ -119,6 +123,11 @@ class InferenceCalculator : public NodeIntf {
 
   static absl::StatusOr<Packet<tflite::OpResolver>> GetOpResolverAsPacket(
       CalculatorContext* cc);
+
+  // Runs all the input tensor vectors of a batched Process() call through
+  // `runner` and sends each output tensor vector at its input timestamp.
+  // See CalculatorContract::SetMaxBatchSize().
+  static absl::Status RunBatch(CalculatorContext* cc, InferenceRunner* runner);
 };
 
 struct InferenceCalculatorSelector : public InferenceCalculator {
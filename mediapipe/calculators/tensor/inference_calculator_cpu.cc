@@ -24,6 +24,7 @@
 #include "mediapipe/calculators/tensor/inference_calculator_utils.h"
 #include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
 #include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/inference_runner_pool.h"
 #include "tensorflow/lite/interpreter.h"
 #if defined(MEDIAPIPE_ANDROID)
 #include "tensorflow/lite/delegates/nnapi/nnapi_delegate.h"
@@ -45,7 +46,11 @@ class InferenceCalculatorCpuImpl
  private:
   absl::StatusOr<std::unique_ptr<InferenceRunner>> CreateInferenceRunner(
       CalculatorContext* cc);
-  absl::StatusOr<TfLiteDelegatePtr> MaybeCreateDelegate(CalculatorContext* cc);
+  // Sets `weights_cache` if the returned delegate uses a shared XNNPACK
+  // weights cache.
+  absl::StatusOr<TfLiteDelegatePtr> MaybeCreateDelegate(
+      CalculatorContext* cc, const tflite::FlatBufferModel& model,
+      std::shared_ptr<XnnpackWeightsCache>* weights_cache);
 
   std::unique_ptr<InferenceRunner> inference_runner_;
 };
@@ -55,16 +60,28 @@ absl::Status InferenceCalculatorCpuImpl::UpdateContract(
   const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
   RET_CHECK(!options.model_path().empty() ^ kSideInModel(cc).IsConnected())
       << "Either model as side packet or model path in options is required.";
+  RET_CHECK_GE(options.max_batch_size(), 1);
+  RET_CHECK_GE(options.num_interpreters(), 1);
+  RET_CHECK(options.max_batch_size() == 1 || options.num_interpreters() == 1)
+      << "max_batch_size and num_interpreters cannot be set together.";
+  cc->SetMaxBatchSize(options.max_batch_size());
 
   return absl::OkStatus();
 }
 
 absl::Status InferenceCalculatorCpuImpl::Open(CalculatorContext* cc) {
-  ASSIGN_OR_RETURN(inference_runner_, CreateInferenceRunner(cc));
+  const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
+  ASSIGN_OR_RETURN(inference_runner_,
+                   CreateInferenceRunnerPool(options.num_interpreters(), [&] {
+                     return CreateInferenceRunner(cc);
+                   }));
   return absl::OkStatus();
 }
 
 absl::Status InferenceCalculatorCpuImpl::Process(CalculatorContext* cc) {
+  if (cc->BatchSize() > 1) {
+    return RunBatch(cc, inference_runner_.get());
+  }
   if (kInTensors(cc).IsEmpty()) {
     return absl::OkStatus();
   }
@@ -86,16 +103,22 @@ absl::StatusOr<std::unique_ptr<InferenceRunner>>
 InferenceCalculatorCpuImpl::CreateInferenceRunner(CalculatorContext* cc) {
   ASSIGN_OR_RETURN(auto model_packet, GetModelAsPacket(cc));
   ASSIGN_OR_RETURN(auto op_resolver_packet, GetOpResolverAsPacket(cc));
-  const int interpreter_num_threads =
-      cc->Options<mediapipe::InferenceCalculatorOptions>().cpu_num_thread();
-  ASSIGN_OR_RETURN(TfLiteDelegatePtr delegate, MaybeCreateDelegate(cc));
+  const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
+  std::shared_ptr<XnnpackWeightsCache> weights_cache;
+  ASSIGN_OR_RETURN(
+      TfLiteDelegatePtr delegate,
+      MaybeCreateDelegate(cc, *model_packet.Get(), &weights_cache));
   return CreateInferenceInterpreterDelegateRunner(
       std::move(model_packet), std::move(op_resolver_packet),
-      std::move(delegate), interpreter_num_threads);
+      std::move(delegate), options.cpu_num_thread(),
+      options.zero_copy_cpu_io(), weights_cache.get(),
+      options.max_batch_size());
 }
 
 absl::StatusOr<TfLiteDelegatePtr>
-InferenceCalculatorCpuImpl::MaybeCreateDelegate(CalculatorContext* cc) {
+InferenceCalculatorCpuImpl::MaybeCreateDelegate(
+    CalculatorContext* cc, const tflite::FlatBufferModel& model,
+    std::shared_ptr<XnnpackWeightsCache>* weights_cache) {
   const auto& calculator_opts =
       cc->Options<mediapipe::InferenceCalculatorOptions>();
   auto opts_delegate = calculator_opts.delegate();
@@ -153,8 +176,7 @@ InferenceCalculatorCpuImpl::MaybeCreateDelegate(CalculatorContext* cc) {
         GetXnnpackNumThreads(opts_has_delegate, opts_delegate);
     // TODO Remove once XNNPACK is enabled by default.
     xnnpack_opts.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_QU8;
-    return TfLiteDelegatePtr(TfLiteXNNPackDelegateCreate(&xnnpack_opts),
-                             &TfLiteXNNPackDelegateDelete);
+    return CreateXnnpackDelegate(model, xnnpack_opts, weights_cache);
   }
 
   return nullptr;
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -21,7 +22,7 @@
 #include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
 #include "mediapipe/calculators/tensor/inference_calculator.pb.h"
-#include "mediapipe/calculators/tensor/inference_calculator_test_base.h"
+#include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/deps/file_path.h"
@@ -32,6 +33,7 @@
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"  // NOLINT
+#include "mediapipe/framework/tool/sink.h"
 #include "mediapipe/framework/tool/validate_type.h"
 #include "tensorflow/lite/error_reporter.h"
 #include "tensorflow/lite/kernels/register.h"
@@ -100,7 +102,7 @@ constexpr char kGraphWithModelAsInputSidePacket[] = R"(
     }
   )";
 
-std::vector<Tensor> CreateInputs() {
+std::vector<Tensor> CreateInputs(float value = 1) {
   std::vector<Tensor> input_vec;
   // Prepare input tensor.
   input_vec.emplace_back(
@@ -111,7 +113,7 @@ std::vector<Tensor> CreateInputs() {
     auto num_elements = input_vec.back().shape().num_elements();
     auto tensor_buffer = view.buffer<float>();
     for (int i = 0; i < num_elements; i++) {
-      tensor_buffer[i] = 1;
+      tensor_buffer[i] = value;
     }
   }
 
@@ -174,12 +176,215 @@ TEST(InferenceCalculatorTest, SmokeTest) {
   DoSmokeTest(absl::StrReplaceAll(
       kGraphWithModelPathInOption,
       {{"$delegate", "delegate { xnnpack { num_threads: 10 } }"}}));
+  DoSmokeTest(absl::StrReplaceAll(
+      kGraphWithModelPathInOption,
+      {{"$delegate", "delegate { tflite {} } zero_copy_cpu_io: true"}}));
+  DoSmokeTest(absl::StrReplaceAll(
+      kGraphWithModelPathInOption,
+      {{"$delegate", "delegate { xnnpack {} } zero_copy_cpu_io: true"}}));
 }
 
 TEST(InferenceCalculatorTest, ModelAsInputSidePacketSmokeTest) {
   DoSmokeTest(kGraphWithModelAsInputSidePacket);
 }
 
+// Runs several inferences with zero_copy_cpu_io and checks that every result
+// keeps its own values once later inferences have run, and that outputs are
+// only copied when a delegate is applied.
+TEST(InferenceCalculatorTest, ZeroCopyKeepsEveryResult) {
+  constexpr int kTensorBytes =
+      kTensorHeight * kTensorWidth * kTensorChannels * sizeof(float);
+  const struct {
+    const char* delegate;
+    int bytes_copied_per_run;
+  } kCases[] = {{"delegate { tflite {} }", 0},
+                {"delegate { xnnpack {} }", kTensorBytes}};
+  for (const auto& test_case : kCases) {
+    CalculatorGraphConfig graph_config =
+        ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+            kGraphWithModelPathInOption,
+            {{"$delegate",
+              absl::StrCat(test_case.delegate, " zero_copy_cpu_io: true")}}));
+    graph_config.mutable_node(0)->set_name("inference");
+    std::vector<Packet> output_packets;
+    tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+    CalculatorGraph graph(graph_config);
+    MP_ASSERT_OK(graph.StartRun({}));
+    constexpr int kNumInputs = 4;
+    for (int t = 0; t < kNumInputs; ++t) {
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "tensor_in", MakePacket<std::vector<Tensor>>(CreateInputs(t + 1))
+                           .At(Timestamp(t))));
+      MP_ASSERT_OK(graph.WaitUntilIdle());
+    }
+    MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+    MP_ASSERT_OK(graph.WaitUntilDone());
+
+    EXPECT_EQ(kNumInputs * test_case.bytes_copied_per_run,
+              graph.GetCounterFactory()
+                  ->GetCounter(absl::StrCat("inference-",
+                                            kInferenceBytesCopiedCounter))
+                  ->Get())
+        << test_case.delegate;
+    ASSERT_EQ(kNumInputs, output_packets.size());
+    for (int t = 0; t < kNumInputs; ++t) {
+      const Tensor& result = output_packets[t].Get<std::vector<Tensor>>()[0];
+      auto view = result.GetCpuReadView();
+      auto result_buffer = view.buffer<float>();
+      for (int i = 0; i < result.shape().num_elements(); i++) {
+        ASSERT_EQ(3 * (t + 1), result_buffer[i]) << test_case.delegate;
+      }
+    }
+  }
+}
+
+// Feeds several timestamps at once so that they can be run as one batch, and
+// checks that every result is sent at the timestamp of its input.
+TEST(InferenceCalculatorTest, BatchedInferenceKeepsTimestamps) {
+  for (const char* delegate : {"delegate { tflite {} }",
+                               "delegate { xnnpack {} }"}) {
+    CalculatorGraphConfig graph_config =
+        ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+            kGraphWithModelPathInOption,
+            {{"$delegate", absl::StrCat(delegate, " max_batch_size: 4")}}));
+    graph_config.mutable_node(0)->set_name("inference");
+    std::vector<Packet> output_packets;
+    tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+    CalculatorGraph graph(graph_config);
+    MP_ASSERT_OK(graph.StartRun({}));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+    // While the scheduler is paused, the first input is scheduled on its own
+    // and the next four queue up behind it, so they form one full batch. The
+    // last input then runs alone, padded to the batch size.
+    graph.Pause();
+    constexpr int kNumInputs = 6;
+    for (int t = 0; t < kNumInputs - 1; ++t) {
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "tensor_in", MakePacket<std::vector<Tensor>>(CreateInputs(t + 1))
+                           .At(Timestamp(t))));
+    }
+    graph.Resume();
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "tensor_in",
+        MakePacket<std::vector<Tensor>>(CreateInputs(kNumInputs))
+            .At(Timestamp(kNumInputs - 1))));
+    MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+    MP_ASSERT_OK(graph.WaitUntilDone());
+
+    EXPECT_EQ(3, graph.GetCounterFactory()
+                     ->GetCounter(absl::StrCat("inference-",
+                                               kInferenceInvocationsCounter))
+                     ->Get());
+    ASSERT_EQ(kNumInputs, output_packets.size());
+    for (int t = 0; t < kNumInputs; ++t) {
+      EXPECT_EQ(Timestamp(t), output_packets[t].Timestamp());
+      const std::vector<Tensor>& result_vec =
+          output_packets[t].Get<std::vector<Tensor>>();
+      ASSERT_EQ(1, result_vec.size());
+      const Tensor& result = result_vec[0];
+      EXPECT_EQ(1, result.shape().dims[0]);
+      auto view = result.GetCpuReadView();
+      auto result_buffer = view.buffer<float>();
+      for (int i = 0; i < result.shape().num_elements(); i++) {
+        ASSERT_EQ(3 * (t + 1), result_buffer[i]);
+      }
+    }
+  }
+}
+
+// Runs several interpreters concurrently and checks that the results are
+// still sent in timestamp order.
+TEST(InferenceCalculatorTest, ConcurrentInferenceKeepsTimestampOrder) {
+  for (const char* delegate : {"delegate { tflite {} }",
+                               "delegate { xnnpack {} }"}) {
+    CalculatorGraphConfig graph_config =
+        ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+            kGraphWithModelPathInOption,
+            {{"$delegate", absl::StrCat(delegate, " num_interpreters: 3")}}));
+    graph_config.set_num_threads(4);
+    std::vector<Packet> output_packets;
+    tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+    CalculatorGraph graph(graph_config);
+    MP_ASSERT_OK(graph.StartRun({}));
+    constexpr int kNumInputs = 12;
+    for (int t = 0; t < kNumInputs; ++t) {
+      MP_ASSERT_OK(graph.AddPacketToInputStream(
+          "tensor_in", MakePacket<std::vector<Tensor>>(CreateInputs(t + 1))
+                           .At(Timestamp(t))));
+    }
+    MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+    MP_ASSERT_OK(graph.WaitUntilDone());
+
+    ASSERT_EQ(kNumInputs, output_packets.size());
+    for (int t = 0; t < kNumInputs; ++t) {
+      EXPECT_EQ(Timestamp(t), output_packets[t].Timestamp());
+      const Tensor& result = output_packets[t].Get<std::vector<Tensor>>()[0];
+      auto view = result.GetCpuReadView();
+      EXPECT_EQ(3 * (t + 1), view.buffer<float>()[0]);
+    }
+  }
+}
+
+// Checks that num_interpreters lets the selected CPU implementation run that
+// many Process() calls in parallel, unless the node sets max_in_flight.
+TEST(InferenceCalculatorTest, NumInterpretersSetsMaxInFlight) {
+  for (const char* delegate : {"delegate { tflite {} }",
+                               "delegate { xnnpack {} }"}) {
+    CalculatorGraphConfig graph_config =
+        ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+            kGraphWithModelPathInOption,
+            {{"$delegate", absl::StrCat(delegate, " num_interpreters: 3")}}));
+    CalculatorGraph graph;
+    MP_ASSERT_OK(graph.Initialize(graph_config));
+    ASSERT_EQ(1, graph.Config().node_size());
+    EXPECT_EQ(3, graph.Config().node(0).max_in_flight()) << delegate;
+
+    graph_config.mutable_node(0)->set_max_in_flight(2);
+    CalculatorGraph limited_graph;
+    MP_ASSERT_OK(limited_graph.Initialize(graph_config));
+    ASSERT_EQ(1, limited_graph.Config().node_size());
+    EXPECT_EQ(2, limited_graph.Config().node(0).max_in_flight()) << delegate;
+  }
+}
+
+TEST(InferenceCalculatorTest, RejectsNumInterpretersWithMaxBatchSize) {
+  for (const char* delegate : {"delegate { tflite {} }",
+                               "delegate { xnnpack {} }"}) {
+    CalculatorGraph graph;
+    absl::Status status = graph.Initialize(
+        ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+            kGraphWithModelPathInOption,
+            {{"$delegate", absl::StrCat(delegate,
+                                        " num_interpreters: 2"
+                                        " max_batch_size: 4")}})));
+    EXPECT_FALSE(status.ok()) << delegate;
+    EXPECT_THAT(status.message(),
+                ::testing::HasSubstr(
+                    "max_batch_size and num_interpreters cannot be set"))
+        << delegate;
+  }
+}
+
+// Measures how long it takes to start a graph that runs the model with
+// `delegate`, which is mostly loading the model and creating the interpreter.
+void RunBenchmarkCalculatorInitialization(
+    benchmark::State& state,
+    const InferenceCalculatorOptions::Delegate& delegate) {
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+          kGraphWithModelPathInOption,
+          {{"$delegate",
+            absl::StrCat("delegate { ", delegate.ShortDebugString(), " }")}}));
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    CHECK_OK(graph.Initialize(graph_config));
+    CHECK_OK(graph.StartRun({}));
+    CHECK_OK(graph.CloseAllPacketSources());
+    CHECK_OK(graph.WaitUntilDone());
+  }
+}
+
 void BM_InitializeCalculator(benchmark::State& state) {
   mediapipe::InferenceCalculatorOptions::Delegate delegate;
   delegate.mutable_tflite();
@@ -188,5 +393,89 @@ void BM_InitializeCalculator(benchmark::State& state) {
 
 BENCHMARK(BM_InitializeCalculator);
 
+constexpr char kBenchmarkGraph[] = R"(
+    input_stream: "tensor_in"
+    node {
+      calculator: "TfLiteCustomOpResolverCalculator"
+      output_side_packet: "OP_RESOLVER:op_resolver"
+    }
+    node {
+      calculator: "InferenceCalculator"
+      name: "inference"
+      input_stream: "TENSORS:tensor_in"
+      output_stream: "TENSORS:tensor_out"
+      input_side_packet: "OP_RESOLVER:op_resolver"
+      options {
+        [mediapipe.InferenceCalculatorOptions.ext] {
+          model_path: "$model"
+          delegate { $delegate }
+          zero_copy_cpu_io: $zero_copy
+        }
+      }
+    }
+  )";
+
+// Runs `model_path` on one float input of `input_shape` per iteration, and
+// reports the number of tensor bytes copied per inference. The benchmark
+// arguments set zero_copy_cpu_io and select the XNNPACK delegate over plain
+// TFLite. Output tensors are only bound without a delegate.
+void RunModelBenchmark(benchmark::State& state, const std::string& model_path,
+                       const Tensor::Shape& input_shape) {
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+          kBenchmarkGraph,
+          {{"$model", model_path},
+           {"$zero_copy", state.range(0) ? "true" : "false"},
+           {"$delegate", state.range(1) ? "xnnpack {}" : "tflite {}"}}));
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+  CalculatorGraph graph;
+  CHECK_OK(graph.Initialize(graph_config));
+  CHECK_OK(graph.StartRun({}));
+  int64 num_runs = 0;
+  for (auto _ : state) {
+    std::vector<Tensor> input_vec;
+    input_vec.emplace_back(Tensor::ElementType::kFloat32, input_shape);
+    {
+      auto view = input_vec.back().GetCpuWriteView();
+      std::fill_n(view.buffer<float>(), input_shape.num_elements(), 0.5f);
+    }
+    CHECK_OK(graph.AddPacketToInputStream(
+        "tensor_in", MakePacket<std::vector<Tensor>>(std::move(input_vec))
+                         .At(Timestamp(num_runs++))));
+    CHECK_OK(graph.WaitUntilIdle());
+    output_packets.clear();
+  }
+  CHECK_OK(graph.CloseInputStream("tensor_in"));
+  CHECK_OK(graph.WaitUntilDone());
+  const int64 bytes_copied =
+      graph.GetCounterFactory()
+          ->GetCounter(absl::StrCat("inference-", kInferenceBytesCopiedCounter))
+          ->Get();
+  state.counters["bytes_copied_per_run"] =
+      num_runs > 0 ? static_cast<double>(bytes_copied) / num_runs : 0;
+}
+
+void BM_FaceDetectionInference(benchmark::State& state) {
+  RunModelBenchmark(
+      state,
+      "mediapipe/modules/face_detection/face_detection_short_range.tflite",
+      Tensor::Shape{1, 128, 128, 3});
+}
+
+BENCHMARK(BM_FaceDetectionInference)
+    ->ArgNames({"zero_copy", "xnnpack"})
+    ->ArgsProduct({{0, 1}, {0, 1}});
+
+void BM_SelfieSegmentationInference(benchmark::State& state) {
+  RunModelBenchmark(
+      state, "mediapipe/modules/selfie_segmentation/selfie_segmentation.tflite",
+      Tensor::Shape{1, 256, 256, 3});
+}
+
+BENCHMARK(BM_SelfieSegmentationInference)
+    ->ArgNames({"zero_copy", "xnnpack"})
+    ->ArgsProduct({{0, 1}, {0, 1}});
+
 }  // namespace
 }  // namespace mediapipe
@@ -16,6 +16,7 @@
 
 #include "mediapipe/calculators/tensor/inference_calculator.pb.h"
 #include "mediapipe/framework/port.h"  // NOLINT: provides MEDIAPIPE_ANDROID/IOS
+#include "mediapipe/util/tflite/tflite_model_cache.h"
 
 #if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
 #include "mediapipe/util/cpu_util.h"
@@ -50,4 +51,21 @@ int GetXnnpackNumThreads(
   return GetXnnpackDefaultNumThreads();
 }
 
+TfLiteDelegatePtr CreateXnnpackDelegate(
+    const tflite::FlatBufferModel& model,
+    TfLiteXNNPackDelegateOptions xnnpack_opts,
+    std::shared_ptr<XnnpackWeightsCache>* weights_cache) {
+  *weights_cache = TfLiteModelCache::GetInstance().GetXnnpackWeightsCache(
+      model, xnnpack_opts.flags);
+  if (*weights_cache) {
+    xnnpack_opts.weights_cache = (*weights_cache)->get();
+  }
+  // The delegate keeps the weights cache alive.
+  return TfLiteDelegatePtr(
+      TfLiteXNNPackDelegateCreate(&xnnpack_opts),
+      [weights_cache = *weights_cache](TfLiteDelegate* delegate) {
+        TfLiteXNNPackDelegateDelete(delegate);
+      });
+}
+
 }  // namespace mediapipe
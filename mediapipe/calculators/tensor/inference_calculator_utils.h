@@ -15,7 +15,13 @@
 #ifndef MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_CALCULATOR_UTILS_H_
 #define MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_CALCULATOR_UTILS_H_
 
+#include <memory>
+
 #include "mediapipe/calculators/tensor/inference_calculator.pb.h"
+#include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
+#include "mediapipe/util/tflite/tflite_model_cache.h"
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#include "tensorflow/lite/model.h"
 
 namespace mediapipe {
 
@@ -26,6 +32,16 @@ int GetXnnpackNumThreads(
     const bool opts_has_delegate,
     const mediapipe::InferenceCalculatorOptions::Delegate& opts_delegate);
 
+// Returns an XNNPACK delegate configured with `xnnpack_opts` for interpreters
+// of `model`. If `model` is held by the TfLiteModelCache, the delegate packs
+// weights into the cache shared with the other interpreters of the model. That
+// cache is returned in `weights_cache` and must be passed on to
+// CreateInferenceInterpreterDelegateRunner; otherwise it is set to nullptr.
+TfLiteDelegatePtr CreateXnnpackDelegate(
+    const tflite::FlatBufferModel& model,
+    TfLiteXNNPackDelegateOptions xnnpack_opts,
+    std::shared_ptr<XnnpackWeightsCache>* weights_cache);
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_CALCULATOR_UTILS_H_
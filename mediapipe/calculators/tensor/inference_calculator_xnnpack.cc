@@ -24,6 +24,7 @@
 #include "mediapipe/calculators/tensor/inference_calculator_utils.h"
 #include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
 #include "mediapipe/calculators/tensor/inference_runner.h"
+#include "mediapipe/calculators/tensor/inference_runner_pool.h"
 #include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
 #include "tensorflow/lite/interpreter.h"
 
@@ -43,7 +44,11 @@ class InferenceCalculatorXnnpackImpl
  private:
   absl::StatusOr<std::unique_ptr<InferenceRunner>> CreateInferenceRunner(
       CalculatorContext* cc);
-  absl::StatusOr<TfLiteDelegatePtr> CreateDelegate(CalculatorContext* cc);
+  // Sets `weights_cache` if the returned delegate uses a shared XNNPACK
+  // weights cache.
+  absl::StatusOr<TfLiteDelegatePtr> CreateDelegate(
+      CalculatorContext* cc, const tflite::FlatBufferModel& model,
+      std::shared_ptr<XnnpackWeightsCache>* weights_cache);
 
   std::unique_ptr<InferenceRunner> inference_runner_;
 };
@@ -53,16 +58,28 @@ absl::Status InferenceCalculatorXnnpackImpl::UpdateContract(
   const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
   RET_CHECK(!options.model_path().empty() ^ kSideInModel(cc).IsConnected())
       << "Either model as side packet or model path in options is required.";
+  RET_CHECK_GE(options.max_batch_size(), 1);
+  RET_CHECK_GE(options.num_interpreters(), 1);
+  RET_CHECK(options.max_batch_size() == 1 || options.num_interpreters() == 1)
+      << "max_batch_size and num_interpreters cannot be set together.";
+  cc->SetMaxBatchSize(options.max_batch_size());
 
   return absl::OkStatus();
 }
 
 absl::Status InferenceCalculatorXnnpackImpl::Open(CalculatorContext* cc) {
-  ASSIGN_OR_RETURN(inference_runner_, CreateInferenceRunner(cc));
+  const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
+  ASSIGN_OR_RETURN(inference_runner_,
+                   CreateInferenceRunnerPool(options.num_interpreters(), [&] {
+                     return CreateInferenceRunner(cc);
+                   }));
   return absl::OkStatus();
 }
 
 absl::Status InferenceCalculatorXnnpackImpl::Process(CalculatorContext* cc) {
+  if (cc->BatchSize() > 1) {
+    return RunBatch(cc, inference_runner_.get());
+  }
   if (kInTensors(cc).IsEmpty()) {
     return absl::OkStatus();
   }
@@ -84,16 +101,21 @@ absl::StatusOr<std::unique_ptr<InferenceRunner>>
 InferenceCalculatorXnnpackImpl::CreateInferenceRunner(CalculatorContext* cc) {
   ASSIGN_OR_RETURN(auto model_packet, GetModelAsPacket(cc));
   ASSIGN_OR_RETURN(auto op_resolver_packet, GetOpResolverAsPacket(cc));
-  const int interpreter_num_threads =
-      cc->Options<mediapipe::InferenceCalculatorOptions>().cpu_num_thread();
-  ASSIGN_OR_RETURN(TfLiteDelegatePtr delegate, CreateDelegate(cc));
+  const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
+  std::shared_ptr<XnnpackWeightsCache> weights_cache;
+  ASSIGN_OR_RETURN(TfLiteDelegatePtr delegate,
+                   CreateDelegate(cc, *model_packet.Get(), &weights_cache));
   return CreateInferenceInterpreterDelegateRunner(
       std::move(model_packet), std::move(op_resolver_packet),
-      std::move(delegate), interpreter_num_threads);
+      std::move(delegate), options.cpu_num_thread(),
+      options.zero_copy_cpu_io(), weights_cache.get(),
+      options.max_batch_size());
 }
 
 absl::StatusOr<TfLiteDelegatePtr>
-InferenceCalculatorXnnpackImpl::CreateDelegate(CalculatorContext* cc) {
+InferenceCalculatorXnnpackImpl::CreateDelegate(
+    CalculatorContext* cc, const tflite::FlatBufferModel& model,
+    std::shared_ptr<XnnpackWeightsCache>* weights_cache) {
   const auto& calculator_opts =
       cc->Options<mediapipe::InferenceCalculatorOptions>();
   auto opts_delegate = calculator_opts.delegate();
@@ -116,8 +138,7 @@ InferenceCalculatorXnnpackImpl::CreateDelegate(CalculatorContext* cc) {
       GetXnnpackNumThreads(opts_has_delegate, opts_delegate);
   // TODO Remove once XNNPACK is enabled by default.
   xnnpack_opts.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_QU8;
-  return TfLiteDelegatePtr(TfLiteXNNPackDelegateCreate(&xnnpack_opts),
-                           &TfLiteXNNPackDelegateDelete);
+  return CreateXnnpackDelegate(model, xnnpack_opts, weights_cache);
 }
 
 }  // namespace api2
@@ -14,14 +14,20 @@
 
 #include "mediapipe/calculators/tensor/inference_interpreter_delegate_runner.h"
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/counter.h"
 #include "mediapipe/framework/formats/tensor.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "tensorflow/lite/c/c_api_types.h"
 #include "tensorflow/lite/interpreter.h"
 #include "tensorflow/lite/interpreter_builder.h"
@@ -69,6 +75,56 @@ void CopyTensorBufferFromInterpreter(tflite::Interpreter* interpreter,
               output_tensor->bytes());
 }
 
+// Returns an uninitialized MediaPipe tensor of the given shape with the element
+// type and quantization of `tensor`.
+absl::StatusOr<Tensor> CreateTensorLike(const TfLiteTensor& tensor,
+                                        const Tensor::Shape& shape) {
+  switch (tensor.type) {
+    case TfLiteType::kTfLiteFloat16:
+    case TfLiteType::kTfLiteFloat32:
+      return Tensor(Tensor::ElementType::kFloat32, shape);
+    case TfLiteType::kTfLiteUInt8:
+      return Tensor(Tensor::ElementType::kUInt8, shape,
+                    Tensor::QuantizationParameters{tensor.params.scale,
+                                                   tensor.params.zero_point});
+    case TfLiteType::kTfLiteInt8:
+      return Tensor(Tensor::ElementType::kInt8, shape,
+                    Tensor::QuantizationParameters{tensor.params.scale,
+                                                   tensor.params.zero_point});
+    case TfLiteType::kTfLiteInt32:
+      return Tensor(Tensor::ElementType::kInt32, shape);
+    case TfLiteType::kTfLiteBool:
+      return Tensor(Tensor::ElementType::kBool, shape,
+                    Tensor::QuantizationParameters{1.0f, 0});
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported output tensor type:",
+                       TfLiteTypeGetName(tensor.type)));
+  }
+}
+
+std::vector<int> TensorDims(const TfLiteTensor& tensor) {
+  return std::vector<int>(tensor.dims->data,
+                          tensor.dims->data + tensor.dims->size);
+}
+
+// Returns true if tensors of `type` hold the same bytes as the MediaPipe
+// tensors they are exchanged with. Float16 and string tensors are converted.
+bool IsBytewiseType(TfLiteType type) {
+  return type == kTfLiteFloat32 || type == kTfLiteUInt8 ||
+         type == kTfLiteInt8 || type == kTfLiteInt32;
+}
+
+// Returns true if `tensor` can be backed by a buffer outside of the arena.
+bool IsBindable(const TfLiteTensor& tensor) {
+  return tensor.allocation_type == kTfLiteArenaRw ||
+         tensor.allocation_type == kTfLiteCustom;
+}
+
+bool IsAlignedForBinding(const void* data) {
+  return reinterpret_cast<uintptr_t>(data) % Tensor::kCpuBufferAlignment == 0;
+}
+
 }  // namespace
 
 class InferenceInterpreterDelegateRunner : public InferenceRunner {
@@ -76,61 +132,281 @@ class InferenceInterpreterDelegateRunner : public InferenceRunner {
   InferenceInterpreterDelegateRunner(
       api2::Packet<TfLiteModelPtr> model,
       std::unique_ptr<tflite::Interpreter> interpreter,
-      TfLiteDelegatePtr delegate)
+      TfLiteDelegatePtr delegate, bool zero_copy_cpu_io, int max_batch_size)
       : model_(std::move(model)),
         interpreter_(std::move(interpreter)),
-        delegate_(std::move(delegate)) {}
+        delegate_(std::move(delegate)),
+        zero_copy_cpu_io_(zero_copy_cpu_io),
+        bind_outputs_(zero_copy_cpu_io && delegate_ == nullptr),
+        max_batch_size_(max_batch_size) {
+    for (int index : interpreter_->inputs()) {
+      input_dims_.push_back(TensorDims(*interpreter_->tensor(index)));
+    }
+    for (int index : interpreter_->outputs()) {
+      output_dims_.push_back(TensorDims(*interpreter_->tensor(index)));
+    }
+  }
 
   absl::StatusOr<std::vector<Tensor>> Run(
       CalculatorContext* cc, const std::vector<Tensor>& input_tensors) override;
 
+  absl::StatusOr<std::vector<std::vector<Tensor>>> RunBatch(
+      CalculatorContext* cc,
+      const std::vector<const std::vector<Tensor>*>& batch) override;
+
  private:
+  // Copies `input_tensor` into the interpreter input `input_index`.
+  absl::Status CopyInputToInterpreter(const Tensor& input_tensor,
+                                      int input_index);
+
+  // Returns a copy of the interpreter output `output_index`.
+  absl::StatusOr<Tensor> CopyOutputFromInterpreter(int output_index);
+
+  // Runs inference with the CPU buffers of the input tensors, and of newly
+  // allocated output tensors if bind_outputs_ is set, bound to the
+  // interpreter tensors.
+  absl::StatusOr<std::vector<Tensor>> RunZeroCopy(
+      CalculatorContext* cc, const std::vector<Tensor>& input_tensors);
+
+  // Backs the interpreter tensor `tensor_index` with `data`, which must hold
+  // at least as many bytes as the tensor. Returns true if the binding
+  // changed, in which case the interpreter tensors must be allocated again
+  // before the next invocation.
+  absl::StatusOr<bool> BindBuffer(int tensor_index, const void* data);
+
+  // Binds the interpreter tensors in `tensor_indexes` to their staging
+  // tensors, so that the interpreter does not keep pointers to the buffers of
+  // tensors that are owned, and eventually released, by the caller.
+  absl::Status BindStagingBuffers(const std::vector<int>& tensor_indexes);
+
+  // Adds `bytes` to the kInferenceBytesCopiedCounter of the node.
+  void CountBytesCopied(CalculatorContext* cc, size_t bytes);
+
+  // Increments the kInferenceInvocationsCounter of the node.
+  void CountInvocation(CalculatorContext* cc);
+
+  // Returns a tensor owned by the runner that is bound to the interpreter
+  // tensor `tensor_index` in place of a buffer that is not aligned for
+  // binding, and between invocations. Once bound, an interpreter tensor is no
+  // longer backed by the arena, so it cannot simply go back to being copied.
+  absl::StatusOr<Tensor*> GetStagingTensor(int tensor_index);
+
+  // Returns true if every model input has a leading dimension of 1 and a type
+  // that can be concatenated bytewise.
+  bool ModelAllowsBatching() const;
+
+  // Resizes the leading dimension of the model inputs to `batch_size` times
+  // their original size. Returns false, with the interpreter restored to
+  // batch size 1, if the model does not scale its outputs accordingly.
+  absl::StatusOr<bool> ResizeToBatch(int batch_size);
+
+  // Runs the input sets of `batch` in one invocation of the interpreter
+  // allocated for batch_size_ input sets, padding the unused entries.
+  absl::StatusOr<std::vector<std::vector<Tensor>>> RunPadded(
+      CalculatorContext* cc,
+      const std::vector<const std::vector<Tensor>*>& batch);
+
   api2::Packet<TfLiteModelPtr> model_;
   std::unique_ptr<tflite::Interpreter> interpreter_;
   TfLiteDelegatePtr delegate_;
+  const bool zero_copy_cpu_io_;
+  // Whether zero-copy runs bind the output tensors as well. Delegates may
+  // hold on to output buffers past AllocateTensors(), so outputs are copied
+  // whenever a delegate is applied.
+  const bool bind_outputs_;
+  const int max_batch_size_;
+  absl::flat_hash_map<int, std::unique_ptr<Tensor>> staging_tensors_;
+  // The dimensions of the model inputs and outputs at batch size 1.
+  std::vector<std::vector<int>> input_dims_;
+  std::vector<std::vector<int>> output_dims_;
+  // The batch size the interpreter tensors are currently allocated for:
+  // either 1 or, once a batch has been run, max_batch_size_. Resizing is
+  // costly, so the interpreter then stays at max_batch_size_ and smaller
+  // batches are padded.
+  int batch_size_ = 1;
+  // Cleared once the model fails to resize to a larger batch.
+  bool batching_supported_ = true;
+  // The counters of the node, looked up on first use.
+  Counter* bytes_copied_counter_ = nullptr;
+  Counter* invocations_counter_ = nullptr;
 };
 
+void InferenceInterpreterDelegateRunner::CountBytesCopied(
+    CalculatorContext* cc, size_t bytes) {
+  if (bytes == 0) return;
+  if (bytes_copied_counter_ == nullptr) {
+    bytes_copied_counter_ = cc->GetCounter(kInferenceBytesCopiedCounter);
+  }
+  bytes_copied_counter_->IncrementBy(static_cast<int>(bytes));
+}
+
+void InferenceInterpreterDelegateRunner::CountInvocation(
+    CalculatorContext* cc) {
+  if (invocations_counter_ == nullptr) {
+    invocations_counter_ = cc->GetCounter(kInferenceInvocationsCounter);
+  }
+  invocations_counter_->Increment();
+}
+
+bool InferenceInterpreterDelegateRunner::ModelAllowsBatching() const {
+  for (int i = 0; i < input_dims_.size(); ++i) {
+    if (input_dims_[i].empty() || input_dims_[i][0] != 1 ||
+        !IsBytewiseType(
+            interpreter_->tensor(interpreter_->inputs()[i])->type)) {
+      return false;
+    }
+  }
+  for (int i = 0; i < output_dims_.size(); ++i) {
+    const TfLiteType type =
+        interpreter_->tensor(interpreter_->outputs()[i])->type;
+    if (output_dims_[i].empty() ||
+        !(IsBytewiseType(type) || type == kTfLiteBool)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+absl::StatusOr<bool> InferenceInterpreterDelegateRunner::ResizeToBatch(
+    int batch_size) {
+  if (batch_size == batch_size_) return true;
+  for (int i = 0; i < input_dims_.size(); ++i) {
+    std::vector<int> dims = input_dims_[i];
+    dims[0] *= batch_size;
+    RET_CHECK_EQ(interpreter_->ResizeInputTensor(interpreter_->inputs()[i],
+                                                 dims),
+                 kTfLiteOk);
+  }
+  bool resized = interpreter_->AllocateTensors() == kTfLiteOk;
+  for (int i = 0; resized && i < output_dims_.size(); ++i) {
+    std::vector<int> expected_dims = output_dims_[i];
+    expected_dims[0] *= batch_size;
+    resized = TensorDims(*interpreter_->tensor(interpreter_->outputs()[i])) ==
+              expected_dims;
+  }
+  batch_size_ = batch_size;
+  if (!resized) {
+    RET_CHECK_NE(batch_size, 1) << "Failed to restore the model batch size.";
+    batching_supported_ = false;
+    ASSIGN_OR_RETURN(bool restored, ResizeToBatch(1));
+    RET_CHECK(restored);
+  }
+  return resized;
+}
+
+absl::Status InferenceInterpreterDelegateRunner::CopyInputToInterpreter(
+    const Tensor& input_tensor, int input_index) {
+  const TfLiteType input_tensor_type =
+      interpreter_->tensor(interpreter_->inputs()[input_index])->type;
+  switch (input_tensor_type) {
+    case TfLiteType::kTfLiteFloat16:
+    case TfLiteType::kTfLiteFloat32: {
+      CopyTensorBufferToInterpreter<float>(input_tensor, interpreter_.get(),
+                                           input_index);
+      break;
+    }
+    case TfLiteType::kTfLiteUInt8: {
+      CopyTensorBufferToInterpreter<uint8_t>(input_tensor, interpreter_.get(),
+                                             input_index);
+      break;
+    }
+    case TfLiteType::kTfLiteInt8: {
+      CopyTensorBufferToInterpreter<int8_t>(input_tensor, interpreter_.get(),
+                                            input_index);
+      break;
+    }
+    case TfLiteType::kTfLiteInt32: {
+      CopyTensorBufferToInterpreter<int32_t>(input_tensor, interpreter_.get(),
+                                             input_index);
+      break;
+    }
+    case TfLiteType::kTfLiteString: {
+      CopyTensorBufferToInterpreter<char>(input_tensor, interpreter_.get(),
+                                          input_index);
+      break;
+    }
+    case TfLiteType::kTfLiteBool:
+      // No current use-case for copying MediaPipe Tensors with bool type to
+      // TfLiteTensors.
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported input tensor type:", input_tensor_type));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<Tensor>
+InferenceInterpreterDelegateRunner::CopyOutputFromInterpreter(
+    int output_index) {
+  TfLiteTensor* tensor =
+      interpreter_->tensor(interpreter_->outputs()[output_index]);
+  Tensor::Shape shape{std::vector<int>{
+      tensor->dims->data, tensor->dims->data + tensor->dims->size}};
+  switch (tensor->type) {
+    case TfLiteType::kTfLiteFloat16:
+    case TfLiteType::kTfLiteFloat32: {
+      Tensor output_tensor(Tensor::ElementType::kFloat32, shape);
+      CopyTensorBufferFromInterpreter<float>(interpreter_.get(), output_index,
+                                             &output_tensor);
+      return output_tensor;
+    }
+    case TfLiteType::kTfLiteUInt8: {
+      Tensor output_tensor(
+          Tensor::ElementType::kUInt8, shape,
+          Tensor::QuantizationParameters{tensor->params.scale,
+                                         tensor->params.zero_point});
+      CopyTensorBufferFromInterpreter<uint8>(interpreter_.get(), output_index,
+                                             &output_tensor);
+      return output_tensor;
+    }
+    case TfLiteType::kTfLiteInt8: {
+      Tensor output_tensor(
+          Tensor::ElementType::kInt8, shape,
+          Tensor::QuantizationParameters{tensor->params.scale,
+                                         tensor->params.zero_point});
+      CopyTensorBufferFromInterpreter<int8>(interpreter_.get(), output_index,
+                                            &output_tensor);
+      return output_tensor;
+    }
+    case TfLiteType::kTfLiteInt32: {
+      Tensor output_tensor(Tensor::ElementType::kInt32, shape);
+      CopyTensorBufferFromInterpreter<int32_t>(interpreter_.get(),
+                                               output_index, &output_tensor);
+      return output_tensor;
+    }
+    case TfLiteType::kTfLiteBool: {
+      Tensor output_tensor(Tensor::ElementType::kBool, shape,
+                           Tensor::QuantizationParameters{1.0f, 0});
+      CopyTensorBufferFromInterpreter<bool>(interpreter_.get(), output_index,
+                                            &output_tensor);
+      return output_tensor;
+    }
+    case TfLiteType::kTfLiteString:
+      // No current use-case for copying TfLiteTensors with string type to
+      // MediaPipe Tensors.
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported output tensor type:",
+                       TfLiteTypeGetName(tensor->type)));
+  }
+}
+
 absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
     CalculatorContext* cc, const std::vector<Tensor>& input_tensors) {
-  // Read CPU input into tensors.
   RET_CHECK_EQ(interpreter_->inputs().size(), input_tensors.size());
+  if (batch_size_ > 1) {
+    ASSIGN_OR_RETURN(std::vector<std::vector<Tensor>> outputs,
+                     RunPadded(cc, {&input_tensors}));
+    return std::move(outputs[0]);
+  }
+  if (zero_copy_cpu_io_) {
+    return RunZeroCopy(cc, input_tensors);
+  }
+  // Read CPU input into tensors.
+  size_t bytes_copied = 0;
   for (int i = 0; i < input_tensors.size(); ++i) {
-    const TfLiteType input_tensor_type =
-        interpreter_->tensor(interpreter_->inputs()[i])->type;
-    switch (input_tensor_type) {
-      case TfLiteType::kTfLiteFloat16:
-      case TfLiteType::kTfLiteFloat32: {
-        CopyTensorBufferToInterpreter<float>(input_tensors[i],
-                                             interpreter_.get(), i);
-        break;
-      }
-      case TfLiteType::kTfLiteUInt8: {
-        CopyTensorBufferToInterpreter<uint8_t>(input_tensors[i],
-                                               interpreter_.get(), i);
-        break;
-      }
-      case TfLiteType::kTfLiteInt8: {
-        CopyTensorBufferToInterpreter<int8_t>(input_tensors[i],
-                                              interpreter_.get(), i);
-        break;
-      }
-      case TfLiteType::kTfLiteInt32: {
-        CopyTensorBufferToInterpreter<int32_t>(input_tensors[i],
-                                               interpreter_.get(), i);
-        break;
-      }
-      case TfLiteType::kTfLiteString: {
-        CopyTensorBufferToInterpreter<char>(input_tensors[i],
-                                            interpreter_.get(), i);
-        break;
-      }
-      case TfLiteType::kTfLiteBool:
-        // No current use-case for copying MediaPipe Tensors with bool type to
-        // TfLiteTensors.
-      default:
-        return absl::InvalidArgumentError(
-            absl::StrCat("Unsupported input tensor type:", input_tensor_type));
-    }
+    MP_RETURN_IF_ERROR(CopyInputToInterpreter(input_tensors[i], i));
+    bytes_copied += input_tensors[i].bytes();
   }
 
   // Run inference.
@@ -138,65 +414,251 @@ absl::StatusOr<std::vector<Tensor>> InferenceInterpreterDelegateRunner::Run(
     MEDIAPIPE_PROFILING(CPU_TASK_INVOKE, cc);
     RET_CHECK_EQ(interpreter_->Invoke(), kTfLiteOk);
   }
+  CountInvocation(cc);
   // Output result tensors (CPU).
-  const auto& tensor_indexes = interpreter_->outputs();
+  const int num_outputs = interpreter_->outputs().size();
   std::vector<Tensor> output_tensors;
-  output_tensors.reserve(tensor_indexes.size());
-  for (int i = 0; i < tensor_indexes.size(); ++i) {
-    TfLiteTensor* tensor = interpreter_->tensor(tensor_indexes[i]);
-    Tensor::Shape shape{std::vector<int>{
-        tensor->dims->data, tensor->dims->data + tensor->dims->size}};
-    switch (tensor->type) {
-      case TfLiteType::kTfLiteFloat16:
-      case TfLiteType::kTfLiteFloat32:
-        output_tensors.emplace_back(Tensor::ElementType::kFloat32, shape);
-        CopyTensorBufferFromInterpreter<float>(interpreter_.get(), i,
-                                               &output_tensors.back());
-        break;
-      case TfLiteType::kTfLiteUInt8:
-        output_tensors.emplace_back(
-            Tensor::ElementType::kUInt8, shape,
-            Tensor::QuantizationParameters{tensor->params.scale,
-                                           tensor->params.zero_point});
-        CopyTensorBufferFromInterpreter<uint8>(interpreter_.get(), i,
-                                               &output_tensors.back());
-        break;
-      case TfLiteType::kTfLiteInt8:
-        output_tensors.emplace_back(
-            Tensor::ElementType::kInt8, shape,
-            Tensor::QuantizationParameters{tensor->params.scale,
-                                           tensor->params.zero_point});
-        CopyTensorBufferFromInterpreter<int8>(interpreter_.get(), i,
-                                              &output_tensors.back());
-        break;
-      case TfLiteType::kTfLiteInt32:
-        output_tensors.emplace_back(Tensor::ElementType::kInt32, shape);
-        CopyTensorBufferFromInterpreter<int32_t>(interpreter_.get(), i,
-                                                 &output_tensors.back());
-        break;
-      case TfLiteType::kTfLiteBool:
-        output_tensors.emplace_back(Tensor::ElementType::kBool, shape,
-                                    Tensor::QuantizationParameters{1.0f, 0});
-        CopyTensorBufferFromInterpreter<bool>(interpreter_.get(), i,
-                                              &output_tensors.back());
-        break;
-      case TfLiteType::kTfLiteString:
-        // No current use-case for copying TfLiteTensors with string type to
-        // MediaPipe Tensors.
-      default:
-        return absl::InvalidArgumentError(
-            absl::StrCat("Unsupported output tensor type:",
-                         TfLiteTypeGetName(tensor->type)));
+  output_tensors.reserve(num_outputs);
+  for (int i = 0; i < num_outputs; ++i) {
+    ASSIGN_OR_RETURN(Tensor output_tensor, CopyOutputFromInterpreter(i));
+    bytes_copied += output_tensor.bytes();
+    output_tensors.push_back(std::move(output_tensor));
+  }
+  CountBytesCopied(cc, bytes_copied);
+  return output_tensors;
+}
+
+absl::StatusOr<std::vector<Tensor>>
+InferenceInterpreterDelegateRunner::RunZeroCopy(
+    CalculatorContext* cc, const std::vector<Tensor>& input_tensors) {
+  size_t bytes_copied = 0;
+  bool needs_allocation = false;
+  // The interpreter tensors bound to buffers of the caller's tensors.
+  std::vector<int> caller_bound_indexes;
+  // The views keep the bound buffers mapped until inference is done.
+  std::vector<Tensor::CpuReadView> input_views;
+  input_views.reserve(input_tensors.size());
+  for (int i = 0; i < input_tensors.size(); ++i) {
+    const int tensor_index = interpreter_->inputs()[i];
+    const TfLiteTensor& tensor = *interpreter_->tensor(tensor_index);
+    if (!IsBytewiseType(tensor.type) || !IsBindable(tensor)) {
+      MP_RETURN_IF_ERROR(CopyInputToInterpreter(input_tensors[i], i));
+      bytes_copied += input_tensors[i].bytes();
+      continue;
     }
+    RET_CHECK_EQ(input_tensors[i].bytes(), tensor.bytes)
+        << "Input tensor " << i << " does not match the model input size.";
+    input_views.push_back(input_tensors[i].GetCpuReadView());
+    if (!IsAlignedForBinding(input_views.back().buffer<void>())) {
+      ASSIGN_OR_RETURN(Tensor * staging, GetStagingTensor(tensor_index));
+      std::memcpy(staging->GetCpuWriteView().buffer<void>(),
+                  input_views.back().buffer<void>(), tensor.bytes);
+      bytes_copied += tensor.bytes;
+      input_views.pop_back();
+      input_views.push_back(staging->GetCpuReadView());
+    } else {
+      caller_bound_indexes.push_back(tensor_index);
+    }
+    ASSIGN_OR_RETURN(
+        bool rebound,
+        BindBuffer(tensor_index, input_views.back().buffer<void>()));
+    needs_allocation |= rebound;
   }
+
+  // Outputs that can be bound are written by the interpreter directly into
+  // newly allocated tensors, the others are copied after inference.
+  const auto& output_indexes = interpreter_->outputs();
+  std::vector<absl::optional<Tensor>> bound_outputs(output_indexes.size());
+  std::vector<Tensor*> staged_outputs(output_indexes.size(), nullptr);
+  std::vector<Tensor::CpuWriteView> output_views;
+  output_views.reserve(output_indexes.size());
+  for (int i = 0; i < output_indexes.size(); ++i) {
+    const int tensor_index = output_indexes[i];
+    const TfLiteTensor& tensor = *interpreter_->tensor(tensor_index);
+    if (!bind_outputs_ ||
+        !(IsBytewiseType(tensor.type) || tensor.type == kTfLiteBool) ||
+        !IsBindable(tensor)) {
+      continue;
+    }
+    ASSIGN_OR_RETURN(Tensor output,
+                     CreateTensorLike(tensor, TensorDims(tensor)));
+    bound_outputs[i] = std::move(output);
+    output_views.push_back(bound_outputs[i]->GetCpuWriteView());
+    if (!IsAlignedForBinding(output_views.back().buffer<void>())) {
+      ASSIGN_OR_RETURN(staged_outputs[i], GetStagingTensor(tensor_index));
+      output_views.pop_back();
+      output_views.push_back(staged_outputs[i]->GetCpuWriteView());
+    } else {
+      caller_bound_indexes.push_back(tensor_index);
+    }
+    ASSIGN_OR_RETURN(
+        bool rebound,
+        BindBuffer(tensor_index, output_views.back().buffer<void>()));
+    needs_allocation |= rebound;
+  }
+  // TFLite requires AllocateTensors() after any change to the custom
+  // allocations. With the plan unchanged, it only validates the new buffers.
+  if (needs_allocation) {
+    RET_CHECK_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+  }
+
+  // Run inference.
+  TfLiteStatus invoke_status;
+  {
+    MEDIAPIPE_PROFILING(CPU_TASK_INVOKE, cc);
+    invoke_status = interpreter_->Invoke();
+  }
+  MP_RETURN_IF_ERROR(BindStagingBuffers(caller_bound_indexes));
+  RET_CHECK_EQ(invoke_status, kTfLiteOk);
+  CountInvocation(cc);
+  input_views.clear();
+  output_views.clear();
+
+  std::vector<Tensor> output_tensors;
+  output_tensors.reserve(output_indexes.size());
+  for (int i = 0; i < output_indexes.size(); ++i) {
+    if (!bound_outputs[i]) {
+      ASSIGN_OR_RETURN(Tensor output_tensor, CopyOutputFromInterpreter(i));
+      bytes_copied += output_tensor.bytes();
+      output_tensors.push_back(std::move(output_tensor));
+      continue;
+    }
+    if (staged_outputs[i]) {
+      std::memcpy(bound_outputs[i]->GetCpuWriteView().buffer<void>(),
+                  staged_outputs[i]->GetCpuReadView().buffer<void>(),
+                  bound_outputs[i]->bytes());
+      bytes_copied += bound_outputs[i]->bytes();
+    }
+    output_tensors.push_back(*std::move(bound_outputs[i]));
+  }
+  CountBytesCopied(cc, bytes_copied);
   return output_tensors;
 }
 
+absl::StatusOr<bool> InferenceInterpreterDelegateRunner::BindBuffer(
+    int tensor_index, const void* data) {
+  const TfLiteTensor* tensor = interpreter_->tensor(tensor_index);
+  const bool was_bound = tensor->allocation_type == kTfLiteCustom;
+  if (was_bound && tensor->data.raw_const == data) {
+    return false;
+  }
+  // The interpreter does not write to its inputs, so read-only input buffers
+  // can be bound as well.
+  TfLiteCustomAllocation allocation{const_cast<void*>(data), tensor->bytes};
+  RET_CHECK_EQ(
+      interpreter_->SetCustomAllocationForTensor(tensor_index, allocation),
+      kTfLiteOk);
+  return true;
+}
+
+absl::Status InferenceInterpreterDelegateRunner::BindStagingBuffers(
+    const std::vector<int>& tensor_indexes) {
+  for (int tensor_index : tensor_indexes) {
+    ASSIGN_OR_RETURN(Tensor * staging, GetStagingTensor(tensor_index));
+    MP_RETURN_IF_ERROR(
+        BindBuffer(tensor_index, staging->GetCpuWriteView().buffer<void>())
+            .status());
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<Tensor*> InferenceInterpreterDelegateRunner::GetStagingTensor(
+    int tensor_index) {
+  std::unique_ptr<Tensor>& staging = staging_tensors_[tensor_index];
+  if (!staging) {
+    const TfLiteTensor& tensor = *interpreter_->tensor(tensor_index);
+    ASSIGN_OR_RETURN(Tensor staging_tensor,
+                     CreateTensorLike(tensor, TensorDims(tensor)));
+    staging = std::make_unique<Tensor>(std::move(staging_tensor));
+  }
+  return staging.get();
+}
+
+absl::StatusOr<std::vector<std::vector<Tensor>>>
+InferenceInterpreterDelegateRunner::RunBatch(
+    CalculatorContext* cc,
+    const std::vector<const std::vector<Tensor>*>& batch) {
+  const int batch_size = batch.size();
+  RET_CHECK_LE(batch_size, max_batch_size_);
+  if (batch_size_ > 1) {
+    return RunPadded(cc, batch);
+  }
+  // Bound buffers hold the tensors of a single input set, so zero-copy runs
+  // are not batched.
+  if (batch_size == 1 || zero_copy_cpu_io_ || !batching_supported_ ||
+      !ModelAllowsBatching()) {
+    return InferenceRunner::RunBatch(cc, batch);
+  }
+  ASSIGN_OR_RETURN(bool resized, ResizeToBatch(max_batch_size_));
+  if (!resized) {
+    return InferenceRunner::RunBatch(cc, batch);
+  }
+  return RunPadded(cc, batch);
+}
+
+absl::StatusOr<std::vector<std::vector<Tensor>>>
+InferenceInterpreterDelegateRunner::RunPadded(
+    CalculatorContext* cc,
+    const std::vector<const std::vector<Tensor>*>& batch) {
+  const int batch_size = batch.size();
+  RET_CHECK_LE(batch_size, batch_size_);
+
+  // Concatenate the input sets along the leading dimension, and zero the
+  // entries past the end of the batch.
+  size_t bytes_copied = 0;
+  for (int i = 0; i < input_dims_.size(); ++i) {
+    TfLiteTensor* tensor = interpreter_->tensor(interpreter_->inputs()[i]);
+    const size_t item_bytes = tensor->bytes / batch_size_;
+    for (int b = 0; b < batch_size; ++b) {
+      const std::vector<Tensor>& input_tensors = *batch[b];
+      RET_CHECK_EQ(input_tensors.size(), input_dims_.size());
+      RET_CHECK_EQ(input_tensors[i].bytes(), item_bytes)
+          << "Input tensor " << i << " of batch entry " << b
+          << " does not match the model input size.";
+      std::memcpy(tensor->data.raw + b * item_bytes,
+                  input_tensors[i].GetCpuReadView().buffer<char>(),
+                  item_bytes);
+    }
+    std::memset(tensor->data.raw + batch_size * item_bytes, 0,
+                (batch_size_ - batch_size) * item_bytes);
+    bytes_copied += batch_size * item_bytes;
+  }
+
+  // Run inference.
+  {
+    MEDIAPIPE_PROFILING(CPU_TASK_INVOKE, cc);
+    RET_CHECK_EQ(interpreter_->Invoke(), kTfLiteOk);
+  }
+  CountInvocation(cc);
+
+  // Split the outputs back into one tensor vector per input set.
+  std::vector<std::vector<Tensor>> outputs(batch_size);
+  for (auto& output_tensors : outputs) {
+    output_tensors.reserve(output_dims_.size());
+  }
+  for (int i = 0; i < output_dims_.size(); ++i) {
+    const TfLiteTensor* tensor =
+        interpreter_->tensor(interpreter_->outputs()[i]);
+    const size_t item_bytes = tensor->bytes / batch_size_;
+    for (int b = 0; b < batch_size; ++b) {
+      ASSIGN_OR_RETURN(Tensor output,
+                       CreateTensorLike(*tensor, Tensor::Shape(output_dims_[i])));
+      std::memcpy(output.GetCpuWriteView().buffer<char>(),
+                  tensor->data.raw_const + b * item_bytes, item_bytes);
+      outputs[b].push_back(std::move(output));
+    }
+    bytes_copied += batch_size * item_bytes;
+  }
+  CountBytesCopied(cc, bytes_copied);
+  return outputs;
+}
+
 absl::StatusOr<std::unique_ptr<InferenceRunner>>
 CreateInferenceInterpreterDelegateRunner(
     api2::Packet<TfLiteModelPtr> model,
     api2::Packet<tflite::OpResolver> op_resolver, TfLiteDelegatePtr delegate,
-    int interpreter_num_threads) {
+    int interpreter_num_threads, bool zero_copy_cpu_io,
+    XnnpackWeightsCache* weights_cache, int max_batch_size) {
   tflite::InterpreterBuilder interpreter_builder(*model.Get(),
                                                  op_resolver.Get());
   if (delegate) {
@@ -208,11 +670,20 @@ CreateInferenceInterpreterDelegateRunner(
   interpreter_builder.SetNumThreads(interpreter_num_threads);
 #endif  // __EMSCRIPTEN__
   std::unique_ptr<tflite::Interpreter> interpreter;
-  RET_CHECK_EQ(interpreter_builder(&interpreter), kTfLiteOk);
-  RET_CHECK(interpreter);
-  RET_CHECK_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  auto build_interpreter = [&]() -> absl::Status {
+    RET_CHECK_EQ(interpreter_builder(&interpreter), kTfLiteOk);
+    RET_CHECK(interpreter);
+    RET_CHECK_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    return absl::OkStatus();
+  };
+  if (weights_cache) {
+    MP_RETURN_IF_ERROR(weights_cache->Populate(build_interpreter));
+  } else {
+    MP_RETURN_IF_ERROR(build_interpreter());
+  }
   return std::make_unique<InferenceInterpreterDelegateRunner>(
-      std::move(model), std::move(interpreter), std::move(delegate));
+      std::move(model), std::move(interpreter), std::move(delegate),
+      zero_copy_cpu_io, max_batch_size);
 }
 
 }  // namespace mediapipe
@@ -21,6 +21,7 @@
 #include "absl/status/statusor.h"
 #include "mediapipe/calculators/tensor/inference_runner.h"
 #include "mediapipe/framework/api2/packet.h"
+#include "mediapipe/util/tflite/tflite_model_cache.h"
 #include "mediapipe/util/tflite/tflite_model_loader.h"
 #include "tensorflow/lite/core/api/op_resolver.h"
 #include "tensorflow/lite/interpreter.h"
@@ -30,16 +31,41 @@ namespace mediapipe {
 using TfLiteDelegatePtr =
     std::unique_ptr<TfLiteDelegate, std::function<void(TfLiteDelegate*)>>;
 
+// Name of the calculator counter that accumulates the number of bytes the
+// runner copies between MediaPipe tensors and interpreter tensors. Like all
+// calculator counters, it is registered as "<node name>-InferenceBytesCopied"
+// in the graph's CounterFactory.
+inline constexpr char kInferenceBytesCopiedCounter[] = "InferenceBytesCopied";
+
+// Name of the calculator counter that accumulates the number of interpreter
+// invocations. Several input sets share an invocation when they are batched.
+inline constexpr char kInferenceInvocationsCounter[] = "InferenceInvocations";
+
 // Creates inference runner which run inference using newly initialized
 // interpreter and provided `delegate`.
 //
 // `delegate` can be nullptr, in that case newly initialized interpreter will
 // use what is available by default.
+//
+// If `zero_copy_cpu_io` is true, the CPU buffers of input and output tensors
+// are bound to the interpreter tensors as custom allocations instead of being
+// copied, wherever their layout allows it. Output tensors are still copied if
+// `delegate` is set. Between runs, the interpreter tensors are bound to
+// buffers owned by the runner.
+//
+// `weights_cache` must be set if `delegate` is an XNNPACK delegate that uses
+// it, so that the cache is populated and finalized along with the interpreter.
+//
+// `max_batch_size` is the largest number of input sets passed to RunBatch().
+// Once a batch of more than one input set has run, the interpreter stays
+// allocated for `max_batch_size` input sets, and smaller batches are padded,
+// so that batches of varying size do not reallocate the interpreter tensors.
 absl::StatusOr<std::unique_ptr<InferenceRunner>>
 CreateInferenceInterpreterDelegateRunner(
     api2::Packet<TfLiteModelPtr> model,
     api2::Packet<tflite::OpResolver> op_resolver, TfLiteDelegatePtr delegate,
-    int interpreter_num_threads);
+    int interpreter_num_threads, bool zero_copy_cpu_io = false,
+    XnnpackWeightsCache* weights_cache = nullptr, int max_batch_size = 1);
 
 }  // namespace mediapipe
 
@@ -1,6 +1,9 @@
 #ifndef MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_RUNNER_H_
 #define MEDIAPIPE_CALCULATORS_TENSOR_INFERENCE_RUNNER_H_
 
+#include <utility>
+#include <vector>
+
 #include "absl/status/statusor.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/formats/tensor.h"
@@ -13,6 +16,22 @@ class InferenceRunner {
   virtual ~InferenceRunner() = default;
   virtual absl::StatusOr<std::vector<Tensor>> Run(
       CalculatorContext* cc, const std::vector<Tensor>& inputs) = 0;
+
+  // Runs inference on several input sets and returns the outputs of each
+  // input set, in order. Runners that can fold the input sets into a single
+  // invocation override this; the default calls Run() once per input set.
+  virtual absl::StatusOr<std::vector<std::vector<Tensor>>> RunBatch(
+      CalculatorContext* cc,
+      const std::vector<const std::vector<Tensor>*>& batch) {
+    std::vector<std::vector<Tensor>> outputs;
+    outputs.reserve(batch.size());
+    for (const std::vector<Tensor>* inputs : batch) {
+      absl::StatusOr<std::vector<Tensor>> result = Run(cc, *inputs);
+      if (!result.ok()) return result.status();
+      outputs.push_back(*std::move(result));
+    }
+    return outputs;
+  }
 };
 
 }  // namespace mediapipe
@@ -0,0 +1,98 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/inference_runner_pool.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+namespace {
+
+class InferenceRunnerPool : public InferenceRunner {
+ public:
+  explicit InferenceRunnerPool(
+      std::vector<std::unique_ptr<InferenceRunner>> runners)
+      : runners_(std::move(runners)) {
+    for (const auto& runner : runners_) {
+      idle_runners_.push_back(runner.get());
+    }
+  }
+
+  absl::StatusOr<std::vector<Tensor>> Run(
+      CalculatorContext* cc, const std::vector<Tensor>& inputs) override {
+    InferenceRunner* runner = Acquire();
+    auto result = runner->Run(cc, inputs);
+    Release(runner);
+    return result;
+  }
+
+  absl::StatusOr<std::vector<std::vector<Tensor>>> RunBatch(
+      CalculatorContext* cc,
+      const std::vector<const std::vector<Tensor>*>& batch) override {
+    InferenceRunner* runner = Acquire();
+    auto result = runner->RunBatch(cc, batch);
+    Release(runner);
+    return result;
+  }
+
+ private:
+  // Waits for an idle runner and marks it busy.
+  InferenceRunner* Acquire() {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(
+        +[](std::vector<InferenceRunner*>* idle_runners) {
+          return !idle_runners->empty();
+        },
+        &idle_runners_));
+    InferenceRunner* runner = idle_runners_.back();
+    idle_runners_.pop_back();
+    return runner;
+  }
+
+  void Release(InferenceRunner* runner) {
+    absl::MutexLock lock(&mutex_);
+    idle_runners_.push_back(runner);
+  }
+
+  const std::vector<std::unique_ptr<InferenceRunner>> runners_;
+  absl::Mutex mutex_;
+  std::vector<InferenceRunner*> idle_runners_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<InferenceRunner>> CreateInferenceRunnerPool(
+    int num_runners,
+    absl::FunctionRef<absl::StatusOr<std::unique_ptr<InferenceRunner>>()>
+        create_runner) {
+  RET_CHECK_GE(num_runners, 1);
+  if (num_runners == 1) return create_runner();
+  std::vector<std::unique_ptr<InferenceRunner>> runners;
+  runners.reserve(num_runners);
+  for (int i = 0; i < num_runners; ++i) {
+    ASSIGN_OR_RETURN(std::unique_ptr<InferenceRunner> runner, create_runner());
+    runners.push_back(std::move(runner));
+  }
+  return std::make_unique<InferenceRunnerPool>(std::move(runners));
+}
+
+}  // namespace mediapipe
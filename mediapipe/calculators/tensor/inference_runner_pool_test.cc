@@ -0,0 +1,91 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/calculators/tensor/inference_runner_pool.h"
+
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+// Returns from Run() only once `started` has been decremented by as many
+// calls as it was created with.
+class WaitingRunner : public InferenceRunner {
+ public:
+  explicit WaitingRunner(absl::BlockingCounter* started) : started_(started) {}
+
+  absl::StatusOr<std::vector<Tensor>> Run(
+      CalculatorContext* cc, const std::vector<Tensor>& inputs) override {
+    started_->DecrementCount();
+    started_->Wait();
+    return std::vector<Tensor>();
+  }
+
+ private:
+  absl::BlockingCounter* started_;
+};
+
+TEST(InferenceRunnerPoolTest, RunsCallsConcurrently) {
+  constexpr int kNumRunners = 3;
+  absl::BlockingCounter started(kNumRunners);
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto pool, CreateInferenceRunnerPool(
+                     kNumRunners,
+                     [&]() -> absl::StatusOr<std::unique_ptr<InferenceRunner>> {
+                       return std::make_unique<WaitingRunner>(&started);
+                     }));
+  // Completes only if every call gets a runner of its own.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumRunners; ++i) {
+    threads.emplace_back([&pool] { MP_EXPECT_OK(pool->Run(nullptr, {})); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(InferenceRunnerPoolTest, ReturnsSingleRunner) {
+  absl::BlockingCounter started(1);
+  InferenceRunner* created = nullptr;
+  MP_ASSERT_OK_AND_ASSIGN(
+      auto runner,
+      CreateInferenceRunnerPool(
+          1, [&]() -> absl::StatusOr<std::unique_ptr<InferenceRunner>> {
+            auto runner = std::make_unique<WaitingRunner>(&started);
+            created = runner.get();
+            return runner;
+          }));
+  EXPECT_EQ(runner.get(), created);
+}
+
+TEST(InferenceRunnerPoolTest, FailsIfRunnerCreationFails) {
+  EXPECT_FALSE(
+      CreateInferenceRunnerPool(
+          2,
+          []() -> absl::StatusOr<std::unique_ptr<InferenceRunner>> {
+            return absl::InternalError("no runner");
+          })
+          .ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -51,6 +51,25 @@ enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
 // Round up n to next multiple of m.
 size_t RoundUp(size_t n, size_t m) { return ((n + m - 1) / m) * m; }  // NOLINT
 
+// Row alignment of the ImageFrames produced on the CPU output.
+#if !MEDIAPIPE_DISABLE_GPU
+constexpr uint32 kOutputAlignmentBoundary =
+    ImageFrame::kGlDefaultAlignmentBoundary;
+#else
+constexpr uint32 kOutputAlignmentBoundary =
+    ImageFrame::kDefaultAlignmentBoundary;
+#endif  // !MEDIAPIPE_DISABLE_GPU
+
+// Returns true if |frame| has the row layout of an ImageFrame allocated with
+// kOutputAlignmentBoundary, i.e. aligned rows without any extra padding.
+bool HasOutputAlignment(const ImageFrame& frame) {
+  const size_t row_size =
+      frame.Width() * frame.NumberOfChannels() * frame.ByteDepth();
+  return frame.IsAligned(kOutputAlignmentBoundary) &&
+         static_cast<size_t>(frame.WidthStep()) ==
+             RoundUp(row_size, kOutputAlignmentBoundary);
+}
+
 // When using GPU, this color will become transparent when the calculator
 // merges the annotation overlay with the image frame. As a result, drawing in
 // this color is not supported and it should be set to something unlikely used.
@@ -132,9 +151,10 @@ class AnnotationOverlayCalculator : public CalculatorBase {
   absl::Status Close(CalculatorContext* cc) override;
 
  private:
-  absl::Status CreateRenderTargetCpu(CalculatorContext* cc,
-                                     std::unique_ptr<cv::Mat>& image_mat,
-                                     ImageFormat::Format* target_format);
+  absl::Status CreateRenderTargetCpu(
+      CalculatorContext* cc, std::unique_ptr<cv::Mat>& image_mat,
+      ImageFormat::Format* target_format,
+      std::unique_ptr<ImageFrame>* render_frame);
   template <typename Type, const char* Tag>
   absl::Status CreateRenderTargetGpu(CalculatorContext* cc,
                                      std::unique_ptr<cv::Mat>& image_mat);
@@ -142,7 +162,8 @@ class AnnotationOverlayCalculator : public CalculatorBase {
   absl::Status RenderToGpu(CalculatorContext* cc, uchar* overlay_image);
   absl::Status RenderToCpu(CalculatorContext* cc,
                            const ImageFormat::Format& target_format,
-                           uchar* data_image);
+                           uchar* data_image,
+                           std::unique_ptr<ImageFrame> render_frame);
 
   absl::Status GlRender(CalculatorContext* cc);
   template <typename Type, const char* Tag>
@@ -284,6 +305,8 @@ absl::Status AnnotationOverlayCalculator::Process(CalculatorContext* cc) {
   // Initialize render target, drawn with OpenCV.
   std::unique_ptr<cv::Mat> image_mat;
   ImageFormat::Format target_format;
+  // The input frame taken over as the CPU render target, if any.
+  std::unique_ptr<ImageFrame> render_frame;
   if (use_gpu_) {
 #if !MEDIAPIPE_DISABLE_GPU
     if (!gpu_initialized_) {
@@ -301,7 +324,8 @@ absl::Status AnnotationOverlayCalculator::Process(CalculatorContext* cc) {
 #endif  // !MEDIAPIPE_DISABLE_GPU
   } else {
     if (cc->Outputs().HasTag(kImageFrameTag)) {
-      MP_RETURN_IF_ERROR(CreateRenderTargetCpu(cc, image_mat, &target_format));
+      MP_RETURN_IF_ERROR(CreateRenderTargetCpu(cc, image_mat, &target_format,
+                                               &render_frame));
     }
   }
 
@@ -346,7 +370,8 @@ absl::Status AnnotationOverlayCalculator::Process(CalculatorContext* cc) {
   } else {
     // Copy the rendered image to output.
     uchar* image_mat_ptr = image_mat->data;
-    MP_RETURN_IF_ERROR(RenderToCpu(cc, target_format, image_mat_ptr));
+    MP_RETURN_IF_ERROR(RenderToCpu(cc, target_format, image_mat_ptr,
+                                   std::move(render_frame)));
   }
 
   return absl::OkStatus();
@@ -367,19 +392,23 @@ absl::Status AnnotationOverlayCalculator::Close(CalculatorContext* cc) {
 
 absl::Status AnnotationOverlayCalculator::RenderToCpu(
     CalculatorContext* cc, const ImageFormat::Format& target_format,
-    uchar* data_image) {
+    uchar* data_image, std::unique_ptr<ImageFrame> render_frame) {
+  if (render_frame) {
+    // The annotations were drawn directly on the output frame.
+    if (cc->Outputs().HasTag(kImageFrameTag)) {
+      cc->Outputs()
+          .Tag(kImageFrameTag)
+          .Add(render_frame.release(), cc->InputTimestamp());
+    }
+    return absl::OkStatus();
+  }
+
   auto output_frame = absl::make_unique<ImageFrame>(
       target_format, renderer_->GetImageWidth(), renderer_->GetImageHeight());
 
-#if !MEDIAPIPE_DISABLE_GPU
   output_frame->CopyPixelData(target_format, renderer_->GetImageWidth(),
                               renderer_->GetImageHeight(), data_image,
-                              ImageFrame::kGlDefaultAlignmentBoundary);
-#else
-  output_frame->CopyPixelData(target_format, renderer_->GetImageWidth(),
-                              renderer_->GetImageHeight(), data_image,
-                              ImageFrame::kDefaultAlignmentBoundary);
-#endif  // !MEDIAPIPE_DISABLE_GPU
+                              kOutputAlignmentBoundary);
 
   if (cc->Outputs().HasTag(kImageFrameTag)) {
     cc->Outputs()
@@ -441,10 +470,29 @@ absl::Status AnnotationOverlayCalculator::RenderToGpu(CalculatorContext* cc,
 
 absl::Status AnnotationOverlayCalculator::CreateRenderTargetCpu(
     CalculatorContext* cc, std::unique_ptr<cv::Mat>& image_mat,
-    ImageFormat::Format* target_format) {
+    ImageFormat::Format* target_format,
+    std::unique_ptr<ImageFrame>* render_frame) {
   if (image_frame_available_) {
-    const auto& input_frame =
-        cc->Inputs().Tag(kImageFrameTag).Get<ImageFrame>();
+    Packet& input_packet = cc->Inputs().Tag(kImageFrameTag).Value();
+    const auto& input_frame = input_packet.Get<ImageFrame>();
+    if ((input_frame.Format() == ImageFormat::SRGBA ||
+         input_frame.Format() == ImageFormat::SRGB) &&
+        HasOutputAlignment(input_frame)) {
+      // Draw directly on the input frame if this calculator holds its only
+      // reference, and on a single copy of it otherwise.
+      *target_format = input_frame.Format();
+      ASSIGN_OR_RETURN(*render_frame, input_packet.ConsumeOrCopy<ImageFrame>());
+      if (!HasOutputAlignment(**render_frame)) {
+        // ConsumeOrCopy copies with kDefaultAlignmentBoundary, which GPU
+        // builds do not use for their output frames.
+        auto aligned_frame = absl::make_unique<ImageFrame>();
+        aligned_frame->CopyFrom(**render_frame, kOutputAlignmentBoundary);
+        *render_frame = std::move(aligned_frame);
+      }
+      image_mat = absl::make_unique<cv::Mat>(
+          formats::MatView(render_frame->get()));
+      return absl::OkStatus();
+    }
 
     int target_mat_type;
     switch (input_frame.Format()) {
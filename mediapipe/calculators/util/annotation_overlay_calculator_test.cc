@@ -0,0 +1,170 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/render_data.pb.h"
+
+namespace mediapipe {
+
+namespace {
+
+constexpr int kWidth = 8;
+constexpr int kHeight = 4;
+
+// The row alignment of the ImageFrames the calculator outputs.
+#if !MEDIAPIPE_DISABLE_GPU
+constexpr uint32 kOutputAlignmentBoundary =
+    ImageFrame::kGlDefaultAlignmentBoundary;
+#else
+constexpr uint32 kOutputAlignmentBoundary =
+    ImageFrame::kDefaultAlignmentBoundary;
+#endif  // !MEDIAPIPE_DISABLE_GPU
+
+// Returns a black SRGB frame with rows aligned to |alignment_boundary|.
+std::unique_ptr<ImageFrame> MakeBlackFrame(int width,
+                                           uint32 alignment_boundary) {
+  auto frame = absl::make_unique<ImageFrame>(ImageFormat::SRGB, width, kHeight,
+                                             alignment_boundary);
+  frame->SetToZero();
+  return frame;
+}
+
+// Returns render data that fills the left half of the image in red.
+RenderData FillLeftHalfRed() {
+  return ParseTextProtoOrDie<RenderData>(R"pb(
+    render_annotations {
+      color { r: 255 g: 0 b: 0 }
+      filled_rectangle {
+        rectangle { left: 0 top: 0 right: 3 bottom: 3 }
+      }
+    }
+  )pb");
+}
+
+// Returns the RGB value of the pixel at (|x|, |y|) in |frame|.
+std::vector<int> PixelAt(const ImageFrame& frame, int x, int y) {
+  const uint8* pixel = frame.PixelData() + y * frame.WidthStep() + x * 3;
+  return {pixel[0], pixel[1], pixel[2]};
+}
+
+// Renders FillLeftHalfRed() on |input| with an AnnotationOverlayCalculator,
+// and stores the resulting packet in |output|.
+void RenderOverlay(Packet input, Packet* output) {
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "input_image"
+    input_stream: "render_data"
+    node {
+      calculator: "AnnotationOverlayCalculator"
+      input_stream: "IMAGE:input_image"
+      input_stream: "render_data"
+      output_stream: "IMAGE:output_image"
+    }
+  )pb")));
+  std::vector<Packet> output_packets;
+  MP_ASSERT_OK(graph.ObserveOutputStream(
+      "output_image", [&output_packets](const Packet& packet) {
+        output_packets.push_back(packet);
+        return absl::OkStatus();
+      }));
+  MP_ASSERT_OK(graph.StartRun({}));
+  const Timestamp timestamp = input.Timestamp();
+  MP_ASSERT_OK(graph.AddPacketToInputStream("input_image", std::move(input)));
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "render_data", MakePacket<RenderData>(FillLeftHalfRed()).At(timestamp)));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(output_packets.size(), 1);
+  *output = output_packets[0];
+}
+
+// Expects the left half of |frame| to be red and the right half black.
+void ExpectLeftHalfRed(const ImageFrame& frame) {
+  EXPECT_EQ(PixelAt(frame, 1, 1), std::vector<int>({255, 0, 0}));
+  EXPECT_EQ(PixelAt(frame, kWidth - 1, 1), std::vector<int>({0, 0, 0}));
+}
+
+TEST(AnnotationOverlayCalculatorTest, DrawsOnSoleOwnedFrameInPlace) {
+  auto frame = MakeBlackFrame(kWidth, kOutputAlignmentBoundary);
+  const uint8* pixel_data = frame->PixelData();
+  const PacketConsumeStats before = GetPacketConsumeStats();
+
+  Packet output;
+  RenderOverlay(Adopt(frame.release()).At(Timestamp(0)), &output);
+
+  const PacketConsumeStats after = GetPacketConsumeStats();
+  EXPECT_EQ(after.consumed - before.consumed, 1);
+  EXPECT_EQ(after.copied - before.copied, 0);
+  const auto& output_frame = output.Get<ImageFrame>();
+  EXPECT_EQ(output_frame.PixelData(), pixel_data);
+  ExpectLeftHalfRed(output_frame);
+}
+
+TEST(AnnotationOverlayCalculatorTest, DrawsOnCopyOfSharedFrame) {
+  Packet input =
+      Adopt(MakeBlackFrame(kWidth, kOutputAlignmentBoundary).release())
+          .At(Timestamp(0));
+  const PacketConsumeStats before = GetPacketConsumeStats();
+
+  Packet output;
+  RenderOverlay(input, &output);
+
+  const PacketConsumeStats after = GetPacketConsumeStats();
+  EXPECT_EQ(after.consumed - before.consumed, 0);
+  EXPECT_EQ(after.copied - before.copied, 1);
+  const auto& output_frame = output.Get<ImageFrame>();
+  EXPECT_NE(output_frame.PixelData(), input.Get<ImageFrame>().PixelData());
+  EXPECT_TRUE(output_frame.IsAligned(kOutputAlignmentBoundary));
+  ExpectLeftHalfRed(output_frame);
+  // The frame still held by the test is left untouched.
+  EXPECT_EQ(PixelAt(input.Get<ImageFrame>(), 1, 1),
+            std::vector<int>({0, 0, 0}));
+}
+
+TEST(AnnotationOverlayCalculatorTest, KeepsOutputAlignmentOfUnalignedFrame) {
+  // A contiguous 5 pixel wide SRGB frame has 15 byte rows, which no output
+  // alignment boundary allows, so the calculator must not draw on it in place.
+  constexpr int kUnalignedWidth = 5;
+  const PacketConsumeStats before = GetPacketConsumeStats();
+
+  Packet output;
+  RenderOverlay(
+      Adopt(MakeBlackFrame(kUnalignedWidth, /*alignment_boundary=*/1).release())
+          .At(Timestamp(0)),
+      &output);
+
+  const PacketConsumeStats after = GetPacketConsumeStats();
+  EXPECT_EQ(after.consumed - before.consumed, 0);
+  EXPECT_EQ(after.copied - before.copied, 0);
+  const auto& output_frame = output.Get<ImageFrame>();
+  EXPECT_EQ(output_frame.Width(), kUnalignedWidth);
+  EXPECT_FALSE(output_frame.IsContiguous());
+  EXPECT_TRUE(output_frame.IsAligned(kOutputAlignmentBoundary));
+  EXPECT_EQ(PixelAt(output_frame, 1, 1), std::vector<int>({255, 0, 0}));
+  EXPECT_EQ(PixelAt(output_frame, kUnalignedWidth - 1, 1),
+            std::vector<int>({0, 0, 0}));
+}
+
+}  // namespace
+
+}  // namespace mediapipe
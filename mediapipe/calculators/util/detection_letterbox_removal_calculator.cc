@@ -80,6 +80,8 @@ class DetectionLetterboxRemovalCalculator : public CalculatorBase {
 
     cc->Outputs().Tag(kDetectionsTag).Set<std::vector<Detection>>();
 
+    cc->SetRunInline(true);
+
     return absl::OkStatus();
   }
 
@@ -166,6 +166,8 @@ absl::Status DetectionsToRectsCalculator::GetContract(CalculatorContract* cc) {
     cc->Outputs().Tag(kNormRectsTag).Set<std::vector<NormalizedRect>>();
   }
 
+  cc->SetRunInline(true);
+
   return absl::OkStatus();
 }
 
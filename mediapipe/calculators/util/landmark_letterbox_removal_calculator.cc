@@ -84,6 +84,8 @@ class LandmarkLetterboxRemovalCalculator : public CalculatorBase {
       cc->Outputs().Get(id).Set<NormalizedLandmarkList>();
     }
 
+    cc->SetRunInline(true);
+
     return absl::OkStatus();
   }
 
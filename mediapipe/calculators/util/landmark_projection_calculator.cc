@@ -117,6 +117,8 @@ class LandmarkProjectionCalculator : public CalculatorBase {
       cc->Outputs().Get(id).Set<NormalizedLandmarkList>();
     }
 
+    cc->SetRunInline(true);
+
     return absl::OkStatus();
   }
 
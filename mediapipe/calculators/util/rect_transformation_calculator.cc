@@ -102,6 +102,8 @@ absl::Status RectTransformationCalculator::GetContract(CalculatorContract* cc) {
     cc->Outputs().Index(0).Set<std::vector<NormalizedRect>>();
   }
 
+  cc->SetRunInline(true);
+
   return absl::OkStatus();
 }
 
@@ -0,0 +1,114 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/adaptive_backpressure.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mediapipe {
+namespace internal {
+namespace {
+
+constexpr absl::Duration kDefaultUpdateInterval = absl::Milliseconds(10);
+
+// The weight of the latest measurement in the smoothed consumer rate.
+constexpr double kRateSmoothing = 0.5;
+
+// Returns the number of packets the consumer has removed from |stream|.
+int64 PacketsRemoved(const InputStreamManager& stream) {
+  return stream.NumPacketsAdded() - stream.QueueSize();
+}
+
+}  // namespace
+
+AdaptiveBackpressure::AdaptiveBackpressure(
+    const AdaptiveBackpressureConfig& config, int default_max_queue_size)
+    : target_latency_(
+          absl::Microseconds(config.target_queue_latency_usec())),
+      update_interval_(config.update_interval_usec() > 0
+                           ? absl::Microseconds(config.update_interval_usec())
+                           : kDefaultUpdateInterval),
+      min_queue_size_(std::max(config.min_queue_size(), 1)),
+      max_queue_size_(std::max(config.max_queue_size() > 0
+                                   ? config.max_queue_size()
+                                   : default_max_queue_size,
+                               min_queue_size_)) {}
+
+void AdaptiveBackpressure::PrepareForRun(
+    const std::vector<InputStreamManager*>& streams, absl::Time now) {
+  {
+    absl::MutexLock lock(&mutex_);
+    streams_.clear();
+    for (InputStreamManager* stream : streams) {
+      streams_[stream].last_update = now;
+    }
+  }
+  for (InputStreamManager* stream : streams) {
+    stream->SetMaxQueueSize(max_queue_size_);
+  }
+}
+
+void AdaptiveBackpressure::UpdateStream(InputStreamManager* stream,
+                                        absl::Time now) {
+  int new_max_queue_size;
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = streams_.find(stream);
+    if (it == streams_.end()) {
+      return;
+    }
+    StreamState& state = it->second;
+    const absl::Duration elapsed = now - state.last_update;
+    if (elapsed < update_interval_) {
+      return;
+    }
+    const int64 packets_removed = PacketsRemoved(*stream);
+    const double rate = (packets_removed - state.packets_removed) /
+                        absl::ToDoubleSeconds(elapsed);
+    state.packets_per_second =
+        state.packets_removed == 0
+            ? rate
+            : kRateSmoothing * rate +
+                  (1 - kRateSmoothing) * state.packets_per_second;
+    state.packets_removed = packets_removed;
+    state.last_update = now;
+    new_max_queue_size = QueueSizeForRate(state.packets_per_second);
+  }
+  // SetMaxQueueSize may invoke the queue size callbacks, which call
+  // UpdateStream again, so mutex_ must not be held.
+  if (new_max_queue_size != stream->MaxQueueSize()) {
+    VLOG(2) << "Adaptive max_queue_size of input stream \"" << stream->Name()
+            << "\" is " << new_max_queue_size;
+    stream->SetMaxQueueSize(new_max_queue_size);
+  }
+}
+
+double AdaptiveBackpressure::ConsumerRate(InputStreamManager* stream) const {
+  absl::MutexLock lock(&mutex_);
+  auto it = streams_.find(stream);
+  return it == streams_.end() ? 0 : it->second.packets_per_second;
+}
+
+int AdaptiveBackpressure::QueueSizeForRate(double packets_per_second) const {
+  const double size = std::ceil(packets_per_second *
+                                absl::ToDoubleSeconds(target_latency_));
+  if (size >= max_queue_size_) {
+    return max_queue_size_;
+  }
+  return std::max(static_cast<int>(size), min_queue_size_);
+}
+
+}  // namespace internal
+}  // namespace mediapipe
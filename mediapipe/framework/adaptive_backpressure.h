@@ -0,0 +1,105 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_ADAPTIVE_BACKPRESSURE_H_
+#define MEDIAPIPE_FRAMEWORK_ADAPTIVE_BACKPRESSURE_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/input_stream_manager.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// The queue state of one input stream, as reported by
+// CalculatorGraph::GetInputStreamQueueMetrics().
+struct InputStreamQueueMetrics {
+  std::string stream_name;
+  // The consuming node, as an index into CalculatorGraphConfig::node().
+  int node_id = -1;
+  // The number of packets currently queued.
+  int queue_size = 0;
+  // The current queue limit, or -1 if the stream is not throttled.
+  int max_queue_size = -1;
+  // The number of packets added to the queue during the current run.
+  int64 packets_added = 0;
+  // The smoothed rate at which the consumer removes packets, or 0 if the
+  // queue is not adaptively sized.
+  double consumer_packets_per_second = 0;
+};
+
+namespace internal {
+
+// Sizes input stream queues from the throughput of their consumers, as
+// specified by an AdaptiveBackpressureConfig.
+//
+// The consumer rate of a queue is measured from the packets removed between
+// two updates.  UpdateStream() is called whenever a queue becomes full or
+// non-full, which is when its limit matters for throttling.
+class AdaptiveBackpressure {
+ public:
+  // |default_max_queue_size| is the graph's max_queue_size, which is used if
+  // the config specifies no upper bound.
+  AdaptiveBackpressure(const AdaptiveBackpressureConfig& config,
+                       int default_max_queue_size);
+
+  AdaptiveBackpressure(const AdaptiveBackpressure&) = delete;
+  AdaptiveBackpressure& operator=(const AdaptiveBackpressure&) = delete;
+
+  // Starts adaptive sizing of |streams| for a new graph run, replacing the
+  // streams of any previous run.  Each queue starts at the upper bound.
+  void PrepareForRun(const std::vector<InputStreamManager*>& streams,
+                     absl::Time now) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Resizes the queue of |stream| from its consumer rate, unless it was
+  // resized within the update interval.  Streams not passed to
+  // PrepareForRun() are ignored.
+  void UpdateStream(InputStreamManager* stream, absl::Time now)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the smoothed consumer rate of |stream| in packets per second.
+  double ConsumerRate(InputStreamManager* stream) const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the queue size needed for |packets_per_second| at the target
+  // latency, clamped to the configured bounds.
+  int QueueSizeForRate(double packets_per_second) const;
+
+ private:
+  struct StreamState {
+    absl::Time last_update;
+    int64 packets_removed = 0;
+    double packets_per_second = 0;
+  };
+
+  const absl::Duration target_latency_;
+  const absl::Duration update_interval_;
+  const int min_queue_size_;
+  const int max_queue_size_;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<InputStreamManager*, StreamState> streams_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace internal
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_ADAPTIVE_BACKPRESSURE_H_
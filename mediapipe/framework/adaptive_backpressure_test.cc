@@ -0,0 +1,148 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/adaptive_backpressure.h"
+
+#include <memory>
+
+#include "absl/memory/memory.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/input_stream_manager.h"
+#include "mediapipe/framework/packet_type.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace internal {
+namespace {
+
+class AdaptiveBackpressureTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    packet_type_.Set<int>();
+    stream_ = absl::make_unique<InputStreamManager>();
+    MP_ASSERT_OK(stream_->Initialize("in", &packet_type_,
+                                     /*back_edge=*/false));
+    stream_->PrepareForRun();
+    auto ignore = [](InputStreamManager*, bool*) {};
+    stream_->SetQueueSizeCallbacks(ignore, ignore);
+  }
+
+  // Adds |count| packets to the stream and then lets the consumer remove
+  // |consumed| of them.
+  void Transfer(int count, int consumed) {
+    for (int i = 0; i < count; ++i) {
+      bool notify;
+      MP_ASSERT_OK(stream_->AddPackets(
+          {MakePacket<int>(0).At(Timestamp(next_timestamp_++))}, &notify));
+    }
+    for (int i = 0; i < consumed; ++i) {
+      bool stream_is_done;
+      stream_->PopQueueHead(&stream_is_done);
+    }
+  }
+
+  PacketType packet_type_;
+  std::unique_ptr<InputStreamManager> stream_;
+  int64 next_timestamp_ = 0;
+};
+
+TEST_F(AdaptiveBackpressureTest, QueueSizeForRate) {
+  AdaptiveBackpressureConfig config;
+  config.set_target_queue_latency_usec(100000);
+  config.set_min_queue_size(2);
+  AdaptiveBackpressure backpressure(config, /*default_max_queue_size=*/50);
+  EXPECT_EQ(backpressure.QueueSizeForRate(0), 2);
+  EXPECT_EQ(backpressure.QueueSizeForRate(100), 10);
+  EXPECT_EQ(backpressure.QueueSizeForRate(101), 11);
+  EXPECT_EQ(backpressure.QueueSizeForRate(1e6), 50);
+}
+
+TEST_F(AdaptiveBackpressureTest, FollowsConsumerRate) {
+  AdaptiveBackpressureConfig config;
+  config.set_target_queue_latency_usec(100000);
+  config.set_max_queue_size(40);
+  config.set_update_interval_usec(1000);
+  AdaptiveBackpressure backpressure(config, /*default_max_queue_size=*/100);
+  absl::Time now = absl::FromUnixSeconds(1000);
+  backpressure.PrepareForRun({stream_.get()}, now);
+  EXPECT_EQ(stream_->MaxQueueSize(), 40);
+
+  // The consumer removes 20 packets per second.
+  Transfer(/*count=*/30, /*consumed=*/20);
+  now += absl::Seconds(1);
+  backpressure.UpdateStream(stream_.get(), now);
+  EXPECT_DOUBLE_EQ(backpressure.ConsumerRate(stream_.get()), 20);
+  EXPECT_EQ(stream_->MaxQueueSize(), 2);
+
+  // Updates within the update interval are ignored.
+  Transfer(/*count=*/0, /*consumed=*/10);
+  backpressure.UpdateStream(stream_.get(), now + absl::Microseconds(10));
+  EXPECT_EQ(stream_->MaxQueueSize(), 2);
+
+  // The consumer speeds up to 220 packets per second.
+  Transfer(/*count=*/210, /*consumed=*/210);
+  now += absl::Seconds(1);
+  backpressure.UpdateStream(stream_.get(), now);
+  EXPECT_DOUBLE_EQ(backpressure.ConsumerRate(stream_.get()), 120);
+  EXPECT_EQ(stream_->MaxQueueSize(), 12);
+}
+
+TEST_F(AdaptiveBackpressureTest, IgnoresUnknownStreams) {
+  AdaptiveBackpressureConfig config;
+  config.set_target_queue_latency_usec(100000);
+  AdaptiveBackpressure backpressure(config, /*default_max_queue_size=*/100);
+  stream_->SetMaxQueueSize(7);
+  backpressure.UpdateStream(stream_.get(), absl::Now());
+  EXPECT_EQ(stream_->MaxQueueSize(), 7);
+  EXPECT_EQ(backpressure.ConsumerRate(stream_.get()), 0);
+}
+
+TEST(AdaptiveBackpressureGraphTest, ReportsQueueMetrics) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        max_queue_size: 30
+        adaptive_backpressure { target_queue_latency_usec: 50000 }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+      )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 5; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  std::vector<InputStreamQueueMetrics> metrics =
+      graph.GetInputStreamQueueMetrics();
+  ASSERT_EQ(metrics.size(), 1);
+  EXPECT_EQ(metrics[0].stream_name, "in");
+  EXPECT_EQ(metrics[0].node_id, 0);
+  EXPECT_EQ(metrics[0].packets_added, 5);
+  EXPECT_EQ(metrics[0].queue_size, 0);
+  EXPECT_EQ(metrics[0].max_queue_size, 30);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace mediapipe
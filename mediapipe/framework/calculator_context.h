@@ -15,8 +15,8 @@
 #ifndef MEDIAPIPE_FRAMEWORK_CALCULATOR_CONTEXT_H_
 #define MEDIAPIPE_FRAMEWORK_CALCULATOR_CONTEXT_H_
 
+#include <deque>
 #include <memory>
-#include <queue>
 #include <string>
 #include <utility>
 
@@ -85,6 +85,20 @@ class CalculatorContext {
                                      : input_timestamps_.front();
   }
 
+  // Returns the number of input sets passed to the current call to Process().
+  // It is greater than 1 only for calculators that call
+  // CalculatorContract::SetMaxBatchSize(). Input set "i" has the input
+  // timestamp BatchTimestamp(i), and its packets are returned by
+  // InputStreamShard::BatchValue(i). Input set 0 is the one returned by
+  // InputTimestamp() and InputStreamShard::Value().
+  int BatchSize() const { return batch_size_; }
+
+  // Returns the input timestamp of input set "index" of the current batch.
+  Timestamp BatchTimestamp(int index) const {
+    CHECK_LT(index, static_cast<int>(input_timestamps_.size()));
+    return input_timestamps_[index];
+  }
+
   // Returns a reference to the input side packet set.
   const PacketSet& InputSidePackets() const;
   // Returns a reference to the output side packet collection.
@@ -127,14 +141,16 @@ class CalculatorContext {
 
   // Adds a new input timestamp by the friend class CalculatorContextManager.
   void PushInputTimestamp(Timestamp input_timestamp) {
-    input_timestamps_.push(input_timestamp);
+    input_timestamps_.push_back(input_timestamp);
   }
 
   void PopInputTimestamp() {
     CHECK(!input_timestamps_.empty());
-    input_timestamps_.pop();
+    input_timestamps_.pop_front();
   }
 
+  void SetBatchSize(int batch_size) { batch_size_ = batch_size; }
+
   void SetGraphStatus(const absl::Status& status) { graph_status_ = status; }
 
   // Interface for the friend class Calculator.
@@ -153,7 +169,9 @@ class CalculatorContext {
   mutable std::unique_ptr<InputStreamSet> input_streams_;
   mutable std::unique_ptr<OutputStreamSet> output_streams_;
   // The queue of timestamp values to Process() in this calculator context.
-  std::queue<Timestamp> input_timestamps_;
+  std::deque<Timestamp> input_timestamps_;
+  // The number of input sets passed to the current call to Process().
+  int batch_size_ = 1;
 
   // The status of the graph run. Only used when Close() is called.
   absl::Status graph_status_;
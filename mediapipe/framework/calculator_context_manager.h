@@ -106,6 +106,12 @@ class CalculatorContextManager {
     calculator_context->PopInputTimestamp();
   }
 
+  void SetContextBatchSize(CalculatorContext* calculator_context,
+                           int batch_size) {
+    CHECK(calculator_context);
+    calculator_context->SetBatchSize(batch_size);
+  }
+
   void SetGraphStatusInContext(CalculatorContext* calculator_context,
                                const absl::Status& status) {
     CHECK(calculator_context);
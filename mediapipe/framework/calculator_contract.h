@@ -133,6 +133,25 @@ class CalculatorContract {
   void SetTimestampOffset(TimestampDiff offset) { timestamp_offset_ = offset; }
   TimestampDiff GetTimestampOffset() const { return timestamp_offset_; }
 
+  // When greater than 1, a single call to Process may receive up to
+  // max_batch_size input sets, one per input timestamp. The input sets that
+  // are ready when the node is scheduled are passed together, without waiting
+  // for a full batch. See CalculatorContext::BatchSize(). The calculator adds
+  // its outputs for each input timestamp in increasing order. Output timestamp
+  // bounds are computed from the last input timestamp of the batch.
+  // Cannot be combined with max_in_flight > 1.
+  void SetMaxBatchSize(int max_batch_size) { max_batch_size_ = max_batch_size; }
+  int GetMaxBatchSize() const { return max_batch_size_; }
+
+  // When true, Process is cheap enough to run directly on the thread that
+  // made its inputs ready, instead of being queued for the executor. This
+  // saves a scheduler queue round trip and usually a thread hop. It only
+  // applies when the producer runs on the same executor, and should only be
+  // set by calculators whose Process does a small, bounded amount of work and
+  // never blocks, e.g. calculators that forward or regroup packets.
+  void SetRunInline(bool run_inline) { run_inline_ = run_inline; }
+  bool GetRunInline() const { return run_inline_; }
+
   class GraphServiceRequest {
    public:
     // APIs that should be used by calculators.
@@ -188,6 +207,8 @@ class CalculatorContract {
   ServiceReqMap service_requests_;
   bool process_timestamps_ = false;
   TimestampDiff timestamp_offset_ = TimestampDiff::Unset();
+  int max_batch_size_ = 1;
+  bool run_inline_ = false;
 
   friend class CalculatorNode;
 };
@@ -33,6 +33,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/counter_factory.h"
@@ -208,6 +209,7 @@ absl::Status CalculatorGraph::InitializeStreams() {
 
     graph_input_streams_[stream_name] = absl::make_unique<GraphInputStream>(
         &output_stream_managers_[output_stream_index]);
+    graph_input_stream_list_.push_back(graph_input_streams_[stream_name].get());
 
     // Assign a virtual node ID to each graph input stream so we can treat
     // these as regular nodes for throttling.
@@ -271,6 +273,13 @@ absl::Status CalculatorGraph::InitializeCalculatorNodes() {
 
   VLOG(2) << "Maximum input stream queue size based on graph config: "
           << max_queue_size_;
+  const AdaptiveBackpressureConfig& adaptive_config =
+      validated_graph_->Config().adaptive_backpressure();
+  if (adaptive_config.target_queue_latency_usec() > 0 &&
+      max_queue_size_ != -1) {
+    adaptive_backpressure_ = absl::make_unique<internal::AdaptiveBackpressure>(
+        adaptive_config, max_queue_size_);
+  }
   return absl::OkStatus();
 }
 
@@ -416,6 +425,8 @@ absl::Status CalculatorGraph::Initialize(
       << "validated_graph is not initialized.";
   validated_graph_ = std::move(validated_graph);
 
+  MP_RETURN_IF_ERROR(scheduler_.SetDeadlineConfig(
+      validated_graph_->Config().deadline_config()));
   MP_RETURN_IF_ERROR(InitializeExecutors());
   MP_RETURN_IF_ERROR(InitializePacketGeneratorGraph(side_packets));
   MP_RETURN_IF_ERROR(InitializeStreams());
@@ -453,6 +464,20 @@ absl::Status CalculatorGraph::Initialize(
   return Initialize(std::move(validated_graph), side_packets);
 }
 
+absl::Status CalculatorGraph::InitializeFromSnapshot(
+    absl::string_view snapshot,
+    const std::map<std::string, Packet>& side_packets) {
+  auto validated_graph = absl::make_unique<ValidatedGraphConfig>();
+  MP_RETURN_IF_ERROR(validated_graph->InitializeFromSnapshot(snapshot));
+  return Initialize(std::move(validated_graph), side_packets);
+}
+
+absl::StatusOr<std::string> CalculatorGraph::GetConfigSnapshot() const {
+  RET_CHECK(initialized_).SetNoLogging()
+      << "CalculatorGraph is not initialized.";
+  return validated_graph_->SerializeSnapshot();
+}
+
 absl::Status CalculatorGraph::ObserveOutputStream(
     const std::string& stream_name,
     std::function<absl::Status(const Packet&)> packet_callback,
@@ -549,6 +574,7 @@ absl::Status CalculatorGraph::StartRun(
   MP_RETURN_IF_ERROR(PrepareForRun(extra_side_packets, stream_headers));
   MP_RETURN_IF_ERROR(profiler_->Start(executors_[""].get()));
   scheduler_.Start();
+  run_in_progress_ = true;
   return absl::OkStatus();
 }
 
@@ -805,6 +831,20 @@ absl::Status CalculatorGraph::PrepareForRun(
     (*stream)->SetMaxQueueSize(name_max.second);
   }
 
+  // Adaptive queue sizes replace the global max queue size, except for the
+  // streams fed by graph input streams with an explicit max queue size.
+  if (adaptive_backpressure_) {
+    std::vector<InputStreamManager*> adaptive_streams;
+    for (int index = 0; index < validated_graph_->InputStreamInfos().size();
+         ++index) {
+      const EdgeInfo& edge_info = validated_graph_->InputStreamInfos()[index];
+      if (!graph_input_stream_max_queue_size_.contains(edge_info.name)) {
+        adaptive_streams.push_back(&input_stream_managers_[index]);
+      }
+    }
+    adaptive_backpressure_->PrepareForRun(adaptive_streams, absl::Now());
+  }
+
   for (auto& node : nodes_) {
     if (node->IsSource()) {
       scheduler_.AddUnopenedSourceNode(node.get());
@@ -850,7 +890,9 @@ absl::Status CalculatorGraph::WaitUntilDone() {
   MP_RETURN_IF_ERROR(scheduler_.WaitUntilDone());
   VLOG(2) << "Scheduler terminated.";
 
-  return FinishRun();
+  absl::Status status = FinishRun();
+  run_in_progress_ = false;
+  return status;
 }
 
 absl::Status CalculatorGraph::WaitForObservedOutput() {
@@ -880,6 +922,47 @@ absl::Status CalculatorGraph::SetInputStreamTimestampBound(
   return absl::OkStatus();
 }
 
+absl::StatusOr<CalculatorGraph::InputStreamHandle>
+CalculatorGraph::GetInputStreamHandle(const std::string& stream_name) {
+  std::unique_ptr<GraphInputStream>* stream =
+      mediapipe::FindOrNull(graph_input_streams_, stream_name);
+  RET_CHECK(stream).SetNoLogging() << absl::Substitute(
+      "GetInputStreamHandle called on input stream \"$0\" which is not a "
+      "graph input stream.",
+      stream_name);
+  int node_id = mediapipe::FindOrDie(graph_input_stream_node_ids_, stream_name);
+  return InputStreamHandle(node_id - validated_graph_->CalculatorInfos().size(),
+                           &(*stream)->GetManager()->Name());
+}
+
+absl::Status CalculatorGraph::AddPacketToInputStream(InputStreamHandle stream,
+                                                     const Packet& packet) {
+  return AddPacketToInputStreamInternal(stream, packet);
+}
+
+absl::Status CalculatorGraph::AddPacketToInputStream(InputStreamHandle stream,
+                                                     Packet&& packet) {
+  return AddPacketToInputStreamInternal(stream, std::move(packet));
+}
+
+absl::Status CalculatorGraph::AddPacketsToInputStream(
+    InputStreamHandle stream, absl::Span<const Packet> packets) {
+  RET_CHECK(stream.index_ >= 0 &&
+            stream.index_ < graph_input_stream_list_.size())
+      << "Invalid InputStreamHandle.";
+  if (packets.empty()) {
+    return absl::OkStatus();
+  }
+  GraphInputStream* input_stream = graph_input_stream_list_[stream.index_];
+  MP_RETURN_IF_ERROR(WaitToAddToGraphInputStream(
+      validated_graph_->CalculatorInfos().size() + stream.index_));
+  for (const Packet& packet : packets) {
+    LogGraphInputPacket(input_stream, packet);
+    input_stream->AddPacket(packet);
+  }
+  return FinishAddingToGraphInputStream(input_stream);
+}
+
 // We avoid having two copies of this code for AddPacketToInputStream(
 // const Packet&) and AddPacketToInputStream(Packet &&) by having this
 // internal-only templated version.  T&& is a forwarding reference here, so
@@ -895,46 +978,76 @@ absl::Status CalculatorGraph::AddPacketToInputStreamInternal(
       stream_name);
   int node_id = mediapipe::FindOrDie(graph_input_stream_node_ids_, stream_name);
   CHECK_GE(node_id, validated_graph_->CalculatorInfos().size());
-  {
-    absl::MutexLock lock(&full_input_streams_mutex_);
-    if (full_input_streams_.empty()) {
-      return mediapipe::FailedPreconditionErrorBuilder(MEDIAPIPE_LOC)
-             << "CalculatorGraph::AddPacketToInputStream() is called before "
-                "StartRun()";
+  MP_RETURN_IF_ERROR(WaitToAddToGraphInputStream(node_id));
+  LogGraphInputPacket(stream->get(), packet);
+
+  // InputStreamManager is thread safe. GraphInputStream is not, so this method
+  // should not be called by multiple threads concurrently. Note that this could
+  // potentially lead to the max queue size being exceeded by one packet at most
+  // because we don't have the lock over the input stream.
+  (*stream)->AddPacket(std::forward<T>(packet));
+  MP_RETURN_IF_ERROR(FinishAddingToGraphInputStream(stream->get()));
+  VLOG(2) << "Packet added directly to: " << stream_name;
+  return absl::OkStatus();
+}
+
+template <typename T>
+absl::Status CalculatorGraph::AddPacketToInputStreamInternal(
+    InputStreamHandle stream, T&& packet) {
+  RET_CHECK(stream.index_ >= 0 &&
+            stream.index_ < graph_input_stream_list_.size())
+      << "Invalid InputStreamHandle.";
+  GraphInputStream* input_stream = graph_input_stream_list_[stream.index_];
+  MP_RETURN_IF_ERROR(WaitToAddToGraphInputStream(
+      validated_graph_->CalculatorInfos().size() + stream.index_));
+  LogGraphInputPacket(input_stream, packet);
+  input_stream->AddPacket(std::forward<T>(packet));
+  return FinishAddingToGraphInputStream(input_stream);
+}
+
+absl::Status CalculatorGraph::WaitToAddToGraphInputStream(int node_id) {
+  absl::MutexLock lock(&full_input_streams_mutex_);
+  if (full_input_streams_.empty()) {
+    return mediapipe::FailedPreconditionErrorBuilder(MEDIAPIPE_LOC)
+           << "CalculatorGraph::AddPacketToInputStream() is called before "
+              "StartRun()";
+  }
+  if (graph_input_stream_add_mode_ ==
+      GraphInputStreamAddMode::ADD_IF_NOT_FULL) {
+    if (has_error_) {
+      absl::Status error_status;
+      GetCombinedErrors("Graph has errors: ", &error_status);
+      return error_status;
     }
-    if (graph_input_stream_add_mode_ ==
-        GraphInputStreamAddMode::ADD_IF_NOT_FULL) {
-      if (has_error_) {
-        absl::Status error_status;
-        GetCombinedErrors("Graph has errors: ", &error_status);
-        return error_status;
-      }
-      // Return with StatusUnavailable if this stream is being throttled.
-      if (!full_input_streams_[node_id].empty()) {
-        return mediapipe::UnavailableErrorBuilder(MEDIAPIPE_LOC)
-               << "Graph is throttled.";
-      }
-    } else if (graph_input_stream_add_mode_ ==
-               GraphInputStreamAddMode::WAIT_TILL_NOT_FULL) {
-      // Wait until this stream is not being throttled.
-      // TODO: instead of checking has_error_, we could just check
-      // if the graph is done. That could also be indicated by returning an
-      // error from WaitUntilGraphInputStreamUnthrottled.
-      while (!has_error_ && !full_input_streams_[node_id].empty()) {
-        // TODO: allow waiting for a specific stream?
-        scheduler_.WaitUntilGraphInputStreamUnthrottled(
-            &full_input_streams_mutex_);
-      }
-      if (has_error_) {
-        absl::Status error_status;
-        GetCombinedErrors("Graph has errors: ", &error_status);
-        return error_status;
-      }
+    // Return with StatusUnavailable if this stream is being throttled.
+    if (!full_input_streams_[node_id].empty()) {
+      return mediapipe::UnavailableErrorBuilder(MEDIAPIPE_LOC)
+             << "Graph is throttled.";
+    }
+  } else if (graph_input_stream_add_mode_ ==
+             GraphInputStreamAddMode::WAIT_TILL_NOT_FULL) {
+    // Wait until this stream is not being throttled.
+    // TODO: instead of checking has_error_, we could just check
+    // if the graph is done. That could also be indicated by returning an
+    // error from WaitUntilGraphInputStreamUnthrottled.
+    while (!has_error_ && !full_input_streams_[node_id].empty()) {
+      // TODO: allow waiting for a specific stream?
+      scheduler_.WaitUntilGraphInputStreamUnthrottled(
+          &full_input_streams_mutex_);
+    }
+    if (has_error_) {
+      absl::Status error_status;
+      GetCombinedErrors("Graph has errors: ", &error_status);
+      return error_status;
     }
   }
+  return absl::OkStatus();
+}
 
+void CalculatorGraph::LogGraphInputPacket(GraphInputStream* stream,
+                                          const Packet& packet) {
   // Adding profiling info for a new packet entering the graph.
-  const std::string* stream_id = &(*stream)->GetManager()->Name();
+  const std::string* stream_id = &stream->GetManager()->Name();
   profiler_->LogEvent(TraceEvent(TraceEvent::PROCESS)
                           .set_is_finish(true)
                           .set_input_ts(packet.Timestamp())
@@ -942,19 +1055,19 @@ absl::Status CalculatorGraph::AddPacketToInputStreamInternal(
                           .set_packet_ts(packet.Timestamp())
                           .set_packet_data_id(&packet));
 
-  // InputStreamManager is thread safe. GraphInputStream is not, so this method
-  // should not be called by multiple threads concurrently. Note that this could
-  // potentially lead to the max queue size being exceeded by one packet at most
-  // because we don't have the lock over the input stream.
-  (*stream)->AddPacket(std::forward<T>(packet));
+  // Starts the wall-clock deadline budget of the packet's timestamp.
+  scheduler_.deadlines()->RecordArrival(packet.Timestamp());
+}
+
+absl::Status CalculatorGraph::FinishAddingToGraphInputStream(
+    GraphInputStream* stream) {
   if (has_error_) {
     absl::Status error_status;
     GetCombinedErrors("Graph has errors: ", &error_status);
     return error_status;
   }
-  (*stream)->PropagateUpdatesToMirrors();
+  stream->PropagateUpdatesToMirrors();
 
-  VLOG(2) << "Packet added directly to: " << stream_name;
   // Note: one reason why we need to call the scheduler here is that we have
   // re-throttled the graph input streams, and we may need to unthrottle them
   // again if the graph is still idle. Unthrottling basically only lets in one
@@ -1110,6 +1223,11 @@ int CalculatorGraph::GetMaxInputStreamQueueSize() { return max_queue_size_; }
 
 void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
                                            bool* stream_was_full) {
+  // A queue that becomes full or non-full may need a new adaptive size, which
+  // is applied before the throttling state is recomputed below.
+  if (adaptive_backpressure_) {
+    adaptive_backpressure_->UpdateStream(stream, absl::Now());
+  }
   // TODO Change the throttling code to use the index directly
   // rather than looking up a stream name.
   int node_index = validated_graph_->OutputStreamToNode(stream->Name());
@@ -1183,6 +1301,32 @@ void CalculatorGraph::UpdateThrottledNodes(InputStreamManager* stream,
   }
 }
 
+std::vector<InputStreamQueueMetrics>
+CalculatorGraph::GetInputStreamQueueMetrics() const {
+  std::vector<InputStreamQueueMetrics> result;
+  if (!initialized_) {
+    return result;
+  }
+  result.reserve(validated_graph_->InputStreamInfos().size());
+  for (int index = 0; index < validated_graph_->InputStreamInfos().size();
+       ++index) {
+    InputStreamManager* stream = &input_stream_managers_[index];
+    InputStreamQueueMetrics metrics;
+    metrics.stream_name = stream->Name();
+    metrics.node_id =
+        validated_graph_->InputStreamInfos()[index].parent_node.index;
+    metrics.queue_size = stream->QueueSize();
+    metrics.max_queue_size = stream->MaxQueueSize();
+    metrics.packets_added = stream->NumPacketsAdded();
+    if (adaptive_backpressure_) {
+      metrics.consumer_packets_per_second =
+          adaptive_backpressure_->ConsumerRate(stream);
+    }
+    result.push_back(std::move(metrics));
+  }
+  return result;
+}
+
 bool CalculatorGraph::IsNodeThrottled(int node_id) {
   absl::MutexLock lock(&full_input_streams_mutex_);
   return max_queue_size_ != -1 && !full_input_streams_[node_id].empty();
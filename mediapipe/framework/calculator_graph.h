@@ -30,7 +30,11 @@
 #include "absl/container/fixed_array.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "mediapipe/framework/adaptive_backpressure.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/calculator_node.h"
@@ -144,6 +148,23 @@ class CalculatorGraph {
       const std::string& graph_type = "",
       const Subgraph::SubgraphOptions* options = nullptr);
 
+  // Initializes the graph from a snapshot produced by
+  // ValidatedGraphConfig::SerializeSnapshot() or GetConfigSnapshot().  This
+  // skips subgraph expansion, which dominates startup for large task graphs.
+  // Graph services populated during expansion must be set up by the caller.
+  absl::Status InitializeFromSnapshot(
+      absl::string_view snapshot,
+      const std::map<std::string, Packet>& side_packets = {});
+
+  // Returns a snapshot of the canonicalized config for this graph, which can
+  // be stored and passed to InitializeFromSnapshot.
+  absl::StatusOr<std::string> GetConfigSnapshot() const;
+
+  // Returns the queue state of every calculator input stream, including the
+  // adaptive queue sizes and consumer rates if the graph config enables
+  // adaptive_backpressure.
+  std::vector<InputStreamQueueMetrics> GetInputStreamQueueMetrics() const;
+
   // Returns the canonicalized CalculatorGraphConfig for this graph.
   const CalculatorGraphConfig& Config() const {
     return validated_graph_->Config();
@@ -235,6 +256,10 @@ class CalculatorGraph {
   // Quick non-locking means of checking if the graph has encountered an error.
   bool HasError() const { return has_error_; }
 
+  // Returns true from a successful StartRun() until the matching
+  // WaitUntilDone() returns.
+  bool IsRunInProgress() const { return run_in_progress_; }
+
   // Add a Packet to a graph input stream based on the graph input stream add
   // mode. If the mode is ADD_IF_NOT_FULL, the packet will not be added if any
   // queue exceeds max_queue_size specified by the graph config and will return
@@ -257,6 +282,48 @@ class CalculatorGraph {
   absl::Status AddPacketToInputStream(const std::string& stream_name,
                                       Packet&& packet);
 
+  // Identifies a graph input stream without its name.  Adding packets through
+  // an InputStreamHandle skips the lookup of the stream by name.  A handle is
+  // obtained from GetInputStreamHandle and is valid only for that graph.
+  class InputStreamHandle {
+   public:
+    InputStreamHandle() = default;
+
+    // Returns the name of the graph input stream.
+    const std::string& Name() const { return *name_; }
+
+   private:
+    friend class CalculatorGraph;
+    InputStreamHandle(int index, const std::string* name)
+        : index_(index), name_(name) {}
+
+    // The index of the stream in graph_input_stream_list_.
+    int index_ = -1;
+    const std::string* name_ = nullptr;
+  };
+
+  // Returns the InputStreamHandle for a graph input stream.  The graph must
+  // be initialized.
+  absl::StatusOr<InputStreamHandle> GetInputStreamHandle(
+      const std::string& stream_name);
+
+  // Same as AddPacketToInputStream(stream_name, packet), but for a stream
+  // identified by an InputStreamHandle.
+  absl::Status AddPacketToInputStream(InputStreamHandle stream,
+                                      const Packet& packet);
+  absl::Status AddPacketToInputStream(InputStreamHandle stream,
+                                      Packet&& packet);
+
+  // Adds packets in increasing timestamp order to a graph input stream.
+  // The graph input stream add mode is applied once for the whole batch, so
+  // the batch may exceed max_queue_size by up to packets.size() - 1 packets.
+  // The packets are delivered to each consuming input stream together,
+  // taking its lock once per batch.  On error, nothing is added if the graph
+  // is throttled or has failed; otherwise, an invalid packet fails the graph
+  // as it does for AddPacketToInputStream.
+  absl::Status AddPacketsToInputStream(InputStreamHandle stream,
+                                       absl::Span<const Packet> packets);
+
   // Indicates that input will arrive no earlier than a certain timestamp.
   absl::Status SetInputStreamTimestampBound(const std::string& stream_name,
                                             Timestamp timestamp);
@@ -454,6 +521,19 @@ class CalculatorGraph {
   template <typename T>
   absl::Status AddPacketToInputStreamInternal(const std::string& stream_name,
                                               T&& packet);
+  template <typename T>
+  absl::Status AddPacketToInputStreamInternal(InputStreamHandle stream,
+                                              T&& packet);
+
+  // Applies the graph input stream add mode before packets are added to the
+  // graph input stream with virtual node id |node_id|.
+  absl::Status WaitToAddToGraphInputStream(int node_id);
+
+  // Records the arrival of a packet added to a graph input stream.
+  void LogGraphInputPacket(GraphInputStream* stream, const Packet& packet);
+
+  // Delivers the packets added to a graph input stream to its mirrors.
+  absl::Status FinishAddingToGraphInputStream(GraphInputStream* stream);
 
   // Sets the executor that will run the nodes assigned to the executor
   // named |name|.  If |name| is empty, this sets the default executor.
@@ -582,6 +662,9 @@ class CalculatorGraph {
   // restrict memory usage.
   int max_queue_size_ = -1;
 
+  // Sizes the input stream queues if adaptive_backpressure is enabled.
+  std::unique_ptr<internal::AdaptiveBackpressure> adaptive_backpressure_;
+
   // Mode for adding packets to a graph input stream. Set to block until all
   // affected input streams are not full by default.
   GraphInputStreamAddMode graph_input_stream_add_mode_
@@ -600,6 +683,9 @@ class CalculatorGraph {
   absl::flat_hash_map<std::string, std::unique_ptr<GraphInputStream>>
       graph_input_streams_;
 
+  // The graph input stream objects, in the order of their virtual node ids.
+  std::vector<GraphInputStream*> graph_input_stream_list_;
+
   // Maps graph input streams to their virtual node ids.
   absl::flat_hash_map<std::string, int> graph_input_stream_node_ids_;
 
@@ -637,6 +723,9 @@ class CalculatorGraph {
   // Status variable to indicate if the graph has encountered an error.
   std::atomic<bool> has_error_;
 
+  // See IsRunInProgress().
+  std::atomic<bool> run_in_progress_{false};
+
   // Mutex for full_input_streams_.
   mutable absl::Mutex full_input_streams_mutex_;
 
@@ -14,9 +14,11 @@
 
 #include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -1777,5 +1779,60 @@ TEST(CalculatorGraphBoundsTest, TimestampBoundsForInfrequentInput) {
   MP_ASSERT_OK(graph.WaitUntilDone());
 }
 
+// Measures bound propagation through graphs dominated by empty streams.
+// Each of state.range(0) branches gates the input with a ValveCalculator that
+// is closed for all but one in state.range(1) packets, then passes the gated
+// stream through a PassThroughCalculator into a shared fan-in node.
+void BM_SparseBoundPropagation(benchmark::State& state) {
+  const int num_branches = state.range(0);
+  const int open_period = state.range(1);
+  CalculatorGraphConfig config;
+  config.add_input_stream("input");
+  config.add_input_stream("open");
+  for (int i = 0; i < num_branches; ++i) {
+    CalculatorGraphConfig::Node* valve = config.add_node();
+    valve->set_calculator("ValveCalculator");
+    valve->add_input_stream("input");
+    valve->add_input_stream("open");
+    valve->add_output_stream(absl::StrCat("gated_", i));
+    CalculatorGraphConfig::Node* pass = config.add_node();
+    pass->set_calculator("PassThroughCalculator");
+    pass->add_input_stream(absl::StrCat("gated_", i));
+    pass->add_output_stream(absl::StrCat("passed_", i));
+  }
+  CalculatorGraphConfig::Node* fan_in = config.add_node();
+  fan_in->set_calculator("PassThroughCalculator");
+  for (int i = 0; i < num_branches; ++i) {
+    fan_in->add_input_stream(absl::StrCat("passed_", i));
+    fan_in->add_output_stream(absl::StrCat("output_", i));
+  }
+
+  CalculatorGraph graph;
+  CHECK(graph.Initialize(config).ok());
+  CHECK(graph.StartRun({}).ok());
+  int64 count = 0;
+  for (auto _ : state) {
+    Timestamp timestamp(count);
+    CHECK(graph
+              .AddPacketToInputStream("input",
+                                      MakePacket<int>(count).At(timestamp))
+              .ok());
+    CHECK(graph
+              .AddPacketToInputStream(
+                  "open",
+                  MakePacket<bool>(count % open_period == 0).At(timestamp))
+              .ok());
+    ++count;
+  }
+  CHECK(graph.CloseAllInputStreams().ok());
+  CHECK(graph.WaitUntilDone().ok());
+  state.SetItemsProcessed(count);
+}
+BENCHMARK(BM_SparseBoundPropagation)
+    ->Args({8, 10})
+    ->Args({64, 10})
+    ->Args({64, 1000})
+    ->UseRealTime();
+
 }  // namespace
 }  // namespace mediapipe
@@ -361,6 +361,72 @@ class IntToFloatCalculator : public CalculatorBase {
 };
 REGISTER_CALCULATOR(IntToFloatCalculator);
 
+// For an input packet with value n and timestamp t, outputs n packets with the
+// values 0 to n - 1 and the timestamps t * 100 to t * 100 + n - 1.
+class IntBurstCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    const int count = cc->Inputs().Index(0).Get<int>();
+    for (int i = 0; i < count; ++i) {
+      cc->Outputs().Index(0).Add(
+          new int(i), Timestamp(cc->InputTimestamp().Value() * 100 + i));
+    }
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(IntBurstCalculator);
+
+// For an input vector of timestamps, outputs one packet per timestamp whose
+// value is its index in the vector.
+class TimestampBurstCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<std::vector<int64>>();
+    cc->Outputs().Index(0).Set<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    const auto& timestamps = cc->Inputs().Index(0).Get<std::vector<int64>>();
+    for (int i = 0; i < timestamps.size(); ++i) {
+      cc->Outputs().Index(0).Add(new int(i), Timestamp(timestamps[i]));
+    }
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(TimestampBurstCalculator);
+
+// Receives up to four input sets per call to Process(). Passes the input
+// packets through to OUT, and outputs the size of each batch to BATCH_SIZE at
+// the first timestamp of the batch.
+class BatchPassThroughCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Tag("IN").Set<int>();
+    cc->Outputs().Tag("OUT").Set<int>();
+    cc->Outputs().Tag("BATCH_SIZE").Set<int>();
+    cc->SetTimestampOffset(TimestampDiff(0));
+    cc->SetMaxBatchSize(4);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    cc->Outputs().Tag("BATCH_SIZE").Add(new int(cc->BatchSize()),
+                                         cc->InputTimestamp());
+    for (int i = 0; i < cc->BatchSize(); ++i) {
+      cc->Outputs().Tag("OUT").AddPacket(cc->Inputs().Tag("IN").BatchValue(i));
+    }
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(BatchPassThroughCalculator);
+
 template <typename OutputType>
 class TypedEmptySourceCalculator : public CalculatorBase {
  public:
@@ -980,6 +1046,25 @@ class PthreadSelfSourceCalculator : public CalculatorBase {
 };
 REGISTER_CALCULATOR(PthreadSelfSourceCalculator);
 
+// A calculator that runs inline and outputs a packet containing the return
+// value of pthread_self() for every input packet.
+class InlinePthreadSelfCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).Set<pthread_t>();
+    cc->SetRunInline(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<pthread_t>(pthread_self()).At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(InlinePthreadSelfCalculator);
+
 // A source calculator for testing the Calculator::InputTimestamp() method.
 // It outputs five int packets with timestamps 0, 1, 2, 3, 4.
 class CheckInputTimestampSourceCalculator : public CalculatorBase {
@@ -1573,6 +1658,18 @@ TEST(CalculatorGraph, RunsCorrectlyWithMultipleExecutors) {
   RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
 }
 
+TEST(CalculatorGraph, RunsCorrectlyWithWorkStealingExecutor) {
+  CalculatorGraph graph;
+  // Replace the default executor with a WorkStealingExecutor.
+  CalculatorGraphConfig proto = GetConfig();
+  ExecutorConfig* executor = proto.add_executor();
+  executor->set_type("WorkStealingExecutor");
+  executor->mutable_options()
+      ->MutableExtension(ThreadPoolExecutorOptions::ext)
+      ->set_num_threads(4);
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+}
+
 // Packet generator for an arbitrary unit64 packet.
 class Uint64PacketGenerator : public PacketGenerator {
  public:
@@ -4225,6 +4322,37 @@ TEST(CalculatorGraph, NumThreadsAndNonDefaultExecutorConfig) {
   MP_EXPECT_OK(graph.Initialize(config));
 }
 
+#if defined(__linux__)
+// The cpu_id field of ThreadPoolExecutorOptions must not contain negative
+// processor ids.
+TEST(CalculatorGraph, NegativeCpuIdInExecutorConfig) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        executor {
+          name: 'xyz'
+          type: 'ThreadPoolExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] {
+              num_threads: 1
+              cpu_id: [ 0, -1 ]
+            }
+          }
+        }
+        node {
+          calculator: 'PassThroughCalculator'
+          executor: 'xyz'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+      )pb");
+  absl::Status status = graph.Initialize(config);
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), testing::HasSubstr("cpu_id"));
+}
+#endif  // __linux__
+
 // Verifies that the application thread is used only when
 // "ApplicationThreadExecutor" is specified.  In this test
 // "ApplicationThreadExecutor" is specified in the ExecutorConfig for the
@@ -4271,6 +4399,54 @@ TEST(CalculatorGraph, RunWithNumThreadsInExecutorConfig) {
   }
 }
 
+// Verifies that an inline node runs on the thread of its producer, unless it
+// is assigned to a different executor.
+TEST(CalculatorGraph, RunsInlineNodeOnProducerThread) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        num_threads: 4
+        executor {
+          name: 'other'
+          type: 'ThreadPoolExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] { num_threads: 1 }
+          }
+        }
+        node {
+          calculator: 'PthreadSelfSourceCalculator'
+          output_stream: 'source_thread'
+        }
+        node {
+          calculator: 'InlinePthreadSelfCalculator'
+          input_stream: 'source_thread'
+          output_stream: 'inline_thread'
+        }
+        node {
+          calculator: 'InlinePthreadSelfCalculator'
+          input_stream: 'source_thread'
+          output_stream: 'other_thread'
+          executor: 'other'
+        }
+      )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  std::map<std::string, pthread_t> threads;
+  for (const std::string& stream :
+       {"source_thread", "inline_thread", "other_thread"}) {
+    MP_ASSERT_OK(graph.ObserveOutputStream(
+        stream, [&threads, stream](const Packet& packet) {
+          threads[stream] = packet.Get<pthread_t>();
+          return absl::OkStatus();
+        }));
+  }
+  MP_ASSERT_OK(graph.Run());
+  ASSERT_EQ(threads.size(), 3);
+  EXPECT_TRUE(
+      pthread_equal(threads["source_thread"], threads["inline_thread"]));
+  EXPECT_FALSE(
+      pthread_equal(threads["source_thread"], threads["other_thread"]));
+}
+
 TEST(CalculatorGraph, CalculatorGraphNotInitialized) {
   CalculatorGraph graph;
   EXPECT_FALSE(graph.Run().ok());
@@ -4520,6 +4696,80 @@ TEST(CalculatorGraph, TestPollPacketsFromMultipleStreams) {
   EXPECT_EQ(kDefaultMaxCount, num_packets2);
 }
 
+TEST(CalculatorGraph, TestPollPacketBatches) {
+  CalculatorGraphConfig config;
+  CalculatorGraphConfig::Node* node = config.add_node();
+  node->set_calculator("CountingSourceCalculator");
+  node->add_output_stream("output");
+  node->add_input_side_packet("MAX_COUNT:max_count");
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  auto status_or_poller = graph.AddOutputStreamPoller("output");
+  ASSERT_TRUE(status_or_poller.ok());
+  OutputStreamPoller poller = std::move(status_or_poller.value());
+  MP_ASSERT_OK(
+      graph.StartRun({{"max_count", MakePacket<int>(kDefaultMaxCount)}}));
+  std::vector<Packet> packets;
+  int num_packets = 0;
+  while (poller.NextBatch(&packets, /*max_packets=*/16)) {
+    EXPECT_GE(packets.size(), 1);
+    EXPECT_LE(packets.size(), 16);
+    for (const Packet& packet : packets) {
+      EXPECT_EQ(num_packets, packet.Get<int>());
+      ++num_packets;
+    }
+  }
+  MP_ASSERT_OK(graph.CloseAllPacketSources());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_FALSE(poller.NextBatch(&packets));
+  EXPECT_EQ(kDefaultMaxCount, num_packets);
+}
+
+TEST(CalculatorGraph, InputStreamHandle) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "input"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "input"
+          output_stream: "output"
+        }
+      )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  EXPECT_FALSE(graph.GetInputStreamHandle("output").ok());
+  auto status_or_handle = graph.GetInputStreamHandle("input");
+  MP_ASSERT_OK(status_or_handle);
+  CalculatorGraph::InputStreamHandle input = status_or_handle.value();
+  EXPECT_EQ("input", input.Name());
+  auto status_or_poller = graph.AddOutputStreamPoller("output");
+  ASSERT_TRUE(status_or_poller.ok());
+  OutputStreamPoller poller = std::move(status_or_poller.value());
+  MP_ASSERT_OK(graph.StartRun({}));
+
+  // Adds one packet, then a batch of packets, through the handle.
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      input, MakePacket<int>(0).At(Timestamp(0))));
+  std::vector<Packet> batch;
+  for (int i = 1; i < 10; ++i) {
+    batch.push_back(MakePacket<int>(i).At(Timestamp(i)));
+  }
+  MP_ASSERT_OK(graph.AddPacketsToInputStream(input, batch));
+  MP_ASSERT_OK(graph.CloseInputStream("input"));
+
+  std::vector<Packet> packets;
+  std::vector<int> values;
+  while (poller.NextBatch(&packets)) {
+    for (const Packet& packet : packets) {
+      EXPECT_EQ(Timestamp(values.size()), packet.Timestamp());
+      values.push_back(packet.Get<int>());
+    }
+  }
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_THAT(values, ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+}
+
 class TimestampBoundTestCalculator : public CalculatorBase {
  public:
   static absl::Status GetContract(CalculatorContract* cc) {
@@ -4712,5 +4962,231 @@ TEST(CalculatorGraph, MultipleRunsWithDifferentInputStreamHandlers) {
   DoTestMultipleGraphRuns("TimestampAlignInputStreamHandler", true);
 }
 
+TEST(CalculatorGraph, DropsPacketsPastTheirDeadline) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'input'
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'input'
+          output_stream: 'output'
+        }
+        deadline_config {
+          timestamp_offset_usec: 60000000
+          earliest_deadline_first: true
+          drop_late_packets: true
+        }
+      )pb");
+  std::vector<Packet> packet_dump;
+  tool::AddVectorSink("output", &config, &packet_dump);
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  // Timestamps are read as microseconds since the Unix epoch, so these
+  // packets are long past their deadlines.
+  for (int i = 1; i <= 5; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  const int64 now = absl::ToUnixMicros(absl::Now());
+  for (int i = 1; i <= 5; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "input", MakePacket<int>(i).At(Timestamp(now + i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllPacketSources());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(5, packet_dump.size());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(Timestamp(now + i + 1), packet_dump[i].Timestamp());
+  }
+}
+
+TEST(CalculatorGraph, RejectsInvalidDeadlineConfig) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'input'
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'input'
+          output_stream: 'output'
+        }
+        deadline_config { timestamp_offset_usec: 1 wall_time_budget_usec: 1 }
+      )pb");
+  CalculatorGraph graph;
+  EXPECT_FALSE(graph.Initialize(config).ok());
+}
+
+TEST(CalculatorGraph, ProcessesInputSetsInBatches) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'count'
+        node {
+          calculator: 'IntBurstCalculator'
+          input_stream: 'count'
+          output_stream: 'burst'
+        }
+        node {
+          calculator: 'BatchPassThroughCalculator'
+          input_stream: 'IN:burst'
+          output_stream: 'OUT:out'
+          output_stream: 'BATCH_SIZE:batch_size'
+        }
+      )pb");
+  std::vector<Packet> out_packets;
+  std::vector<Packet> batch_size_packets;
+  tool::AddVectorSink("out", &config, &out_packets);
+  tool::AddVectorSink("batch_size", &config, &batch_size_packets);
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  // The ten packets of the burst arrive together, and are processed in
+  // batches of four, four, and two. The last batch is not held back waiting
+  // for more input sets.
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "count", MakePacket<int>(10).At(Timestamp(1))));
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  ASSERT_EQ(10, out_packets.size());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, out_packets[i].Get<int>());
+    EXPECT_EQ(Timestamp(100 + i), out_packets[i].Timestamp());
+  }
+  ASSERT_EQ(3, batch_size_packets.size());
+  EXPECT_EQ(4, batch_size_packets[0].Get<int>());
+  EXPECT_EQ(Timestamp(100), batch_size_packets[0].Timestamp());
+  EXPECT_EQ(4, batch_size_packets[1].Get<int>());
+  EXPECT_EQ(Timestamp(104), batch_size_packets[1].Timestamp());
+  EXPECT_EQ(2, batch_size_packets[2].Get<int>());
+  EXPECT_EQ(Timestamp(108), batch_size_packets[2].Timestamp());
+
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "count", MakePacket<int>(1).At(Timestamp(2))));
+  MP_ASSERT_OK(graph.CloseAllPacketSources());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(11, out_packets.size());
+  EXPECT_EQ(Timestamp(200), out_packets[10].Timestamp());
+  ASSERT_EQ(4, batch_size_packets.size());
+  EXPECT_EQ(1, batch_size_packets[3].Get<int>());
+}
+
+TEST(CalculatorGraph, DropsLateInputSetsFromBatches) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'timestamps'
+        node {
+          calculator: 'TimestampBurstCalculator'
+          input_stream: 'timestamps'
+          output_stream: 'burst'
+        }
+        node {
+          calculator: 'BatchPassThroughCalculator'
+          input_stream: 'IN:burst'
+          output_stream: 'OUT:out'
+          output_stream: 'BATCH_SIZE:batch_size'
+        }
+        deadline_config {
+          timestamp_offset_usec: 60000000
+          drop_late_packets: true
+        }
+      )pb");
+  std::vector<Packet> out_packets;
+  std::vector<Packet> batch_size_packets;
+  tool::AddVectorSink("out", &config, &out_packets);
+  tool::AddVectorSink("batch_size", &config, &batch_size_packets);
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  // The four input sets arrive together and form one batch. The first two
+  // are long past their deadlines and are dropped; the other two are
+  // processed.
+  const int64 now = absl::ToUnixMicros(absl::Now());
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "timestamps",
+      MakePacket<std::vector<int64>>(std::vector<int64>{1, 2, now + 1, now + 2})
+          .At(Timestamp(now))));
+  MP_ASSERT_OK(graph.CloseAllPacketSources());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(2, out_packets.size());
+  EXPECT_EQ(2, out_packets[0].Get<int>());
+  EXPECT_EQ(Timestamp(now + 1), out_packets[0].Timestamp());
+  EXPECT_EQ(3, out_packets[1].Get<int>());
+  EXPECT_EQ(Timestamp(now + 2), out_packets[1].Timestamp());
+  ASSERT_EQ(1, batch_size_packets.size());
+  EXPECT_EQ(2, batch_size_packets[0].Get<int>());
+  EXPECT_EQ(Timestamp(now + 1), batch_size_packets[0].Timestamp());
+}
+
+TEST(CalculatorGraph, SkipsBatchesWithOnlyLateInputSets) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'timestamps'
+        node {
+          calculator: 'TimestampBurstCalculator'
+          input_stream: 'timestamps'
+          output_stream: 'burst'
+        }
+        node {
+          calculator: 'BatchPassThroughCalculator'
+          input_stream: 'IN:burst'
+          output_stream: 'OUT:out'
+          output_stream: 'BATCH_SIZE:batch_size'
+        }
+        deadline_config {
+          timestamp_offset_usec: 60000000
+          drop_late_packets: true
+        }
+      )pb");
+  std::vector<Packet> out_packets;
+  std::vector<Packet> batch_size_packets;
+  tool::AddVectorSink("out", &config, &out_packets);
+  tool::AddVectorSink("batch_size", &config, &batch_size_packets);
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  // All three input sets of the batch are long past their deadlines, so
+  // Process() is not called at all.
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "timestamps",
+      MakePacket<std::vector<int64>>(std::vector<int64>{1, 2, 3})
+          .At(Timestamp(3))));
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  EXPECT_TRUE(out_packets.empty());
+  EXPECT_TRUE(batch_size_packets.empty());
+
+  // Later input sets are still processed.
+  const int64 now = absl::ToUnixMicros(absl::Now());
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "timestamps", MakePacket<std::vector<int64>>(std::vector<int64>{now + 1})
+                        .At(Timestamp(now))));
+  MP_ASSERT_OK(graph.CloseAllPacketSources());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(1, out_packets.size());
+  EXPECT_EQ(Timestamp(now + 1), out_packets[0].Timestamp());
+  ASSERT_EQ(1, batch_size_packets.size());
+  EXPECT_EQ(1, batch_size_packets[0].Get<int>());
+}
+
+TEST(CalculatorGraph, BatchedProcessRejectsParallelExecution) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        node {
+          calculator: 'BatchPassThroughCalculator'
+          input_stream: 'IN:in'
+          output_stream: 'OUT:out'
+          output_stream: 'BATCH_SIZE:batch_size'
+          max_in_flight: 2
+        }
+      )pb");
+  CalculatorGraph graph;
+  EXPECT_FALSE(graph.Initialize(config).ok());
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/calculator_node.h"
 
+#include <algorithm>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -29,6 +30,7 @@
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/counter_factory.h"
+#include "mediapipe/framework/deadline_tracker.h"
 #include "mediapipe/framework/input_stream_manager.h"
 #include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/output_stream_manager.h"
@@ -133,6 +135,7 @@ absl::Status CalculatorNode::Initialize(
     node_config = &validated_graph_->Config().node(node_ref.index);
     name_ = tool::CanonicalNodeName(validated_graph_->Config(), node_ref.index);
     node_type_info_ = &validated_graph_->CalculatorInfos()[node_ref.index];
+    fused_unit_head_ = validated_graph_->FusedUnitHead(node_ref.index);
   } else if (node_ref.type == NodeTypeInfo::NodeType::PACKET_GENERATOR) {
     const PacketGeneratorConfig& pg_config =
         validated_graph_->Config().packet_generator(node_ref.index);
@@ -208,6 +211,16 @@ absl::Status CalculatorNode::Initialize(
   }
   input_stream_handler_->SetProcessTimestampBounds(
       contract.GetProcessTimestampBounds());
+  max_batch_size_ = std::max(contract.GetMaxBatchSize(), 1);
+  if (max_batch_size_ > 1) {
+    RET_CHECK_EQ(max_in_flight_, 1)
+        << "Calculator \"" << DebugName()
+        << "\" sets a max batch size and cannot run with max_in_flight > 1.";
+    MP_RETURN_IF_ERROR(input_stream_handler_->SetMaxBatchSize(max_batch_size_));
+  }
+  // Source nodes are not triggered by a producer, so they always go through
+  // the scheduler queue.
+  run_inline_ = contract.GetRunInline() && !IsSource();
 
   return InitializeInputStreams(input_stream_managers, output_stream_managers);
 }
@@ -274,6 +287,14 @@ absl::Status CalculatorNode::InitializeInputStreams(
   MP_RETURN_IF_ERROR(input_stream_handler_->InitializeInputStreamManagers(
       current_input_stream_managers));
 
+  // The input streams are consumed by this node's scheduling loop, which runs
+  // on one thread at a time, unless the handler fills the input sets on the
+  // calculator's threads. The GraphTracer also reads the queues from the
+  // producer's thread.
+  const bool single_consumer =
+      !input_stream_handler_->LatePreparation() &&
+      !validated_graph_->Config().profiler_config().trace_enabled();
+
   // Set all the mirrors.
   for (CollectionItemId id = node_type_info_->InputStreamTypes().BeginId();
        id < node_type_info_->InputStreamTypes().EndId(); ++id) {
@@ -283,6 +304,14 @@ absl::Status CalculatorNode::InitializeInputStreams(
                                  id.value()]
             .upstream;
     RET_CHECK_LE(0, output_stream_index);
+    // Packets from another calculator are propagated by that calculator's
+    // OutputStreamHandler, one invocation at a time. Graph input streams can
+    // be fed from any application thread.
+    const bool single_producer =
+        validated_graph_->OutputStreamInfos()[output_stream_index]
+            .parent_node.type == NodeTypeInfo::NodeType::CALCULATOR;
+    current_input_stream_managers[id.value()].SetSingleProducerSingleConsumer(
+        single_producer && single_consumer);
     OutputStreamManager* origin_output_stream_manager =
         &output_stream_managers[output_stream_index];
     VLOG(2) << "Adding mirror for input stream with id " << id.value()
@@ -389,6 +418,8 @@ absl::Status CalculatorNode::PrepareForRun(
       [this]() { CalculatorNode::InputStreamHeadersReady(); },
       [this]() { CalculatorNode::CheckIfBecameReady(); },
       std::move(schedule_callback), error_callback);
+  input_stream_handler_->SetTrackPeakQueueSizes(
+      profiling_context_ && profiling_context_->IsSchedulerTelemetryEnabled());
   output_stream_handler_->PrepareForRun(error_callback);
 
   const auto& contract = Contract();
@@ -474,6 +505,18 @@ bool CalculatorNode::OutputsAreConstant(CalculatorContext* cc) {
   return true;
 }
 
+bool CalculatorNode::DropIfPastDeadline(CalculatorContext* cc) {
+  if (deadlines_ == nullptr || !deadlines_->enabled() ||
+      !deadlines_->IsLate(cc->InputTimestamp())) {
+    return false;
+  }
+  const bool drop = deadlines_->drop_late_packets();
+  if (profiling_context_) {
+    profiling_context_->AddDeadlineMiss(*cc, drop);
+  }
+  return drop;
+}
+
 absl::Status CalculatorNode::OpenNode() {
   VLOG(2) << "CalculatorNode::OpenNode() for " << DebugName();
 
@@ -842,6 +885,16 @@ absl::Status CalculatorNode::ProcessNode(
     absl::Status result =
         absl::InternalError("Calculator context has no input packets.");
 
+    if (profiling_context_ &&
+        profiling_context_->IsRecordingSchedulerTelemetry()) {
+      profiling_context_->AddInputQueueSizes(
+          *calculator_context, input_stream_handler_->TakePeakQueueSizes());
+    }
+
+    if (max_batch_size_ > 1) {
+      return ProcessBatch(calculator_context);
+    }
+
     int num_invocations = calculator_context_manager_.NumberOfContextTimestamps(
         *calculator_context);
     RET_CHECK(num_invocations <= 1 || max_in_flight_ <= 1)
@@ -860,6 +913,10 @@ absl::Status CalculatorNode::ProcessNode(
         if (OutputsAreConstant(calculator_context)) {
           // Do nothing.
           result = absl::OkStatus();
+        } else if (DropIfPastDeadline(calculator_context)) {
+          // Dropped: the timestamp is skipped as if Process() produced no
+          // outputs.
+          result = absl::OkStatus();
         } else {
           MEDIAPIPE_PROFILING(PROCESS, calculator_context);
           LegacyCalculatorSupport::Scoped<CalculatorContext> s(
@@ -907,6 +964,88 @@ absl::Status CalculatorNode::ProcessNode(
   }
 }
 
+absl::Status CalculatorNode::ProcessBatch(
+    CalculatorContext* calculator_context) {
+  OutputStreamShardSet* const outputs = &calculator_context->Outputs();
+  const int num_timestamps =
+      calculator_context_manager_.NumberOfContextTimestamps(
+          *calculator_context);
+  if (num_timestamps == 0) {
+    return absl::InternalError("Calculator context has no input packets.");
+  }
+  // The input sets of the batch may be followed by Timestamp::Done().
+  int batch_size = 0;
+  while (batch_size < num_timestamps &&
+         calculator_context->BatchTimestamp(batch_size).IsAllowedInStream()) {
+    ++batch_size;
+  }
+
+  if (batch_size > 0) {
+    const Timestamp last_timestamp =
+        calculator_context->BatchTimestamp(batch_size - 1);
+    // Deadlines follow the input timestamps, so the late input sets are at
+    // the front of the batch. Drop them one by one and process the rest.
+    int num_dropped = 0;
+    while (num_dropped < batch_size &&
+           DropIfPastDeadline(calculator_context)) {
+      input_stream_handler_->ClearCurrentInputs(calculator_context);
+      ++num_dropped;
+    }
+    const int num_to_process = batch_size - num_dropped;
+    if (num_to_process == 0) {
+      // Every input set was late, so there is nothing to process. Only the
+      // output timestamp bounds move past the dropped input sets.
+      output_stream_handler_->PostProcess(last_timestamp);
+    } else {
+      output_stream_handler_->PrepareOutputs(
+          calculator_context->InputTimestamp(), outputs);
+
+      VLOG(2) << "Calling Calculator::Process() for node: " << DebugName()
+              << " timestamps: " << calculator_context->InputTimestamp()
+              << " to " << last_timestamp;
+
+      absl::Status result;
+      calculator_context_manager_.SetContextBatchSize(calculator_context,
+                                                      num_to_process);
+      if (OutputsAreConstant(calculator_context)) {
+        // Do nothing.
+        result = absl::OkStatus();
+      } else {
+        MEDIAPIPE_PROFILING(PROCESS, calculator_context);
+        LegacyCalculatorSupport::Scoped<CalculatorContext> s(
+            calculator_context);
+        result = calculator_->Process(calculator_context);
+      }
+      calculator_context_manager_.SetContextBatchSize(calculator_context, 1);
+
+      for (int i = 0; i < num_to_process; ++i) {
+        input_stream_handler_->ClearCurrentInputs(calculator_context);
+      }
+      if (!result.ok() && result != tool::StatusStop()) {
+        return mediapipe::StatusBuilder(result, MEDIAPIPE_LOC).SetPrepend()
+               << absl::Substitute(
+                      "Calculator::Process() for node \"$0\" failed: ",
+                      DebugName());
+      }
+      // The output timestamp bounds follow the last input set of the batch.
+      output_stream_handler_->PostProcess(last_timestamp);
+      if (result == tool::StatusStop()) {
+        return result;
+      }
+    }
+  }
+
+  if (batch_size < num_timestamps) {
+    const Timestamp input_timestamp = calculator_context->InputTimestamp();
+    RET_CHECK(input_timestamp == Timestamp::Done() &&
+              batch_size + 1 == num_timestamps)
+        << "Invalid input timestamp in ProcessNode(). timestamp: "
+        << input_timestamp;
+    return CloseNode(absl::OkStatus(), /*graph_run_ended=*/false);
+  }
+  return absl::OkStatus();
+}
+
 void CalculatorNode::SetQueueSizeCallbacks(
     InputStreamManager::QueueSizeCallback becomes_full_callback,
     InputStreamManager::QueueSizeCallback becomes_not_full_callback) {
@@ -57,6 +57,7 @@ class InputStreamManager;
 class OutputStreamManager;
 
 namespace internal {
+class DeadlineTracker;
 class SchedulerQueue;
 }  // namespace internal
 
@@ -95,6 +96,14 @@ class CalculatorNode {
   // Changes the executor a node is assigned to.
   void SetExecutor(const std::string& executor);
 
+  // Returns true if the node may run on the thread that made its inputs
+  // ready. See CalculatorContract::SetRunInline.
+  bool RunsInline() const { return run_inline_; }
+
+  // Returns the id of the first node of the fused unit containing this node.
+  // See ValidatedGraphConfig::FusedUnitHead.
+  int FusedUnitHead() const { return fused_unit_head_; }
+
   // Calls Process() on the Calculator corresponding to this node.
   absl::Status ProcessNode(CalculatorContext* calculator_context);
 
@@ -204,6 +213,12 @@ class CalculatorNode {
     scheduler_queue_ = queue;
   }
 
+  // Sets the deadlines of the input sets of the graph. Input sets whose
+  // deadline has passed are counted and, if configured, dropped.
+  void SetDeadlineTracker(const internal::DeadlineTracker* deadlines) {
+    deadlines_ = deadlines;
+  }
+
   // Sets callbacks in the scheduler that should be invoked when an input queue
   // becomes full/non-full.
   void SetQueueSizeCallbacks(
@@ -286,6 +301,17 @@ class CalculatorNode {
   // Returns true if all outputs will be identical to the previous graph run.
   bool OutputsAreConstant(CalculatorContext* cc);
 
+  // Returns true if the input set of "cc" should be dropped because its
+  // deadline has passed. Records the deadline miss with the profiler.
+  bool DropIfPastDeadline(CalculatorContext* cc);
+
+  // Calls Calculator::Process() once for all the input sets in "cc", and then
+  // Calculator::Close() if the input sets are followed by Timestamp::Done().
+  // Input sets past their deadline are dropped from the front of the batch
+  // one at a time, and Process() is skipped if none remains. Used when
+  // max_batch_size_ is greater than 1.
+  absl::Status ProcessBatch(CalculatorContext* cc);
+
   // The calculator.
   std::unique_ptr<CalculatorBase> calculator_;
   // Keeps data which a Calculator subclass needs access to.
@@ -310,6 +336,12 @@ class CalculatorNode {
 
   // The max number of invocations that can be scheduled in parallel.
   int max_in_flight_ = 1;
+  // The max number of input sets passed to a single call to Process().
+  int max_batch_size_ = 1;
+  // True if the node may run on the thread that made its inputs ready.
+  bool run_inline_ = false;
+  // The id of the first node of the fused unit containing this node.
+  int fused_unit_head_ = -1;
   // The following two variables are used for the concurrency control of node
   // scheduling.
   //
@@ -371,6 +403,8 @@ class CalculatorNode {
 
   internal::SchedulerQueue* scheduler_queue_ = nullptr;
 
+  const internal::DeadlineTracker* deadlines_ = nullptr;
+
   const ValidatedGraphConfig* validated_graph_ = nullptr;
 
   const NodeTypeInfo* node_type_info_ = nullptr;
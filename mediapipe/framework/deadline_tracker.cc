@@ -0,0 +1,86 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deadline_tracker.h"
+
+#include "absl/time/clock.h"
+#include "mediapipe/framework/port/canonical_errors.h"
+#include "mediapipe/framework/port/status_builder.h"
+
+namespace mediapipe {
+namespace internal {
+
+absl::Status DeadlineTracker::Configure(const DeadlineConfig& config) {
+  if (config.timestamp_offset_usec() < 0 ||
+      config.wall_time_budget_usec() < 0) {
+    return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "The deadline offsets in DeadlineConfig must not be negative.";
+  }
+  if (config.timestamp_offset_usec() > 0 &&
+      config.wall_time_budget_usec() > 0) {
+    return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "DeadlineConfig must not set both timestamp_offset_usec and "
+              "wall_time_budget_usec.";
+  }
+  if (!(config.timestamp_offset_usec() > 0 ||
+        config.wall_time_budget_usec() > 0) &&
+      (config.earliest_deadline_first() || config.drop_late_packets())) {
+    return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "DeadlineConfig enables earliest_deadline_first or "
+              "drop_late_packets without setting timestamp_offset_usec or "
+              "wall_time_budget_usec.";
+  }
+  timestamp_offset_usec_ = config.timestamp_offset_usec();
+  budget_usec_ = config.wall_time_budget_usec();
+  earliest_deadline_first_ = config.earliest_deadline_first();
+  drop_late_packets_ = config.drop_late_packets();
+  return absl::OkStatus();
+}
+
+void DeadlineTracker::Reset() {
+  absl::MutexLock lock(&mutex_);
+  arrival_times_.clear();
+}
+
+void DeadlineTracker::RecordArrival(Timestamp timestamp) {
+  if (budget_usec_ <= 0 || !timestamp.IsRangeValue()) return;
+  const int64 now = NowUsec();
+  absl::MutexLock lock(&mutex_);
+  if (!arrival_times_.emplace(timestamp, now).second) return;
+  if (arrival_times_.size() > kMaxTrackedTimestamps) {
+    arrival_times_.erase(arrival_times_.begin());
+  }
+}
+
+int64 DeadlineTracker::Deadline(Timestamp timestamp) const {
+  if (!timestamp.IsRangeValue()) return kNoDeadline;
+  if (timestamp_offset_usec_ > 0) {
+    if (timestamp.Value() > kNoDeadline - timestamp_offset_usec_) {
+      return kNoDeadline;
+    }
+    return timestamp.Value() + timestamp_offset_usec_;
+  }
+  if (budget_usec_ > 0) {
+    absl::MutexLock lock(&mutex_);
+    auto iter = arrival_times_.find(timestamp);
+    if (iter != arrival_times_.end()) return iter->second + budget_usec_;
+  }
+  return kNoDeadline;
+}
+
+// static
+int64 DeadlineTracker::NowUsec() { return absl::ToUnixMicros(absl::Now()); }
+
+}  // namespace internal
+}  // namespace mediapipe
@@ -0,0 +1,95 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_DEADLINE_TRACKER_H_
+#define MEDIAPIPE_FRAMEWORK_DEADLINE_TRACKER_H_
+
+#include <limits>
+#include <map>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+namespace internal {
+
+// Computes the deadlines of input sets according to the DeadlineConfig of a
+// graph. Deadlines are wall times in microseconds since the Unix epoch.
+//
+// Configure() must be called before the graph runs. The other methods are
+// thread-safe.
+class DeadlineTracker {
+ public:
+  // The deadline of an input set that has none.
+  static constexpr int64 kNoDeadline = std::numeric_limits<int64>::max();
+
+  // The number of timestamps whose arrival time is remembered in wall-clock
+  // budget mode. Older arrival times are forgotten first.
+  static constexpr int kMaxTrackedTimestamps = 1024;
+
+  // Validates and applies the config.
+  absl::Status Configure(const DeadlineConfig& config);
+
+  // Returns true if input sets can have deadlines.
+  bool enabled() const {
+    return timestamp_offset_usec_ > 0 || budget_usec_ > 0;
+  }
+
+  bool earliest_deadline_first() const {
+    return enabled() && earliest_deadline_first_;
+  }
+
+  bool drop_late_packets() const { return enabled() && drop_late_packets_; }
+
+  // Forgets the arrival times recorded in a previous run.
+  void Reset() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Records that a packet with the given timestamp entered the graph. Only
+  // the first arrival of each timestamp counts. No-op unless a wall-clock
+  // budget is configured.
+  void RecordArrival(Timestamp timestamp) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the deadline of the input set with the given timestamp, or
+  // kNoDeadline.
+  int64 Deadline(Timestamp timestamp) const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns true if the deadline of the input set with the given timestamp
+  // has passed.
+  bool IsLate(Timestamp timestamp) const {
+    const int64 deadline = Deadline(timestamp);
+    return deadline != kNoDeadline && NowUsec() > deadline;
+  }
+
+  // Returns the current wall time in microseconds since the Unix epoch.
+  static int64 NowUsec();
+
+ private:
+  int64 timestamp_offset_usec_ = 0;
+  int64 budget_usec_ = 0;
+  bool earliest_deadline_first_ = false;
+  bool drop_late_packets_ = false;
+
+  mutable absl::Mutex mutex_;
+  // Maps a timestamp to the wall time at which it entered the graph.
+  std::map<Timestamp, int64> arrival_times_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace internal
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_DEADLINE_TRACKER_H_
@@ -0,0 +1,113 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deadline_tracker.h"
+
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace internal {
+namespace {
+
+TEST(DeadlineTrackerTest, DisabledByDefault) {
+  DeadlineTracker deadlines;
+  MP_ASSERT_OK(deadlines.Configure(DeadlineConfig()));
+  EXPECT_FALSE(deadlines.enabled());
+  EXPECT_FALSE(deadlines.earliest_deadline_first());
+  EXPECT_EQ(deadlines.Deadline(Timestamp(5)), DeadlineTracker::kNoDeadline);
+  EXPECT_FALSE(deadlines.IsLate(Timestamp(5)));
+}
+
+TEST(DeadlineTrackerTest, RejectsInvalidConfigs) {
+  DeadlineTracker deadlines;
+  EXPECT_FALSE(deadlines
+                   .Configure(ParseTextProtoOrDie<DeadlineConfig>(R"pb(
+                     timestamp_offset_usec: 10 wall_time_budget_usec: 10
+                   )pb"))
+                   .ok());
+  EXPECT_FALSE(deadlines
+                   .Configure(ParseTextProtoOrDie<DeadlineConfig>(R"pb(
+                     timestamp_offset_usec: -1
+                   )pb"))
+                   .ok());
+  EXPECT_FALSE(deadlines
+                   .Configure(ParseTextProtoOrDie<DeadlineConfig>(R"pb(
+                     drop_late_packets: true
+                   )pb"))
+                   .ok());
+}
+
+TEST(DeadlineTrackerTest, TimestampOffset) {
+  DeadlineTracker deadlines;
+  MP_ASSERT_OK(deadlines.Configure(ParseTextProtoOrDie<DeadlineConfig>(R"pb(
+    timestamp_offset_usec: 1000 earliest_deadline_first: true
+  )pb")));
+  EXPECT_TRUE(deadlines.earliest_deadline_first());
+  EXPECT_FALSE(deadlines.drop_late_packets());
+  EXPECT_EQ(deadlines.Deadline(Timestamp(5)), 1005);
+  // Deadlines that would overflow are treated as no deadline.
+  EXPECT_EQ(deadlines.Deadline(Timestamp::Max()),
+            DeadlineTracker::kNoDeadline);
+  EXPECT_EQ(deadlines.Deadline(Timestamp::Unset()),
+            DeadlineTracker::kNoDeadline);
+  // Timestamp(5) is read as 5 microseconds after the Unix epoch.
+  EXPECT_TRUE(deadlines.IsLate(Timestamp(5)));
+  EXPECT_FALSE(deadlines.IsLate(
+      Timestamp(DeadlineTracker::NowUsec() + 60 * 1000 * 1000)));
+}
+
+TEST(DeadlineTrackerTest, WallTimeBudget) {
+  DeadlineTracker deadlines;
+  MP_ASSERT_OK(deadlines.Configure(ParseTextProtoOrDie<DeadlineConfig>(R"pb(
+    wall_time_budget_usec: 60000000 drop_late_packets: true
+  )pb")));
+  EXPECT_TRUE(deadlines.drop_late_packets());
+  // Timestamps that did not enter the graph have no deadline.
+  EXPECT_EQ(deadlines.Deadline(Timestamp(1)), DeadlineTracker::kNoDeadline);
+
+  const int64 before = DeadlineTracker::NowUsec();
+  deadlines.RecordArrival(Timestamp(1));
+  const int64 after = DeadlineTracker::NowUsec();
+  const int64 deadline = deadlines.Deadline(Timestamp(1));
+  EXPECT_GE(deadline, before + 60000000);
+  EXPECT_LE(deadline, after + 60000000);
+  EXPECT_FALSE(deadlines.IsLate(Timestamp(1)));
+
+  // Only the first arrival of a timestamp counts.
+  deadlines.RecordArrival(Timestamp(1));
+  EXPECT_EQ(deadlines.Deadline(Timestamp(1)), deadline);
+
+  deadlines.Reset();
+  EXPECT_EQ(deadlines.Deadline(Timestamp(1)), DeadlineTracker::kNoDeadline);
+}
+
+TEST(DeadlineTrackerTest, ForgetsOldestArrivals) {
+  DeadlineTracker deadlines;
+  MP_ASSERT_OK(deadlines.Configure(ParseTextProtoOrDie<DeadlineConfig>(R"pb(
+    wall_time_budget_usec: 1000
+  )pb")));
+  for (int i = 0; i <= DeadlineTracker::kMaxTrackedTimestamps; ++i) {
+    deadlines.RecordArrival(Timestamp(i));
+  }
+  EXPECT_EQ(deadlines.Deadline(Timestamp(0)), DeadlineTracker::kNoDeadline);
+  EXPECT_NE(deadlines.Deadline(Timestamp(1)), DeadlineTracker::kNoDeadline);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace mediapipe
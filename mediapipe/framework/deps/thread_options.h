@@ -26,7 +26,7 @@ namespace mediapipe {
 // the field descriptions.
 class ThreadOptions {
  public:
-  ThreadOptions() : stack_size_(0), nice_priority_level_(0) {}
+  ThreadOptions() : stack_size_(0), nice_priority_level_(0), numa_node_(-1) {}
 
   // Set the thread stack size (in bytes).  Passing stack_size==0 resets
   // the stack size to the default value for the system. The system default
@@ -51,6 +51,14 @@ class ThreadOptions {
     return *this;
   }
 
+  // Prefer allocating the memory first touched by the thread on the given
+  // NUMA node. A negative value (the default) keeps the system policy. This
+  // does not pin the thread; use set_cpu_set for that.
+  ThreadOptions& set_numa_node(int numa_node) {
+    numa_node_ = numa_node;
+    return *this;
+  }
+
   size_t stack_size() const { return stack_size_; }
 
   int nice_priority_level() const { return nice_priority_level_; }
@@ -59,11 +67,14 @@ class ThreadOptions {
 
   std::string name_prefix() const { return name_prefix_; }
 
+  int numa_node() const { return numa_node_; }
+
  private:
   size_t stack_size_;        // Size of thread stack
   int nice_priority_level_;  // Nice priority level of the workers
   std::set<int> cpu_set_;    // CPU set for affinity setting
   std::string name_prefix_;  // Name of the thread
+  int numa_node_;            // Preferred NUMA node for memory allocation
 };
 
 }  // namespace mediapipe
@@ -110,6 +110,11 @@ namespace internal {
 // name_prefix_long, 1234  -> name_prefix_lon
 std::string CreateThreadName(const std::string& prefix, int thread_id);
 
+// Sets the memory policy of the calling thread so that the pages it touches
+// first are preferably allocated on "numa_node". Returns false and logs an
+// error if the platform does not support it.
+bool PreferNumaNodeForCurrentThread(int numa_node);
+
 }  // namespace internal
 
 }  // namespace mediapipe
@@ -18,6 +18,12 @@
 #include <sys/syscall.h>
 #include <unistd.h>
 
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#endif  // __linux__
+
+#include <vector>
+
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "mediapipe/framework/deps/threadpool.h"
@@ -76,6 +82,12 @@ void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
     cpu_set_t cpu_set;
     CPU_ZERO(&cpu_set);
     for (const int cpu : selected_cpus) {
+      if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        LOG(ERROR) << "Ignoring processor " << cpu
+                   << ", which is outside of the supported range [0, "
+                   << CPU_SETSIZE << ").";
+        continue;
+      }
       CPU_SET(cpu, &cpu_set);
     }
     if (sched_setaffinity(syscall(SYS_gettid), sizeof(cpu_set_t), &cpu_set) !=
@@ -89,6 +101,10 @@ void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
                     "affinity setting for now.";
     }
   }
+  const int numa_node = thread->pool_->thread_options().numa_node();
+  if (numa_node >= 0) {
+    internal::PreferNumaNodeForCurrentThread(numa_node);
+  }
   int error = pthread_setname_np(pthread_self(), name.c_str());
   if (error != 0) {
     LOG(ERROR) << "Error : " << strerror(error) << std::endl
@@ -96,7 +112,8 @@ void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
   }
 #else
   const std::string name = internal::CreateThreadName(thread->name_prefix_, 0);
-  if (nice_priority_level != 0 || !selected_cpus.empty()) {
+  if (nice_priority_level != 0 || !selected_cpus.empty() ||
+      thread->pool_->thread_options().numa_node() >= 0) {
     LOG(ERROR) << "Thread priority and processor affinity feature aren't "
                   "supported on the current platform.";
   }
@@ -197,6 +214,27 @@ std::string CreateThreadName(const std::string& prefix, int thread_id) {
   return name;
 }
 
+bool PreferNumaNodeForCurrentThread(int numa_node) {
+#if defined(__linux__)
+  constexpr int kBitsPerWord = 8 * sizeof(unsigned long);  // NOLINT
+  std::vector<unsigned long> node_mask(  // NOLINT
+      numa_node / kBitsPerWord + 1, 0);
+  node_mask[numa_node / kBitsPerWord] = 1UL << (numa_node % kBitsPerWord);
+  // The kernel expects maxnode to be one more than the number of bits.
+  if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, node_mask.data(),
+              node_mask.size() * kBitsPerWord + 1) == 0) {
+    VLOG(1) << "Preferring memory from NUMA node " << numa_node << ".";
+    return true;
+  }
+  LOG(ERROR) << "Error : " << strerror(errno) << std::endl
+             << "Failed to prefer memory from NUMA node " << numa_node << ".";
+  return false;
+#else
+  LOG(ERROR) << "NUMA memory policy isn't supported on the current platform.";
+  return false;
+#endif  // __linux__
+}
+
 }  // namespace internal
 
 }  // namespace mediapipe
@@ -66,7 +66,8 @@ void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
   int nice_priority_level =
       thread->pool_->thread_options().nice_priority_level();
   const std::set<int> selected_cpus = thread->pool_->thread_options().cpu_set();
-  if (nice_priority_level != 0 || !selected_cpus.empty()) {
+  if (nice_priority_level != 0 || !selected_cpus.empty() ||
+      thread->pool_->thread_options().numa_node() >= 0) {
     LOG(ERROR) << "Thread priority and processor affinity feature aren't "
                   "supported by the std::thread threadpool implementation.";
   }
@@ -151,6 +152,12 @@ std::string CreateThreadName(const std::string& prefix, int thread_id) {
   return name;
 }
 
+bool PreferNumaNodeForCurrentThread(int numa_node) {
+  LOG(ERROR) << "NUMA memory policy isn't supported by the std::thread "
+                "threadpool implementation.";
+  return false;
+}
+
 }  // namespace internal
 
 }  // namespace mediapipe
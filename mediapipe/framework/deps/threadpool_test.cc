@@ -17,6 +17,7 @@
 #include <set>
 
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "mediapipe/framework/port/gtest.h"
 
 namespace mediapipe {
@@ -91,6 +92,57 @@ TEST(ThreadPoolTest, CreateWithCPUAffinity) {
   thread_pool.StartWorkers();
 }
 
+// Processors that a cpu_set_t cannot hold are ignored instead of being
+// written past its end.
+TEST(ThreadPoolTest, CreateWithOutOfRangeCPUAffinity) {
+  absl::Mutex mu;
+  int n = 10;
+  {
+    ThreadOptions thread_options =
+        ThreadOptions().set_cpu_set({0, 1 << 20});
+    ThreadPool thread_pool(thread_options, "testpool", 2);
+    thread_pool.StartWorkers();
+    for (int i = 0; i < 10; ++i) {
+      thread_pool.Schedule([&n, &mu]() {
+        absl::MutexLock l(&mu);
+        --n;
+      });
+    }
+  }
+  EXPECT_EQ(0, n);
+}
+
+TEST(ThreadPoolTest, CreateWithNumaNode) {
+  absl::Mutex mu;
+  int n = 100;
+  {
+    ThreadOptions thread_options = ThreadOptions().set_numa_node(0);
+    ThreadPool thread_pool(thread_options, "testpool", 10);
+    ASSERT_EQ(10, thread_pool.num_threads());
+    ASSERT_EQ(0, thread_pool.thread_options().numa_node());
+    thread_pool.StartWorkers();
+
+    // Preferring a NUMA node is best effort, so tasks run whether or not the
+    // platform supports it.
+    for (int i = 0; i < 100; ++i) {
+      thread_pool.Schedule([&n, &mu]() {
+        absl::MutexLock l(&mu);
+        --n;
+      });
+    }
+  }
+  EXPECT_EQ(0, n);
+}
+
+TEST(ThreadPoolTest, CreateWithNonexistentNumaNode) {
+  ThreadOptions thread_options = ThreadOptions().set_numa_node(1 << 20);
+  absl::Notification done;
+  ThreadPool thread_pool(thread_options, "testpool", 1);
+  thread_pool.StartWorkers();
+  thread_pool.Schedule([&done]() { done.Notify(); });
+  done.WaitForNotification();
+}
+
 TEST(ThreadPoolTest, CreateThreadName) {
   ASSERT_EQ("name_prefix/123", internal::CreateThreadName("name_prefix", 1234));
   ASSERT_EQ("name_prefix/123",
@@ -0,0 +1,393 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
+
+#include <errno.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
+
+#include <set>
+#include <utility>
+
+#include "absl/base/optimization.h"
+#include "absl/strings/str_join.h"
+#include "mediapipe/framework/deps/threadpool.h"
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Capacity of the per-worker deque. Must be a power of two. Tasks that do not
+// fit are pushed onto the worker's inbox instead.
+constexpr int64_t kDequeCapacity = 1024;
+constexpr int64_t kDequeMask = kDequeCapacity - 1;
+
+// Applies the nice priority level, the processor affinity, the NUMA memory
+// policy and the thread name to the calling thread.
+void ConfigureCurrentThread(const ThreadOptions& thread_options,
+                            const std::string& name_prefix) {
+#if defined(__linux__)
+  const std::string name =
+      internal::CreateThreadName(name_prefix, syscall(SYS_gettid));
+  const int nice_priority_level = thread_options.nice_priority_level();
+  if (nice_priority_level != 0) {
+    if (nice(nice_priority_level) != -1 || errno == 0) {
+      VLOG(1) << "Changed the nice priority level by " << nice_priority_level;
+    } else {
+      LOG(ERROR) << "Error : " << strerror(errno) << std::endl
+                 << "Could not change the nice priority level by "
+                 << nice_priority_level;
+    }
+  }
+  const std::set<int>& selected_cpus = thread_options.cpu_set();
+  if (!selected_cpus.empty()) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const int cpu : selected_cpus) {
+      if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        LOG(ERROR) << "Ignoring processor " << cpu
+                   << ", which is outside of the supported range [0, "
+                   << CPU_SETSIZE << ").";
+        continue;
+      }
+      CPU_SET(cpu, &cpu_set);
+    }
+    if (sched_setaffinity(syscall(SYS_gettid), sizeof(cpu_set_t), &cpu_set) !=
+            -1 ||
+        errno == 0) {
+      VLOG(1) << "Pinned the work stealing thread pool to processor "
+              << absl::StrJoin(selected_cpus, ", processor ") << ".";
+    } else {
+      LOG(ERROR) << "Error : " << strerror(errno) << std::endl
+                 << "Failed to set processor affinity. Ignore processor "
+                    "affinity setting for now.";
+    }
+  }
+  if (thread_options.numa_node() >= 0) {
+    internal::PreferNumaNodeForCurrentThread(thread_options.numa_node());
+  }
+  int error = pthread_setname_np(pthread_self(), name.c_str());
+  if (error != 0) {
+    LOG(ERROR) << "Error : " << strerror(error) << std::endl
+               << "Failed to set name for thread: " << name;
+  }
+#else
+  if (thread_options.nice_priority_level() != 0 ||
+      !thread_options.cpu_set().empty() || thread_options.numa_node() >= 0) {
+    LOG(ERROR) << "Thread priority and processor affinity feature aren't "
+                  "supported on the current platform.";
+  }
+#endif  // __linux__
+}
+
+}  // namespace
+
+struct WorkStealingThreadPool::Task {
+  std::function<void()> callback;
+  // Link in the inbox of a worker.
+  Task* next = nullptr;
+};
+
+// The task queues owned by one worker thread.
+//
+// The deque is the bounded variant of the Chase-Lev work-stealing deque, with
+// the memory orderings from "Correct and Efficient Work-Stealing for Weak
+// Memory Models" (Le et al., PPoPP 2013). Only the owning worker may call
+// Push and Pop; any thread may call Steal.
+//
+// The inbox is a lock-free stack that any thread may push onto. Tasks are
+// taken out of it all at once, which avoids the ABA problem of popping
+// individual elements.
+class WorkStealingThreadPool::Worker {
+ public:
+  Worker(const WorkStealingThreadPool* pool, uint32_t victim_seed)
+      : pool(pool), victim_seed(victim_seed) {}
+
+  // Owner only. Returns false if the deque is full.
+  bool Push(Task* task) {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    const int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top >= kDequeCapacity) {
+      return false;
+    }
+    buffer_[bottom & kDequeMask].store(task, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Owner only. Returns the most recently pushed task, or nullptr.
+  Task* Pop() {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      // The deque was empty.
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    Task* task = buffer_[bottom & kDequeMask].load(std::memory_order_relaxed);
+    if (top == bottom) {
+      // Last element: race against the thieves for it.
+      if (!top_.compare_exchange_strong(top, top + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        task = nullptr;
+      }
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return task;
+  }
+
+  // Any thread. Returns the least recently pushed task, or nullptr if the
+  // deque is empty or another thread won the race for the task.
+  Task* Steal() {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) {
+      return nullptr;
+    }
+    Task* task = buffer_[top & kDequeMask].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return task;
+  }
+
+  // Any thread.
+  void PushInbox(Task* task) {
+    Task* head = inbox_.load(std::memory_order_relaxed);
+    do {
+      task->next = head;
+    } while (!inbox_.compare_exchange_weak(head, task,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+  }
+
+  // Any thread. Returns the whole inbox in submission order.
+  Task* TakeInbox() {
+    if (inbox_.load(std::memory_order_relaxed) == nullptr) {
+      return nullptr;
+    }
+    Task* head = inbox_.exchange(nullptr, std::memory_order_acquire);
+    // Reverse the stack so that external submissions keep their order.
+    Task* reversed = nullptr;
+    while (head != nullptr) {
+      Task* next = head->next;
+      head->next = reversed;
+      reversed = head;
+      head = next;
+    }
+    return reversed;
+  }
+
+  // Deletes all tasks that were never run.
+  void DiscardAll() {
+    while (Task* task = Pop()) {
+      delete task;
+    }
+    Task* task = TakeInbox();
+    while (task != nullptr) {
+      Task* next = task->next;
+      delete task;
+      task = next;
+    }
+  }
+
+  // The pool this worker belongs to.
+  const WorkStealingThreadPool* const pool;
+  // Seed for picking steal victims; only used by the owner.
+  uint32_t victim_seed;
+
+ private:
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<int64_t> top_{0};
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<int64_t> bottom_{0};
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<Task*> inbox_{nullptr};
+  std::atomic<Task*> buffer_[kDequeCapacity] = {};
+};
+
+thread_local WorkStealingThreadPool::Worker*
+    WorkStealingThreadPool::current_worker_ = nullptr;
+
+WorkStealingThreadPool::WorkStealingThreadPool(int num_threads)
+    : WorkStealingThreadPool(ThreadOptions(), "", num_threads) {}
+
+WorkStealingThreadPool::WorkStealingThreadPool(const std::string& name_prefix,
+                                               int num_threads)
+    : WorkStealingThreadPool(ThreadOptions(), name_prefix, num_threads) {}
+
+WorkStealingThreadPool::WorkStealingThreadPool(
+    const ThreadOptions& thread_options, const std::string& name_prefix,
+    int num_threads)
+    : name_prefix_(name_prefix), thread_options_(thread_options) {
+  num_threads_ = (num_threads == 0) ? 1 : num_threads;
+  workers_.reserve(num_threads_);
+  for (int i = 0; i < num_threads_; ++i) {
+    workers_.push_back(std::make_unique<Worker>(this, i + 1));
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopped_ = true;
+    condition_.SignalAll();
+  }
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+  // Only non-empty if the workers were never started.
+  for (auto& worker : workers_) {
+    worker->DiscardAll();
+  }
+}
+
+void WorkStealingThreadPool::StartWorkers() {
+  threads_.reserve(num_threads_);
+  for (int i = 0; i < num_threads_; ++i) {
+    Worker* worker = workers_[i].get();
+    threads_.emplace_back([this, worker] {
+      ConfigureCurrentThread(thread_options_, name_prefix_);
+      RunWorker(worker);
+    });
+  }
+}
+
+void WorkStealingThreadPool::Schedule(std::function<void()> callback) {
+  Task* task = new Task{std::move(callback)};
+  Worker* self = current_worker_;
+  const bool is_own_worker = self != nullptr && self->pool == this;
+  if (!is_own_worker || !self->Push(task)) {
+    Worker* target =
+        is_own_worker
+            ? self
+            : workers_[next_inbox_.fetch_add(1, std::memory_order_relaxed) %
+                       workers_.size()]
+                  .get();
+    target->PushInbox(task);
+  }
+  // Pairs with the fence in RunWorker: either a parking worker sees the new
+  // task, or we see that it is parking and wake it up.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (num_parked_.load(std::memory_order_relaxed) > 0) {
+    WakeWorker();
+  }
+}
+
+int WorkStealingThreadPool::num_threads() const { return num_threads_; }
+
+const ThreadOptions& WorkStealingThreadPool::thread_options() const {
+  return thread_options_;
+}
+
+void WorkStealingThreadPool::WakeWorker() {
+  absl::MutexLock lock(&mutex_);
+  ++wake_epoch_;
+  condition_.Signal();
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::TakeInbox(
+    Worker* victim, Worker* self) {
+  Task* task = victim->TakeInbox();
+  if (task == nullptr) {
+    return nullptr;
+  }
+  Task* rest = task->next;
+  task->next = nullptr;
+  while (rest != nullptr) {
+    Task* next = rest->next;
+    rest->next = nullptr;
+    if (!self->Push(rest)) {
+      self->PushInbox(rest);
+    }
+    rest = next;
+  }
+  return task;
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::FindTask(Worker* self) {
+  if (Task* task = self->Pop()) {
+    return task;
+  }
+  if (Task* task = TakeInbox(self, self)) {
+    return task;
+  }
+  const int num_workers = workers_.size();
+  // A cheap xorshift to spread the thieves over the victims.
+  uint32_t seed = self->victim_seed;
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  self->victim_seed = seed;
+  for (int i = 0; i < num_workers; ++i) {
+    Worker* victim = workers_[(seed + i) % num_workers].get();
+    if (victim == self) continue;
+    if (Task* task = victim->Steal()) {
+      return task;
+    }
+    if (Task* task = TakeInbox(victim, self)) {
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+void WorkStealingThreadPool::RunWorker(Worker* self) {
+  current_worker_ = self;
+  while (true) {
+    Task* task = FindTask(self);
+    if (task == nullptr) {
+      int64_t epoch;
+      bool stopped;
+      {
+        absl::MutexLock lock(&mutex_);
+        num_parked_.fetch_add(1, std::memory_order_relaxed);
+        epoch = wake_epoch_;
+        stopped = stopped_;
+      }
+      // Pairs with the fence in Schedule.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      task = FindTask(self);
+      if (task == nullptr) {
+        if (stopped) {
+          num_parked_.fetch_sub(1, std::memory_order_relaxed);
+          break;
+        }
+        absl::MutexLock lock(&mutex_);
+        while (wake_epoch_ == epoch && !stopped_) {
+          condition_.Wait(&mutex_);
+        }
+      }
+      num_parked_.fetch_sub(1, std::memory_order_relaxed);
+      if (task == nullptr) continue;
+    }
+    task->callback();
+    delete task;
+  }
+  current_worker_ = nullptr;
+}
+
+}  // namespace mediapipe
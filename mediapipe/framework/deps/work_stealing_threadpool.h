@@ -0,0 +1,142 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
+#define MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/thread_options.h"
+
+namespace mediapipe {
+
+// A thread pool in which every worker thread owns its own task queue.
+//
+// Unlike ThreadPool, which funnels every callback through a single mutex,
+// WorkStealingThreadPool never takes a lock on the submission path:
+// - A callback scheduled from one of the pool's own worker threads is pushed
+//   onto that worker's bounded Chase-Lev deque.
+// - A callback scheduled from any other thread is pushed onto the lock-free
+//   inbox of one of the workers, chosen round-robin.
+// Idle workers steal from the other workers' deques and inboxes. The only
+// mutex is used to park and wake idle workers, so it is never touched while
+// all workers are busy.
+//
+// Callbacks are NOT run in FIFO order, even with a single thread. This is
+// fine for the MediaPipe scheduler, which orders the ready tasks itself and
+// only asks the executor to call TaskQueue::RunNextTask.
+//
+// The interface mirrors ThreadPool:
+//
+// {
+//   WorkStealingThreadPool pool("testpool", num_workers);
+//   pool.StartWorkers();
+//   for (int i = 0; i < N; ++i) {
+//     pool.Schedule([i]() { DoWork(i); });
+//   }
+// }
+//
+class WorkStealingThreadPool {
+ public:
+  // Create a thread pool that provides a concurrency of "num_threads"
+  // threads.
+  explicit WorkStealingThreadPool(int num_threads);
+  WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+  WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+  // Like the WorkStealingThreadPool(int num_threads) constructor, except that
+  // it also associates "name_prefix" with each of the threads in the pool.
+  WorkStealingThreadPool(const std::string& name_prefix, int num_threads);
+
+  // Create a thread pool that creates and can use up to "num_threads"
+  // threads.  Any standard thread options, such as stack size, should
+  // be passed via "thread_options".  "name_prefix" specifies the
+  // thread name prefix.
+  WorkStealingThreadPool(const ThreadOptions& thread_options,
+                         const std::string& name_prefix, int num_threads);
+
+  // Waits for closures (if any) to complete. May be called without
+  // having called StartWorkers(), in which case pending closures are
+  // discarded.
+  ~WorkStealingThreadPool();
+
+  // REQUIRES: StartWorkers has not been called
+  // Actually start the worker threads.
+  void StartWorkers();
+
+  // REQUIRES: StartWorkers has been called
+  // Add specified callback to the pool. Eventually a worker thread will run
+  // it.
+  void Schedule(std::function<void()> callback);
+
+  // Provided for debugging and testing only.
+  int num_threads() const;
+
+  // Standard thread options.  Use this accessor to get them.
+  const ThreadOptions& thread_options() const;
+
+ private:
+  struct Task;
+  class Worker;
+
+  // Runs callbacks until the pool is stopped and no callback is left.
+  void RunWorker(Worker* self);
+
+  // Returns the next task for "self", looking at its own deque and inbox
+  // first and then trying to steal from the other workers. Returns nullptr if
+  // no task was found.
+  Task* FindTask(Worker* self);
+
+  // Moves all tasks from the inbox of "victim" to "self" and returns one of
+  // them, or nullptr if the inbox was empty.
+  Task* TakeInbox(Worker* victim, Worker* self);
+
+  // Wakes up one parked worker.
+  void WakeWorker();
+
+  // The worker running on the current thread, or nullptr if the current
+  // thread is not a worker of any WorkStealingThreadPool.
+  static thread_local Worker* current_worker_;
+
+  std::string name_prefix_;
+  int num_threads_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  // Index of the worker that receives the next external submission.
+  std::atomic<uint32_t> next_inbox_{0};
+  // Number of workers that are parked or about to park.
+  std::atomic<int> num_parked_{0};
+
+  absl::Mutex mutex_;
+  absl::CondVar condition_;
+  bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
+  // Incremented on every wake-up so that a parking worker can tell whether a
+  // task was published after it last looked at the queues.
+  int64_t wake_epoch_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  ThreadOptions thread_options_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_DEPS_WORK_STEALING_THREADPOOL_H_
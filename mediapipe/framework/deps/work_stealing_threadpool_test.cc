@@ -0,0 +1,167 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deps/work_stealing_threadpool.h"
+
+#include <atomic>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/threadpool.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(WorkStealingThreadPoolTest, DestroyWithoutStart) {
+  WorkStealingThreadPool thread_pool("testpool", 10);
+}
+
+TEST(WorkStealingThreadPoolTest, DestroyWithoutStartDiscardsTasks) {
+  int n = 0;
+  {
+    WorkStealingThreadPool thread_pool("testpool", 2);
+    thread_pool.Schedule([&n]() { ++n; });
+  }
+  EXPECT_EQ(0, n);
+}
+
+TEST(WorkStealingThreadPoolTest, EmptyThread) {
+  WorkStealingThreadPool thread_pool("testpool", 0);
+  ASSERT_EQ(1, thread_pool.num_threads());
+  thread_pool.StartWorkers();
+}
+
+TEST(WorkStealingThreadPoolTest, SingleThread) {
+  absl::Mutex mu;
+  int n = 100;
+  {
+    WorkStealingThreadPool thread_pool("testpool", 1);
+    ASSERT_EQ(1, thread_pool.num_threads());
+    thread_pool.StartWorkers();
+
+    for (int i = 0; i < 100; ++i) {
+      thread_pool.Schedule([&n, &mu]() mutable {
+        absl::MutexLock l(&mu);
+        --n;
+      });
+    }
+  }
+
+  EXPECT_EQ(0, n);
+}
+
+TEST(WorkStealingThreadPoolTest, MultiThreads) {
+  absl::Mutex mu;
+  int n = 100;
+  {
+    WorkStealingThreadPool thread_pool("testpool", 10);
+    ASSERT_EQ(10, thread_pool.num_threads());
+    thread_pool.StartWorkers();
+
+    for (int i = 0; i < 100; ++i) {
+      thread_pool.Schedule([&n, &mu]() mutable {
+        absl::MutexLock l(&mu);
+        --n;
+      });
+    }
+  }
+
+  EXPECT_EQ(0, n);
+}
+
+// Tasks that schedule more tasks go through the worker-local deques, and
+// overflow into the inboxes once a deque is full.
+TEST(WorkStealingThreadPoolTest, NestedSchedule) {
+  constexpr int kNumRoots = 8;
+  constexpr int kNumChildren = 5000;
+  std::atomic<int> n{0};
+  {
+    WorkStealingThreadPool thread_pool("testpool", 4);
+    thread_pool.StartWorkers();
+    for (int i = 0; i < kNumRoots; ++i) {
+      thread_pool.Schedule([&thread_pool, &n]() {
+        for (int j = 0; j < kNumChildren; ++j) {
+          thread_pool.Schedule([&n]() { n.fetch_add(1); });
+        }
+      });
+    }
+  }
+  EXPECT_EQ(kNumRoots * kNumChildren, n.load());
+}
+
+// Workers must wake up for tasks scheduled after they have gone idle.
+TEST(WorkStealingThreadPoolTest, ScheduleAfterIdle) {
+  WorkStealingThreadPool thread_pool("testpool", 4);
+  thread_pool.StartWorkers();
+  for (int round = 0; round < 100; ++round) {
+    absl::BlockingCounter counter(10);
+    for (int i = 0; i < 10; ++i) {
+      thread_pool.Schedule([&counter]() { counter.DecrementCount(); });
+    }
+    counter.Wait();
+  }
+}
+
+TEST(WorkStealingThreadPoolTest, CreateWithThreadOptions) {
+  ThreadOptions thread_options = ThreadOptions().set_nice_priority_level(1);
+  WorkStealingThreadPool thread_pool(thread_options, "testpool", 10);
+  ASSERT_EQ(10, thread_pool.num_threads());
+  ASSERT_EQ(1, thread_pool.thread_options().nice_priority_level());
+  thread_pool.StartWorkers();
+}
+
+// Core-scaling benchmark against ThreadPool. Every task schedules
+// state.range(1) follow-up tasks from the worker thread, which is the pattern
+// the MediaPipe scheduler produces when a finished node makes its successors
+// ready.
+template <typename Pool>
+void BM_ScheduleFanOut(benchmark::State& state) {
+  const int num_threads = state.range(0);
+  const int fan_out = state.range(1);
+  constexpr int kNumRoots = 256;
+  Pool pool("bm_pool", num_threads);
+  pool.StartWorkers();
+  for (auto _ : state) {
+    absl::BlockingCounter counter(kNumRoots * (fan_out + 1));
+    for (int i = 0; i < kNumRoots; ++i) {
+      pool.Schedule([&pool, &counter, fan_out]() {
+        for (int j = 0; j < fan_out; ++j) {
+          pool.Schedule([&counter]() { counter.DecrementCount(); });
+        }
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kNumRoots * (fan_out + 1));
+}
+
+void ScalingArgs(benchmark::internal::Benchmark* b) {
+  for (int num_threads : {1, 2, 4, 8, 16, 32, 64}) {
+    b->Args({num_threads, 0});
+    b->Args({num_threads, 16});
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_ScheduleFanOut, ThreadPool)
+    ->Apply(ScalingArgs)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ScheduleFanOut, WorkStealingThreadPool)
+    ->Apply(ScalingArgs)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,260 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/fair_share_executor.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/fair_share_executor.pb.h"
+#include "mediapipe/framework/port/canonical_errors.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Weight of the latest task in FairShareExecutorPool::Client's
+// average_task_time.
+constexpr double kTaskTimeSmoothing = 0.125;
+
+// Returns the CPU time consumed by the calling thread, in nanoseconds. Falls
+// back to the wall time where thread CPU clocks are not available.
+int64 ThreadCpuTimeNanos() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+    return absl::ToInt64Nanoseconds(absl::DurationFromTimespec(ts));
+  }
+#endif
+  return absl::GetCurrentTimeNanos();
+}
+
+// The pool whose task the current thread is running, if any.
+thread_local const FairShareExecutorPool* current_pool = nullptr;
+
+absl::Mutex registry_mutex(absl::kConstInit);
+
+absl::flat_hash_map<std::string, std::weak_ptr<FairShareExecutorPool>>&
+PoolRegistry() ABSL_EXCLUSIVE_LOCKS_REQUIRED(registry_mutex) {
+  static auto* registry = new absl::flat_hash_map<
+      std::string, std::weak_ptr<FairShareExecutorPool>>();
+  return *registry;
+}
+
+}  // namespace
+
+// static
+std::shared_ptr<FairShareExecutorPool> FairShareExecutorPool::Create(
+    const ThreadOptions& thread_options, int num_threads) {
+  // The last reference can be dropped by a task of the pool, e.g. when a graph
+  // is destroyed from one of its callbacks. The destructor joins the worker
+  // threads, so it then runs on a thread of its own.
+  return std::shared_ptr<FairShareExecutorPool>(
+      new FairShareExecutorPool(thread_options, num_threads),
+      [](FairShareExecutorPool* pool) {
+        if (current_pool == pool) {
+          std::thread([pool] { delete pool; }).detach();
+        } else {
+          delete pool;
+        }
+      });
+}
+
+// static
+std::shared_ptr<FairShareExecutorPool> FairShareExecutorPool::GetOrCreate(
+    const std::string& name, const ThreadOptions& thread_options,
+    int num_threads) {
+  absl::MutexLock lock(&registry_mutex);
+  std::weak_ptr<FairShareExecutorPool>& entry = PoolRegistry()[name];
+  std::shared_ptr<FairShareExecutorPool> pool = entry.lock();
+  if (pool == nullptr) {
+    pool = Create(thread_options, num_threads);
+    entry = pool;
+  } else if (pool->num_threads() != num_threads) {
+    LOG(WARNING) << "FairShareExecutorPool \"" << name << "\" already exists "
+                 << "with " << pool->num_threads() << " threads; ignoring "
+                 << "the request for " << num_threads << " threads.";
+  }
+  return pool;
+}
+
+FairShareExecutorPool::FairShareExecutorPool(
+    const ThreadOptions& thread_options, int num_threads)
+    : thread_pool_(thread_options,
+                   thread_options.name_prefix().empty()
+                       ? "mediapipe"
+                       : thread_options.name_prefix(),
+                   num_threads) {
+  thread_pool_.StartWorkers();
+  VLOG(2) << "Started fair share thread pool with "
+          << thread_pool_.num_threads() << " threads.";
+}
+
+FairShareExecutorPool::~FairShareExecutorPool() {
+  VLOG(2) << "Terminating fair share thread pool.";
+}
+
+std::unique_ptr<FairShareExecutor> FairShareExecutorPool::CreateExecutor(
+    const std::string& name, double weight) {
+  CHECK_GT(weight, 0.0) << "The weight of FairShareExecutor \"" << name
+                        << "\" must be positive.";
+  auto client = std::make_shared<Client>();
+  client->stats.name = name;
+  client->stats.weight = weight;
+  {
+    absl::MutexLock lock(&mutex_);
+    client->id = next_client_id_++;
+    clients_.push_back(client);
+  }
+  return absl::WrapUnique(
+      new FairShareExecutor(shared_from_this(), std::move(client)));
+}
+
+std::vector<FairShareExecutorStats> FairShareExecutorPool::GetStats() const {
+  absl::MutexLock lock(&mutex_);
+  std::vector<FairShareExecutorStats> stats;
+  stats.reserve(clients_.size());
+  for (const auto& client : clients_) {
+    stats.push_back(client->stats);
+    stats.back().num_tasks_queued = client->tasks.size();
+  }
+  return stats;
+}
+
+void FairShareExecutorPool::AddTask(const std::shared_ptr<Client>& client,
+                                    std::function<void()> task) {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (client->tasks.empty()) {
+      // A client that was idle starts at the current virtual time instead of
+      // catching up on the CPU time it did not use.
+      client->virtual_time = std::max(client->virtual_time, virtual_clock_);
+      ready_clients_.insert(client);
+    }
+    client->tasks.push_back(std::move(task));
+  }
+  thread_pool_.Schedule([this] { RunNextTask(); });
+}
+
+void FairShareExecutorPool::RemoveClient(
+    const std::shared_ptr<Client>& client) {
+  absl::MutexLock lock(&mutex_);
+  if (!client->tasks.empty()) {
+    LOG(ERROR) << "FairShareExecutor \"" << client->stats.name
+               << "\" destroyed with " << client->tasks.size()
+               << " pending tasks.";
+    ready_clients_.erase(client);
+    client->tasks.clear();
+  }
+  clients_.erase(std::find(clients_.begin(), clients_.end(), client));
+}
+
+void FairShareExecutorPool::SetWeight(const std::shared_ptr<Client>& client,
+                                      double weight) {
+  CHECK_GT(weight, 0.0);
+  absl::MutexLock lock(&mutex_);
+  client->stats.weight = weight;
+}
+
+FairShareExecutorStats FairShareExecutorPool::GetClientStats(
+    const std::shared_ptr<Client>& client) const {
+  absl::MutexLock lock(&mutex_);
+  FairShareExecutorStats stats = client->stats;
+  stats.num_tasks_queued = client->tasks.size();
+  return stats;
+}
+
+void FairShareExecutorPool::RunNextTask() {
+  std::shared_ptr<Client> client;
+  std::function<void()> task;
+  double estimate;
+  {
+    absl::MutexLock lock(&mutex_);
+    // Empty only if a client was removed with pending tasks.
+    if (ready_clients_.empty()) return;
+    client = *ready_clients_.begin();
+    ready_clients_.erase(ready_clients_.begin());
+    task = std::move(client->tasks.front());
+    client->tasks.pop_front();
+    virtual_clock_ = std::max(virtual_clock_, client->virtual_time);
+    estimate = client->average_task_time;
+    client->virtual_time += estimate / client->stats.weight;
+    if (!client->tasks.empty()) ready_clients_.insert(client);
+  }
+
+  const int64 start_time = ThreadCpuTimeNanos();
+  current_pool = this;
+  task();
+  current_pool = nullptr;
+  const double task_time = ThreadCpuTimeNanos() - start_time;
+
+  absl::MutexLock lock(&mutex_);
+  // The client's position in ready_clients_ depends on its virtual time.
+  const bool ready = ready_clients_.erase(client) > 0;
+  client->virtual_time += (task_time - estimate) / client->stats.weight;
+  client->average_task_time +=
+      kTaskTimeSmoothing * (task_time - client->average_task_time);
+  client->stats.cpu_time += absl::Nanoseconds(task_time);
+  ++client->stats.num_tasks_run;
+  if (ready) ready_clients_.insert(client);
+}
+
+// static
+absl::StatusOr<Executor*> FairShareExecutor::Create(
+    const MediaPipeOptions& extendable_options) {
+  auto& options =
+      extendable_options.GetExtension(FairShareExecutorOptions::ext);
+  if (options.weight() <= 0) {
+    return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "The weight field in FairShareExecutorOptions should be "
+              "positive but is "
+           << options.weight();
+  }
+  ASSIGN_OR_RETURN(ThreadOptions thread_options,
+                   internal::ThreadOptionsFromExecutorOptions(
+                       options.thread_pool_options()));
+  std::shared_ptr<FairShareExecutorPool> pool =
+      FairShareExecutorPool::GetOrCreate(
+          options.pool_name(), thread_options,
+          options.thread_pool_options().num_threads());
+  return pool->CreateExecutor(options.name(), options.weight()).release();
+}
+
+FairShareExecutor::~FairShareExecutor() { pool_->RemoveClient(client_); }
+
+void FairShareExecutor::Schedule(std::function<void()> task) {
+  pool_->AddTask(client_, std::move(task));
+}
+
+void FairShareExecutor::SetWeight(double weight) {
+  pool_->SetWeight(client_, weight);
+}
+
+FairShareExecutorStats FairShareExecutor::GetStats() const {
+  return pool_->GetClientStats(client_);
+}
+
+REGISTER_EXECUTOR(FairShareExecutor);
+
+}  // namespace mediapipe
@@ -0,0 +1,185 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FAIR_SHARE_EXECUTOR_H_
+#define MEDIAPIPE_FRAMEWORK_FAIR_SHARE_EXECUTOR_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/deps/thread_options.h"
+#include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/port/threadpool.h"
+
+namespace mediapipe {
+
+class FairShareExecutor;
+
+// CPU-time accounting of one FairShareExecutor.
+struct FairShareExecutorStats {
+  std::string name;
+  double weight = 1.0;
+  // Thread CPU time spent running the tasks of the executor.
+  absl::Duration cpu_time = absl::ZeroDuration();
+  // Number of tasks that have run.
+  int64 num_tasks_run = 0;
+  // Number of tasks waiting for a worker thread.
+  int64 num_tasks_queued = 0;
+};
+
+// A pool of worker threads shared by many CalculatorGraphs.
+//
+// Each graph gets its own FairShareExecutor from CreateExecutor() and installs
+// it with CalculatorGraph::SetExecutor(), or selects it in its config (see
+// FairShareExecutor). The pool divides its threads among the executors in
+// proportion to their weights: whenever a thread becomes free, it runs the
+// next task of the executor that has received the least CPU time per unit of
+// weight. A graph that has been idle does not bank CPU time while idle, so it
+// cannot starve the others when it becomes busy again.
+//
+// The pool is thread-safe. It stays alive as long as one of its executors
+// does.
+class FairShareExecutorPool
+    : public std::enable_shared_from_this<FairShareExecutorPool> {
+ public:
+  // Creates a pool that is not registered under any name.
+  static std::shared_ptr<FairShareExecutorPool> Create(
+      const ThreadOptions& thread_options, int num_threads);
+
+  // Returns the process-wide pool registered under "name", creating it with
+  // the given options if it does not exist. The options of an existing pool
+  // are not changed.
+  static std::shared_ptr<FairShareExecutorPool> GetOrCreate(
+      const std::string& name, const ThreadOptions& thread_options,
+      int num_threads);
+
+  ~FairShareExecutorPool();
+
+  // Creates an executor whose tasks run on the threads of this pool. "name"
+  // identifies the executor in GetStats(). "weight" must be positive.
+  std::unique_ptr<FairShareExecutor> CreateExecutor(const std::string& name,
+                                                    double weight);
+
+  // Returns the accounting of the live executors of the pool.
+  std::vector<FairShareExecutorStats> GetStats() const;
+
+  int num_threads() const { return thread_pool_.num_threads(); }
+
+ private:
+  friend class FairShareExecutor;
+
+  struct Client {
+    int64 id;
+    FairShareExecutorStats stats;
+    // CPU time received per unit of weight, in nanoseconds.
+    double virtual_time = 0;
+    // Exponential moving average of the CPU time of a task, in nanoseconds.
+    // Charged when a task starts, so that a client cannot take all the
+    // threads before its first tasks have finished.
+    double average_task_time = 0;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  struct ClientOrder {
+    bool operator()(const std::shared_ptr<Client>& a,
+                    const std::shared_ptr<Client>& b) const {
+      if (a->virtual_time != b->virtual_time) {
+        return a->virtual_time < b->virtual_time;
+      }
+      return a->id < b->id;
+    }
+  };
+
+  FairShareExecutorPool(const ThreadOptions& thread_options, int num_threads);
+
+  void AddTask(const std::shared_ptr<Client>& client,
+               std::function<void()> task);
+  void RemoveClient(const std::shared_ptr<Client>& client);
+  void SetWeight(const std::shared_ptr<Client>& client, double weight);
+  FairShareExecutorStats GetClientStats(
+      const std::shared_ptr<Client>& client) const;
+
+  // Runs the next task of the client with the smallest virtual time. Called
+  // by the worker threads once per AddTask.
+  void RunNextTask();
+
+  mutable absl::Mutex mutex_;
+  int64 next_client_id_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::vector<std::shared_ptr<Client>> clients_ ABSL_GUARDED_BY(mutex_);
+  // Clients that have queued tasks, ordered by virtual time.
+  std::set<std::shared_ptr<Client>, ClientOrder> ready_clients_
+      ABSL_GUARDED_BY(mutex_);
+  // The virtual time of the most recently started task. Clients that become
+  // ready start no earlier than this.
+  double virtual_clock_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  // Declared last, so that its destructor waits for the running tasks while
+  // the other members are still alive.
+  mediapipe::ThreadPool thread_pool_;
+};
+
+// An executor that runs its tasks on the threads of a FairShareExecutorPool,
+// sharing them with the other executors of the pool.
+//
+// It can be selected in the graph config, in which case the graph uses the
+// process-wide pool named by pool_name:
+//
+//   executor {
+//     type: "FairShareExecutor"
+//     options {
+//       [mediapipe.FairShareExecutorOptions.ext] {
+//         name: "camera_3"
+//         weight: 2
+//         thread_pool_options { num_threads: 16 }
+//       }
+//     }
+//   }
+class FairShareExecutor : public Executor {
+ public:
+  static absl::StatusOr<Executor*> Create(
+      const MediaPipeOptions& extendable_options);
+
+  ~FairShareExecutor() override;
+  void Schedule(std::function<void()> task) override;
+
+  // Changes the share of the pool that this executor receives.
+  void SetWeight(double weight);
+
+  FairShareExecutorStats GetStats() const;
+
+  const std::shared_ptr<FairShareExecutorPool>& pool() const { return pool_; }
+
+ private:
+  friend class FairShareExecutorPool;
+
+  FairShareExecutor(std::shared_ptr<FairShareExecutorPool> pool,
+                    std::shared_ptr<FairShareExecutorPool::Client> client)
+      : pool_(std::move(pool)), client_(std::move(client)) {}
+
+  std::shared_ptr<FairShareExecutorPool> pool_;
+  std::shared_ptr<FairShareExecutorPool::Client> client_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FAIR_SHARE_EXECUTOR_H_
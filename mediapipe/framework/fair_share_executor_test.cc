@@ -0,0 +1,381 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/fair_share_executor.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/fair_share_executor.pb.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+
+namespace mediapipe {
+namespace {
+
+inline void BusySleep(absl::Duration duration) {
+  absl::Time start_time = absl::Now();
+  while (absl::Now() - start_time < duration) {
+  }
+}
+
+// Records the order in which the tasks of several executors run.
+class TaskLog {
+ public:
+  void Append(int executor_index) {
+    absl::MutexLock lock(&mutex_);
+    log_.push_back(executor_index);
+  }
+
+  // Returns how many of the first n tasks belong to the executor.
+  int CountInFirst(int n, int executor_index) {
+    absl::MutexLock lock(&mutex_);
+    n = std::min<int>(n, log_.size());
+    return std::count(log_.begin(), log_.begin() + n, executor_index);
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::vector<int> log_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Occupies the only thread of the executor's pool until the returned
+// notification is notified, so that tasks scheduled in the meantime are
+// queued.
+std::shared_ptr<absl::Notification> BlockPool(FairShareExecutor* executor) {
+  auto started = std::make_shared<absl::Notification>();
+  auto release = std::make_shared<absl::Notification>();
+  executor->Schedule([started, release] {
+    started->Notify();
+    release->WaitForNotification();
+  });
+  started->WaitForNotification();
+  return release;
+}
+
+TEST(FairShareExecutorTest, RunsAllTasks) {
+  auto pool = FairShareExecutorPool::Create(ThreadOptions(), 4);
+  std::vector<std::unique_ptr<FairShareExecutor>> executors;
+  for (int i = 0; i < 3; ++i) {
+    executors.push_back(pool->CreateExecutor(absl::StrCat("graph_", i), 1.0));
+  }
+  constexpr int kTasksPerExecutor = 200;
+  absl::BlockingCounter done(3 * kTasksPerExecutor);
+  for (int t = 0; t < kTasksPerExecutor; ++t) {
+    for (auto& executor : executors) {
+      executor->Schedule([&done] { done.DecrementCount(); });
+    }
+  }
+  done.Wait();
+  for (auto& executor : executors) {
+    EXPECT_EQ(executor->GetStats().num_tasks_run, kTasksPerExecutor);
+  }
+}
+
+TEST(FairShareExecutorTest, SharesThreadsByWeight) {
+  auto pool = FairShareExecutorPool::Create(ThreadOptions(), 1);
+  auto normal = pool->CreateExecutor("normal", 1.0);
+  auto preferred = pool->CreateExecutor("preferred", 3.0);
+  auto blocker = pool->CreateExecutor("blocker", 1.0);
+  TaskLog log;
+  constexpr int kNumTasks = 60;
+  absl::BlockingCounter done(2 * kNumTasks);
+  std::shared_ptr<absl::Notification> release = BlockPool(blocker.get());
+  for (int i = 0; i < kNumTasks; ++i) {
+    normal->Schedule([&log, &done] {
+      BusySleep(absl::Microseconds(500));
+      log.Append(0);
+      done.DecrementCount();
+    });
+    preferred->Schedule([&log, &done] {
+      BusySleep(absl::Microseconds(500));
+      log.Append(1);
+      done.DecrementCount();
+    });
+  }
+  release->Notify();
+  done.Wait();
+  // The executor with three times the weight runs about three times as many
+  // tasks while both have tasks queued.
+  const int preferred_count = log.CountInFirst(40, 1);
+  EXPECT_GE(preferred_count, 24);
+  EXPECT_LE(preferred_count, 36);
+  EXPECT_GT(preferred->GetStats().cpu_time, absl::ZeroDuration());
+}
+
+TEST(FairShareExecutorTest, IdleExecutorDoesNotBankTime) {
+  auto pool = FairShareExecutorPool::Create(ThreadOptions(), 1);
+  auto busy = pool->CreateExecutor("busy", 1.0);
+  auto idle = pool->CreateExecutor("idle", 1.0);
+  auto blocker = pool->CreateExecutor("blocker", 1.0);
+  {
+    absl::BlockingCounter done(20);
+    for (int i = 0; i < 20; ++i) {
+      busy->Schedule([&done] {
+        BusySleep(absl::Microseconds(500));
+        done.DecrementCount();
+      });
+    }
+    done.Wait();
+  }
+  TaskLog log;
+  constexpr int kNumTasks = 20;
+  absl::BlockingCounter done(2 * kNumTasks);
+  std::shared_ptr<absl::Notification> release = BlockPool(blocker.get());
+  for (int i = 0; i < kNumTasks; ++i) {
+    busy->Schedule([&log, &done] {
+      BusySleep(absl::Microseconds(500));
+      log.Append(0);
+      done.DecrementCount();
+    });
+    idle->Schedule([&log, &done] {
+      BusySleep(absl::Microseconds(500));
+      log.Append(1);
+      done.DecrementCount();
+    });
+  }
+  release->Notify();
+  done.Wait();
+  // Without the catch-up, "idle" would run all its tasks before "busy" runs
+  // any.
+  EXPECT_GE(log.CountInFirst(kNumTasks, 0), kNumTasks / 4);
+}
+
+TEST(FairShareExecutorTest, StatsListLiveExecutors) {
+  auto pool = FairShareExecutorPool::Create(ThreadOptions(), 2);
+  auto first = pool->CreateExecutor("first", 1.0);
+  {
+    auto second = pool->CreateExecutor("second", 2.0);
+    std::vector<FairShareExecutorStats> stats = pool->GetStats();
+    ASSERT_EQ(stats.size(), 2);
+    EXPECT_EQ(stats[1].name, "second");
+    EXPECT_EQ(stats[1].weight, 2.0);
+  }
+  first->SetWeight(4.0);
+  std::vector<FairShareExecutorStats> stats = pool->GetStats();
+  ASSERT_EQ(stats.size(), 1);
+  EXPECT_EQ(stats[0].name, "first");
+  EXPECT_EQ(stats[0].weight, 4.0);
+}
+
+TEST(FairShareExecutorTest, GetOrCreateSharesPoolByName) {
+  auto pool = FairShareExecutorPool::GetOrCreate("cameras", ThreadOptions(), 2);
+  EXPECT_EQ(FairShareExecutorPool::GetOrCreate("cameras", ThreadOptions(), 2),
+            pool);
+  EXPECT_NE(FairShareExecutorPool::GetOrCreate("other", ThreadOptions(), 2),
+            pool);
+}
+
+// Destroying the last executor of a pool from one of the pool's tasks, as
+// when a graph is destroyed from a callback, must not make the pool join its
+// own worker thread.
+TEST(FairShareExecutorTest, DestroyLastExecutorFromTask) {
+  std::shared_ptr<FairShareExecutor> executor =
+      FairShareExecutorPool::Create(ThreadOptions(), 1)
+          ->CreateExecutor("last", 1.0);
+  std::weak_ptr<FairShareExecutorPool> pool = executor->pool();
+  absl::Notification scheduled;
+  absl::Notification done;
+  executor->Schedule([&executor, &scheduled, &done] {
+    scheduled.WaitForNotification();
+    executor.reset();
+    done.Notify();
+  });
+  scheduled.Notify();
+  ASSERT_TRUE(done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  EXPECT_TRUE(pool.expired());
+}
+
+TEST(FairShareExecutorTest, CreateFromOptions) {
+  MediaPipeOptions options;
+  auto* fair_share_options =
+      options.MutableExtension(FairShareExecutorOptions::ext);
+  fair_share_options->set_name("camera_0");
+  fair_share_options->set_pool_name("options_test");
+  fair_share_options->mutable_thread_pool_options()->set_num_threads(2);
+  MP_ASSERT_OK_AND_ASSIGN(Executor * executor,
+                          FairShareExecutor::Create(options));
+  std::unique_ptr<FairShareExecutor> fair_share_executor(
+      static_cast<FairShareExecutor*>(executor));
+  EXPECT_EQ(fair_share_executor->pool()->num_threads(), 2);
+  EXPECT_EQ(fair_share_executor->GetStats().name, "camera_0");
+
+  fair_share_options->set_weight(0);
+  EXPECT_FALSE(FairShareExecutor::Create(options).ok());
+}
+
+// Spends "cost" microseconds of CPU time on each input packet, like a model
+// or an image operation, and passes it on.
+class BusyPassThroughCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    cc->InputSidePackets().Tag("COST").Set<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    cost_ = absl::Microseconds(cc->InputSidePackets().Tag("COST").Get<int>());
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    BusySleep(cost_);
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return absl::OkStatus();
+  }
+
+ private:
+  absl::Duration cost_;
+};
+REGISTER_CALCULATOR(BusyPassThroughCalculator);
+
+enum class ExecutorSharing {
+  // Every graph has its own thread pool, as with the default executor.
+  kPerGraphPools,
+  // All the graphs share one ThreadPoolExecutor through SetExecutor.
+  kSharedThreadPool,
+  // All the graphs share one FairShareExecutorPool.
+  kFairSharePool,
+};
+
+// Runs state.range(0) camera graphs side by side. Graph 0 is a heavy graph
+// whose calculators cost eight times as much as those of the others. Each
+// iteration feeds one frame to every graph and waits for all the outputs.
+// Reports the average frame latency of the light graphs, which suffers when
+// the heavy graph starves them.
+template <ExecutorSharing kSharing>
+void BM_MultiGraph(benchmark::State& state) {
+  const int num_graphs = state.range(0);
+  const int num_threads = 4;
+  constexpr int kLightCostUs = 250;
+  constexpr int kHeavyCostUs = 8 * kLightCostUs;
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "input"
+        input_side_packet: "cost"
+        node {
+          calculator: "BusyPassThroughCalculator"
+          input_stream: "input"
+          output_stream: "stage_1"
+          input_side_packet: "COST:cost"
+        }
+        node {
+          calculator: "BusyPassThroughCalculator"
+          input_stream: "stage_1"
+          output_stream: "stage_2"
+          input_side_packet: "COST:cost"
+        }
+        node {
+          calculator: "BusyPassThroughCalculator"
+          input_stream: "stage_2"
+          output_stream: "output"
+          input_side_packet: "COST:cost"
+        }
+      )pb");
+  config.set_num_threads(num_threads);
+
+  std::shared_ptr<Executor> shared_executor;
+  std::shared_ptr<FairShareExecutorPool> pool;
+  if (kSharing == ExecutorSharing::kSharedThreadPool) {
+    shared_executor = std::make_shared<ThreadPoolExecutor>(num_threads);
+  } else if (kSharing == ExecutorSharing::kFairSharePool) {
+    pool = FairShareExecutorPool::Create(ThreadOptions(), num_threads);
+  }
+
+  absl::Mutex mutex;
+  std::vector<absl::Time> done_times(num_graphs);
+  int num_pending = 0;
+  std::vector<std::unique_ptr<CalculatorGraph>> graphs;
+  for (int g = 0; g < num_graphs; ++g) {
+    auto graph = absl::make_unique<CalculatorGraph>();
+    if (kSharing == ExecutorSharing::kSharedThreadPool) {
+      CHECK_OK(graph->SetExecutor("", shared_executor));
+    } else if (kSharing == ExecutorSharing::kFairSharePool) {
+      CHECK_OK(graph->SetExecutor(
+          "", pool->CreateExecutor(absl::StrCat("graph_", g), 1.0)));
+    }
+    CHECK_OK(graph->Initialize(config));
+    CHECK_OK(graph->ObserveOutputStream(
+        "output", [&mutex, &done_times, &num_pending, g](const Packet&) {
+          absl::MutexLock lock(&mutex);
+          done_times[g] = absl::Now();
+          --num_pending;
+          return absl::OkStatus();
+        }));
+    CHECK_OK(graph->StartRun(
+        {{"cost", MakePacket<int>(g == 0 ? kHeavyCostUs : kLightCostUs)}}));
+    graphs.push_back(std::move(graph));
+  }
+
+  int64 frame = 0;
+  double light_latency_us = 0;
+  for (auto _ : state) {
+    {
+      absl::MutexLock lock(&mutex);
+      num_pending = num_graphs;
+    }
+    const absl::Time start_time = absl::Now();
+    for (auto& graph : graphs) {
+      CHECK_OK(graph->AddPacketToInputStream(
+          "input", MakePacket<int64>(frame).At(Timestamp(frame))));
+    }
+    ++frame;
+    absl::MutexLock lock(&mutex);
+    mutex.Await(absl::Condition(
+        +[](int* num_pending) { return *num_pending == 0; }, &num_pending));
+    for (int g = 1; g < num_graphs; ++g) {
+      light_latency_us +=
+          absl::ToDoubleMicroseconds(done_times[g] - start_time);
+    }
+  }
+  for (auto& graph : graphs) {
+    CHECK_OK(graph->CloseAllPacketSources());
+    CHECK_OK(graph->WaitUntilDone());
+  }
+  state.counters["light_latency_us"] = benchmark::Counter(
+      light_latency_us / std::max(1, num_graphs - 1),
+      benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK_TEMPLATE(BM_MultiGraph, ExecutorSharing::kPerGraphPools)
+    ->Arg(4)
+    ->Arg(16)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MultiGraph, ExecutorSharing::kSharedThreadPool)
+    ->Arg(4)
+    ->Arg(16)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MultiGraph, ExecutorSharing::kFairSharePool)
+    ->Arg(4)
+    ->Arg(16)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
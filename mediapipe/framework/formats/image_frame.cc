@@ -23,6 +23,7 @@
 #include <algorithm>
 #include <utility>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/port/aligned_malloc_and_free.h"
@@ -418,4 +419,11 @@ void ImageFrame::CopyToBuffer(float* buffer, int buffer_size) const {
                          reinterpret_cast<char*>(buffer));
   }
 }
+
+std::unique_ptr<ImageFrame> CopyPacketPayload(const ImageFrame& image_frame) {
+  auto copy = absl::make_unique<ImageFrame>();
+  copy->CopyFrom(image_frame, ImageFrame::kDefaultAlignmentBoundary);
+  return copy;
+}
+
 }  // namespace mediapipe
@@ -252,6 +252,10 @@ class ImageFrame {
   std::unique_ptr<uint8[], Deleter> pixel_data_;
 };
 
+// Returns a copy of |image_frame|.  Packet::ConsumeOrCopy() uses this when the
+// frame is shared, since ImageFrame is not copy-constructible.
+std::unique_ptr<ImageFrame> CopyPacketPayload(const ImageFrame& image_frame);
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_FRAMEWORK_FORMATS_IMAGE_FRAME_H_
@@ -15,10 +15,14 @@
 #include "mediapipe/framework/formats/tensor.h"
 
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <utility>
 
+#include "absl/memory/memory.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/port.h"
+#include "mediapipe/framework/port/aligned_malloc_and_free.h"
 #include "mediapipe/framework/port/logging.h"
 #if MEDIAPIPE_OPENGL_ES_VERSION >= MEDIAPIPE_OPENGL_ES_30
 #include "mediapipe/gpu/gl_base.h"
@@ -58,6 +62,18 @@ int BhwcDepthFromShape(const Tensor::Shape& shape) {
   return shape.dims.size() < 2 ? 1 : shape.dims[shape.dims.size() - 1];
 }
 
+std::unique_ptr<Tensor> CopyPacketPayload(const Tensor& tensor) {
+  auto copy = absl::make_unique<Tensor>(tensor.element_type(), tensor.shape(),
+                                        tensor.quantization_parameters());
+  if (tensor.bytes() > 0) {
+    auto source = tensor.GetCpuReadView();
+    auto destination = copy->GetCpuWriteView();
+    std::memcpy(destination.buffer<void>(), source.buffer<void>(),
+                tensor.bytes());
+  }
+  return copy;
+}
+
 // TODO: Match channels count and padding for Texture2D:
 // 1) support 1/2/4 channesl texture for 1/2/3-4 depth.
 // 2) Allocate cpu_buffer_ with padded amount of memory
@@ -518,7 +534,7 @@ void Tensor::Invalidate() {
 #endif  // MEDIAPIPE_OPENGL_ES_VERSION >= MEDIAPIPE_OPENGL_ES_31
 
   if (cpu_buffer_) {
-    free(cpu_buffer_);
+    aligned_free(cpu_buffer_);
   }
   cpu_buffer_ = nullptr;
 }
@@ -635,7 +651,8 @@ void Tensor::AllocateCpuBuffer() const {
 #if MEDIAPIPE_METAL_ENABLED
     cpu_buffer_ = AllocateVirtualMemory(bytes());
 #else
-    cpu_buffer_ = malloc(bytes());
+    cpu_buffer_ =
+        aligned_malloc(bytes() + kCpuBufferAlignment, kCpuBufferAlignment);
 #endif  // MEDIAPIPE_METAL_ENABLED
   }
 }
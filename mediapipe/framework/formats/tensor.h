@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <functional>
 #include <initializer_list>
+#include <memory>
 #include <numeric>
 #include <tuple>
 #include <type_traits>
@@ -137,6 +138,11 @@ class Tensor {
   Tensor(ElementType element_type, const Shape& shape,
          const QuantizationParameters& quantization_parameters);
 
+  // CPU buffers are aligned to kCpuBufferAlignment bytes and followed by at
+  // least as many bytes of padding, as required to bind them to TFLite
+  // interpreter tensors without copying.
+  static constexpr int kCpuBufferAlignment = 64;
+
   // Non-copyable.
   Tensor(const Tensor&) = delete;
   Tensor& operator=(const Tensor&) = delete;
@@ -433,6 +439,10 @@ int BhwcHeightFromShape(const Tensor::Shape& shape);
 int BhwcWidthFromShape(const Tensor::Shape& shape);
 int BhwcDepthFromShape(const Tensor::Shape& shape);
 
+// Returns a CPU copy of |tensor|.  Packet::ConsumeOrCopy() uses this when the
+// tensor is shared, since Tensor is not copy-constructible.
+std::unique_ptr<Tensor> CopyPacketPayload(const Tensor& tensor);
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_FRAMEWORK_FORMATS_TENSOR_H_
@@ -174,26 +174,33 @@ void OutputStreamPollerImpl::NotifyError() {
   mutex_.Unlock();
 }
 
-bool OutputStreamPollerImpl::Next(Packet* packet) {
-  CHECK(packet);
-  bool empty_queue = true;
-  bool timestamp_bound_changed = false;
+Timestamp OutputStreamPollerImpl::WaitForNext(bool* empty_queue,
+                                              bool* timestamp_bound_changed) {
+  *empty_queue = true;
+  *timestamp_bound_changed = false;
   Timestamp min_timestamp = Timestamp::Unset();
-  mutex_.Lock();
   while (true) {
-    min_timestamp = input_stream_->MinTimestampOrBound(&empty_queue);
-    if (empty_queue) {
-      timestamp_bound_changed =
+    min_timestamp = input_stream_->MinTimestampOrBound(empty_queue);
+    if (*empty_queue) {
+      *timestamp_bound_changed =
           input_stream_handler_->ProcessTimestampBounds() &&
           output_timestamp_ < min_timestamp.PreviousAllowedInStream();
     }
-    if (graph_has_error_ || !empty_queue || timestamp_bound_changed ||
+    if (graph_has_error_ || !*empty_queue || *timestamp_bound_changed ||
         min_timestamp == Timestamp::Done()) {
-      break;
-    } else {
-      handler_condvar_.Wait(&mutex_);
+      return min_timestamp;
     }
+    handler_condvar_.Wait(&mutex_);
   }
+}
+
+bool OutputStreamPollerImpl::Next(Packet* packet) {
+  CHECK(packet);
+  bool empty_queue = true;
+  bool timestamp_bound_changed = false;
+  mutex_.Lock();
+  Timestamp min_timestamp =
+      WaitForNext(&empty_queue, &timestamp_bound_changed);
   if (graph_has_error_ && empty_queue) {
     mutex_.Unlock();
     return false;
@@ -221,5 +228,36 @@ bool OutputStreamPollerImpl::Next(Packet* packet) {
   return true;
 }
 
+bool OutputStreamPollerImpl::NextBatch(int max_packets,
+                                       std::vector<Packet>* packets) {
+  CHECK(packets);
+  CHECK_GT(max_packets, 0);
+  packets->clear();
+  bool empty_queue = true;
+  bool timestamp_bound_changed = false;
+  mutex_.Lock();
+  Timestamp min_timestamp =
+      WaitForNext(&empty_queue, &timestamp_bound_changed);
+  if ((graph_has_error_ && empty_queue) ||
+      (empty_queue && min_timestamp == Timestamp::Done())) {
+    mutex_.Unlock();
+    return false;
+  }
+  if (empty_queue) {
+    output_timestamp_ = min_timestamp.PreviousAllowedInStream();
+    mutex_.Unlock();
+    packets->push_back(Packet().At(output_timestamp_));
+    return true;
+  }
+  mutex_.Unlock();
+  // Packets are popped outside mutex_, because popping may invoke the
+  // queue size callbacks of the graph.
+  input_stream_->PopQueuedPackets(max_packets, packets);
+  mutex_.Lock();
+  output_timestamp_ = packets->back().Timestamp();
+  mutex_.Unlock();
+  return true;
+}
+
 }  // namespace internal
 }  // namespace mediapipe
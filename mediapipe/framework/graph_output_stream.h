@@ -167,7 +167,17 @@ class OutputStreamPollerImpl : public GraphOutputStream {
   // done).  Returns true if successful.
   ABSL_MUST_USE_RESULT bool Next(Packet* packet);
 
+  // Gets up to max_packets queued packets (block until at least one is
+  // available or the stream is done).  Returns true if successful.
+  ABSL_MUST_USE_RESULT bool NextBatch(int max_packets,
+                                      std::vector<Packet>* packets);
+
  private:
+  // Blocks until a packet or a timestamp bound is available, or the stream
+  // is done.  Returns the min timestamp or bound of the input stream.
+  Timestamp WaitForNext(bool* empty_queue, bool* timestamp_bound_changed)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   absl::Mutex mutex_;
   absl::CondVar handler_condvar_ ABSL_GUARDED_BY(mutex_);
   bool graph_has_error_ ABSL_GUARDED_BY(mutex_);
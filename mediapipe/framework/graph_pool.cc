@@ -0,0 +1,114 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/graph_pool.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+// static
+absl::StatusOr<std::unique_ptr<GraphPool>> GraphPool::Create(
+    CalculatorGraphConfig config, std::map<std::string, Packet> side_packets,
+    int num_warm_graphs, GraphSetup setup) {
+  RET_CHECK_GE(num_warm_graphs, 0);
+  auto pool = absl::WrapUnique(
+      new GraphPool(std::move(side_packets), std::move(setup)));
+
+  // The first graph performs subgraph expansion and supplies the snapshot
+  // used to initialize all further graphs.
+  auto first_graph = absl::make_unique<CalculatorGraph>();
+  MP_RETURN_IF_ERROR(
+      first_graph->Initialize(std::move(config), pool->side_packets_));
+  ASSIGN_OR_RETURN(pool->snapshot_, first_graph->GetConfigSnapshot());
+  if (pool->setup_) {
+    MP_RETURN_IF_ERROR(pool->setup_(first_graph.get()));
+  }
+
+  absl::MutexLock lock(&pool->mutex_);
+  if (num_warm_graphs > 0) {
+    pool->idle_graphs_.reserve(num_warm_graphs);
+    pool->idle_graphs_.push_back(std::move(first_graph));
+  }
+  while (pool->idle_graphs_.size() < num_warm_graphs) {
+    ASSIGN_OR_RETURN(std::unique_ptr<CalculatorGraph> graph,
+                     pool->CreateGraph());
+    pool->idle_graphs_.push_back(std::move(graph));
+  }
+  return pool;
+}
+
+GraphPool::GraphPool(std::map<std::string, Packet> side_packets,
+                     GraphSetup setup)
+    : side_packets_(std::move(side_packets)), setup_(std::move(setup)) {}
+
+absl::StatusOr<std::unique_ptr<CalculatorGraph>> GraphPool::Acquire() {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!idle_graphs_.empty()) {
+      std::unique_ptr<CalculatorGraph> graph = std::move(idle_graphs_.back());
+      idle_graphs_.pop_back();
+      acquired_graphs_.insert(graph.get());
+      return graph;
+    }
+  }
+  ASSIGN_OR_RETURN(std::unique_ptr<CalculatorGraph> graph, CreateGraph());
+  absl::MutexLock lock(&mutex_);
+  acquired_graphs_.insert(graph.get());
+  return graph;
+}
+
+absl::Status GraphPool::Release(std::unique_ptr<CalculatorGraph> graph) {
+  RET_CHECK(graph) << "Cannot release a null graph.";
+  {
+    absl::MutexLock lock(&mutex_);
+    RET_CHECK_EQ(acquired_graphs_.erase(graph.get()), 1)
+        << "The graph was not acquired from this pool.";
+  }
+  if (graph->IsRunInProgress()) {
+    if (!graph->HasError()) {
+      graph->Cancel();
+      graph->WaitUntilDone().IgnoreError();
+      return absl::FailedPreconditionError(
+          "The graph was released while running. WaitUntilDone() must return "
+          "before the graph is released.");
+    }
+    // The failed run only needs to be finished.
+    graph->WaitUntilDone().IgnoreError();
+  }
+  absl::MutexLock lock(&mutex_);
+  idle_graphs_.push_back(std::move(graph));
+  return absl::OkStatus();
+}
+
+int GraphPool::NumIdleGraphs() const {
+  absl::MutexLock lock(&mutex_);
+  return idle_graphs_.size();
+}
+
+absl::StatusOr<std::unique_ptr<CalculatorGraph>> GraphPool::CreateGraph()
+    const {
+  auto graph = absl::make_unique<CalculatorGraph>();
+  MP_RETURN_IF_ERROR(graph->InitializeFromSnapshot(snapshot_, side_packets_));
+  if (setup_) {
+    MP_RETURN_IF_ERROR(setup_(graph.get()));
+  }
+  return graph;
+}
+
+}  // namespace mediapipe
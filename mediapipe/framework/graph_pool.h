@@ -0,0 +1,106 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_GRAPH_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_GRAPH_POOL_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_graph.h"
+#include "mediapipe/framework/packet.h"
+
+namespace mediapipe {
+
+// Hands out initialized CalculatorGraphs built from a single config, such as
+// one graph per camera or per request.
+//
+// The config is expanded and validated once.  Every further graph is
+// initialized from the resulting snapshot (see
+// CalculatorGraph::InitializeFromSnapshot) and receives the same side packets,
+// so large immutable side packets such as models are shared rather than
+// copied.  Graphs returned through Release() are kept warm and handed out
+// again by Acquire() in constant time.
+//
+// Example usage:
+//   ASSIGN_OR_RETURN(std::unique_ptr<GraphPool> pool,
+//                    GraphPool::Create(config, side_packets, 4));
+//   ASSIGN_OR_RETURN(std::unique_ptr<CalculatorGraph> graph, pool->Acquire());
+//   MP_RETURN_IF_ERROR(graph->StartRun({}));
+//   ...
+//   MP_RETURN_IF_ERROR(graph->WaitUntilDone());
+//   MP_RETURN_IF_ERROR(pool->Release(std::move(graph)));
+//
+// GraphPool is thread-safe.
+class GraphPool {
+ public:
+  // Called once for every graph the pool creates, before the graph is first
+  // handed out.  Output stream observers added here stay attached while the
+  // graph is pooled.
+  using GraphSetup = std::function<absl::Status(CalculatorGraph*)>;
+
+  // Creates a pool holding |num_warm_graphs| initialized graphs.
+  static absl::StatusOr<std::unique_ptr<GraphPool>> Create(
+      CalculatorGraphConfig config, std::map<std::string, Packet> side_packets,
+      int num_warm_graphs, GraphSetup setup = nullptr);
+
+  GraphPool(const GraphPool&) = delete;
+  GraphPool& operator=(const GraphPool&) = delete;
+
+  // Returns an idle graph, or initializes a new one if none is idle.
+  absl::StatusOr<std::unique_ptr<CalculatorGraph>> Acquire();
+
+  // Returns |graph| to the pool.  The graph must have been acquired from this
+  // pool and must not be running, i.e. WaitUntilDone() must have returned.
+  // A graph whose run failed is finished and kept, since its next StartRun()
+  // resets it.  A graph that is still running is cancelled and dropped, and
+  // FailedPreconditionError is returned.
+  absl::Status Release(std::unique_ptr<CalculatorGraph> graph);
+
+  // Returns the number of graphs waiting to be acquired.
+  int NumIdleGraphs() const;
+
+  // Returns the canonical config snapshot shared by the pooled graphs.
+  const std::string& Snapshot() const { return snapshot_; }
+
+ private:
+  GraphPool(std::map<std::string, Packet> side_packets, GraphSetup setup);
+
+  // Initializes a new graph from snapshot_ and runs setup_ on it.
+  absl::StatusOr<std::unique_ptr<CalculatorGraph>> CreateGraph() const;
+
+  const std::map<std::string, Packet> side_packets_;
+  const GraphSetup setup_;
+  std::string snapshot_;
+
+  mutable absl::Mutex mutex_;
+  std::vector<std::unique_ptr<CalculatorGraph>> idle_graphs_
+      ABSL_GUARDED_BY(mutex_);
+  // The graphs handed out by Acquire() and not released yet.
+  absl::flat_hash_set<const CalculatorGraph*> acquired_graphs_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_GRAPH_POOL_H_
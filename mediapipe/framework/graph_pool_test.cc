@@ -0,0 +1,184 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/graph_pool.h"
+
+#include <atomic>
+#include <memory>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+CalculatorGraphConfig PassThroughConfig() {
+  return ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    input_side_packet: "side"
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "in"
+      output_stream: "mid"
+      input_side_packet: "side"
+      output_side_packet: "side_out"
+    }
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "mid"
+      output_stream: "out"
+    }
+  )pb");
+}
+
+// Runs |graph| to completion on a single input packet.
+absl::Status RunOnePacket(CalculatorGraph* graph) {
+  MP_RETURN_IF_ERROR(graph->StartRun({}));
+  MP_RETURN_IF_ERROR(graph->AddPacketToInputStream(
+      "in", MakePacket<int>(1).At(Timestamp(0))));
+  MP_RETURN_IF_ERROR(graph->CloseAllInputStreams());
+  return graph->WaitUntilDone();
+}
+
+GraphPool::GraphSetup CountingSetup(std::atomic<int>* count) {
+  return [count](CalculatorGraph* graph) {
+    return graph->ObserveOutputStream("out", [count](const Packet& packet) {
+      ++*count;
+      return absl::OkStatus();
+    });
+  };
+}
+
+TEST(GraphPoolTest, AcquireAndRelease) {
+  std::atomic<int> count(0);
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<GraphPool> pool,
+      GraphPool::Create(PassThroughConfig(), {{"side", MakePacket<int>(7)}},
+                        /*num_warm_graphs=*/2, CountingSetup(&count)));
+  EXPECT_EQ(pool->NumIdleGraphs(), 2);
+
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<CalculatorGraph> graph_1,
+                          pool->Acquire());
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<CalculatorGraph> graph_2,
+                          pool->Acquire());
+  EXPECT_EQ(pool->NumIdleGraphs(), 0);
+  // The pool is empty, so this graph is initialized from the snapshot.
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<CalculatorGraph> graph_3,
+                          pool->Acquire());
+
+  MP_EXPECT_OK(RunOnePacket(graph_1.get()));
+  MP_EXPECT_OK(RunOnePacket(graph_2.get()));
+  MP_EXPECT_OK(RunOnePacket(graph_3.get()));
+  EXPECT_EQ(count, 3);
+  EXPECT_EQ(graph_3->Config().node_size(), 2);
+
+  MP_EXPECT_OK(pool->Release(std::move(graph_1)));
+  MP_EXPECT_OK(pool->Release(std::move(graph_2)));
+  MP_EXPECT_OK(pool->Release(std::move(graph_3)));
+  EXPECT_EQ(pool->NumIdleGraphs(), 3);
+
+  // A released graph can run again with its observer still attached.
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<CalculatorGraph> graph,
+                          pool->Acquire());
+  MP_EXPECT_OK(RunOnePacket(graph.get()));
+  EXPECT_EQ(count, 4);
+}
+
+TEST(GraphPoolTest, SharesSidePackets) {
+  Packet side_packet = MakePacket<int>(7);
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<GraphPool> pool,
+      GraphPool::Create(PassThroughConfig(), {{"side", side_packet}},
+                        /*num_warm_graphs=*/1));
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<CalculatorGraph> graph_1,
+                          pool->Acquire());
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<CalculatorGraph> graph_2,
+                          pool->Acquire());
+  MP_ASSERT_OK(RunOnePacket(graph_1.get()));
+  MP_ASSERT_OK(RunOnePacket(graph_2.get()));
+  MP_ASSERT_OK_AND_ASSIGN(Packet packet_1,
+                          graph_1->GetOutputSidePacket("side_out"));
+  MP_ASSERT_OK_AND_ASSIGN(Packet packet_2,
+                          graph_2->GetOutputSidePacket("side_out"));
+  EXPECT_EQ(&packet_1.Get<int>(), &side_packet.Get<int>());
+  EXPECT_EQ(&packet_2.Get<int>(), &side_packet.Get<int>());
+}
+
+TEST(GraphPoolTest, ReleaseRejectsRunningGraph) {
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<GraphPool> pool,
+      GraphPool::Create(PassThroughConfig(), {{"side", MakePacket<int>(7)}},
+                        /*num_warm_graphs=*/1));
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<CalculatorGraph> graph,
+                          pool->Acquire());
+  MP_ASSERT_OK(graph->StartRun({}));
+  EXPECT_EQ(pool->Release(std::move(graph)).code(),
+            absl::StatusCode::kFailedPrecondition);
+  EXPECT_EQ(pool->NumIdleGraphs(), 0);
+}
+
+TEST(GraphPoolTest, ReleaseRejectsGraphFromAnotherPool) {
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<GraphPool> pool_1,
+      GraphPool::Create(PassThroughConfig(), {{"side", MakePacket<int>(7)}},
+                        /*num_warm_graphs=*/1));
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<GraphPool> pool_2,
+      GraphPool::Create(PassThroughConfig(), {{"side", MakePacket<int>(7)}},
+                        /*num_warm_graphs=*/1));
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<CalculatorGraph> graph,
+                          pool_1->Acquire());
+  EXPECT_FALSE(pool_2->Release(std::move(graph)).ok());
+  EXPECT_EQ(pool_2->NumIdleGraphs(), 1);
+}
+
+TEST(GraphPoolTest, InvalidConfig) {
+  CalculatorGraphConfig config;
+  config.add_node()->set_calculator("NoSuchCalculator");
+  EXPECT_FALSE(GraphPool::Create(config, {}, /*num_warm_graphs=*/1).ok());
+}
+
+// Measures the time to run a first packet through a newly initialized graph.
+void BM_ColdGraphFirstPacket(benchmark::State& state) {
+  CalculatorGraphConfig config = PassThroughConfig();
+  std::map<std::string, Packet> side_packets = {{"side", MakePacket<int>(7)}};
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    CHECK(graph.Initialize(config, side_packets).ok());
+    CHECK(RunOnePacket(&graph).ok());
+  }
+}
+BENCHMARK(BM_ColdGraphFirstPacket)->UseRealTime();
+
+// Measures the time to run a first packet through a pooled graph.
+void BM_PooledGraphFirstPacket(benchmark::State& state) {
+  std::unique_ptr<GraphPool> pool =
+      GraphPool::Create(PassThroughConfig(), {{"side", MakePacket<int>(7)}},
+                        /*num_warm_graphs=*/1)
+          .value();
+  for (auto _ : state) {
+    std::unique_ptr<CalculatorGraph> graph = pool->Acquire().value();
+    CHECK(RunOnePacket(graph.get()).ok());
+    CHECK(pool->Release(std::move(graph)).ok());
+  }
+}
+BENCHMARK(BM_PooledGraphFirstPacket)->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -129,6 +129,21 @@ void InputStreamHandler::SetMaxQueueSize(int max_queue_size) {
   }
 }
 
+std::vector<int> InputStreamHandler::TakePeakQueueSizes() {
+  std::vector<int> queue_sizes;
+  queue_sizes.reserve(input_stream_managers_.NumEntries());
+  for (auto& stream : input_stream_managers_) {
+    queue_sizes.push_back(stream->TakePeakQueueSize());
+  }
+  return queue_sizes;
+}
+
+void InputStreamHandler::SetTrackPeakQueueSizes(bool track) {
+  for (auto& stream : input_stream_managers_) {
+    stream->SetTrackPeakQueueSize(track);
+  }
+}
+
 std::string InputStreamHandler::DebugStreamNames() const {
   std::vector<absl::string_view> stream_names;
   for (const auto& stream : input_stream_managers_) {
@@ -179,6 +194,12 @@ bool InputStreamHandler::ScheduleInvocations(int max_allowance,
       mediapipe::LogEvent(default_context->GetProfilingContext(),
                           TraceEvent(TraceEvent::NOT_READY)
                               .set_node_id(default_context->NodeId()));
+      if (schedule_partial_batches_ &&
+          calculator_context_manager_->ContextHasInputTimestamp(
+              *default_context)) {
+        schedule_callback_(default_context);
+        ++invocations_scheduled;
+      }
       break;
     } else if (node_readiness == NodeReadiness::kReadyForProcess) {
       CalculatorContext* calculator_context =
@@ -241,7 +262,10 @@ CalculatorContext* GetCalculatorContext(CalculatorContextManager* manager) {
 // Logs the current queue size of an input stream.
 void LogQueuedPackets(CalculatorContext* context, InputStreamManager* stream,
                       Packet queue_tail) {
-  if (context) {
+  // Only the GraphTracer records PACKET_QUEUED events. Skip reading the queue
+  // otherwise, since this runs on the producer's thread.
+  if (context && context->GetProfilingContext() &&
+      context->GetProfilingContext()->tracer()) {
     TraceEvent event = TraceEvent(TraceEvent::PACKET_QUEUED)
                            .set_node_id(context->NodeId())
                            .set_input_ts(queue_tail.Timestamp())
@@ -289,15 +313,20 @@ void InputStreamHandler::MovePackets(CollectionItemId id,
 
 void InputStreamHandler::SetNextTimestampBound(CollectionItemId id,
                                                Timestamp bound) {
+  if (UpdateNextTimestampBound(id, bound)) {
+    notification_();
+  }
+}
+
+bool InputStreamHandler::UpdateNextTimestampBound(CollectionItemId id,
+                                                  Timestamp bound) {
   bool notify = false;
   absl::Status result =
       input_stream_managers_.Get(id)->SetNextTimestampBound(bound, &notify);
   if (!result.ok()) {
     error_callback_(result);
   }
-  if (notify) {
-    notification_();
-  }
+  return notify;
 }
 
 void InputStreamHandler::ClearCurrentInputs(
@@ -327,6 +356,18 @@ void InputStreamHandler::SetBatchSize(int batch_size) {
   batch_size_ = batch_size;
 }
 
+absl::Status InputStreamHandler::SetMaxBatchSize(int max_batch_size) {
+  RET_CHECK_GE(max_batch_size, 1)
+      << "Batch size has to be greater than or equal to 1.";
+  RET_CHECK(!calculator_run_in_parallel_ || max_batch_size == 1)
+      << "Batching cannot be combined with parallel execution.";
+  RET_CHECK(!late_preparation_ || max_batch_size == 1)
+      << "Batching cannot be combined with late preparation.";
+  batch_size_ = max_batch_size;
+  schedule_partial_batches_ = max_batch_size > 1;
+  return absl::OkStatus();
+}
+
 void InputStreamHandler::SetLatePreparation(bool late_preparation) {
   CHECK(batch_size_ == 1 || !late_preparation_)
       << "Batching cannot be combined with late preparation.";
@@ -110,6 +110,10 @@ class InputStreamHandler {
 
   int NumInputStreams() const { return input_stream_managers_.NumEntries(); }
 
+  // Returns true if the input sets are filled by FinalizeInputSet() on the
+  // thread that runs the calculator, rather than in ScheduleInvocations().
+  bool LatePreparation() const { return late_preparation_; }
+
   // Returns the tag map of the input streams.
   const std::shared_ptr<tool::TagMap>& InputTagMap() const {
     return input_stream_managers_.TagMap();
@@ -127,6 +131,14 @@ class InputStreamHandler {
   // Sets max queue size of a particular stream.
   void SetMaxQueueSize(CollectionItemId id, int max_queue_size);
 
+  // Returns the largest queue size of each input stream since the previous
+  // call. See InputStreamManager::TakePeakQueueSize().
+  std::vector<int> TakePeakQueueSizes();
+
+  // Enables tracking of the largest queue size of every input stream. See
+  // InputStreamManager::SetTrackPeakQueueSize().
+  void SetTrackPeakQueueSizes(bool track);
+
   void SetQueueSizeCallbacks(
       InputStreamManager::QueueSizeCallback becomes_full_callback,
       InputStreamManager::QueueSizeCallback becomes_not_full_callback);
@@ -141,6 +153,15 @@ class InputStreamHandler {
   // Sets next timestamp bound in a particular stream.
   void SetNextTimestampBound(CollectionItemId id, Timestamp bound);
 
+  // Sets next timestamp bound in a particular stream without notifying the
+  // node.  Returns true if the node must then be notified by calling
+  // NotifyInputStreamsUpdated(), which allows the caller to coalesce the
+  // notifications for several bound updates.
+  bool UpdateNextTimestampBound(CollectionItemId id, Timestamp bound);
+
+  // Notifies the node that its input streams have been updated.
+  void NotifyInputStreamsUpdated() { notification_(); }
+
   // Clears the current packet of every stream shard and removes the current
   // timestamp from the calculator context.
   void ClearCurrentInputs(CalculatorContext* calculator_context);
@@ -184,6 +205,12 @@ class InputStreamHandler {
   // When true, Calculator::Process is called for every input timestamp bound.
   bool ProcessTimestampBounds() { return process_timestamps_; }
 
+  // Collects up to max_batch_size input sets for a single call to
+  // Calculator::Process. Unlike SetBatchSize(), a partial batch is scheduled
+  // as soon as no further input set is ready. Fails if the calculator runs in
+  // parallel or if the handler prepares input sets late.
+  absl::Status SetMaxBatchSize(int max_batch_size);
+
   // Returns the number of sync-sets populated by this input stream handler.
   virtual int SyncSetCount() { return 1; }
 
@@ -300,6 +327,10 @@ class InputStreamHandler {
   // CalculatorNode is scheduled.
   int batch_size_ = 1;
 
+  // When true, an incomplete batch of input sets is scheduled whenever the
+  // node is not ready for another input set.
+  bool schedule_partial_batches_ = false;
+
   // When true, any increase in timestamp bound invokes Calculator::Process.
   bool process_timestamps_ = false;
 
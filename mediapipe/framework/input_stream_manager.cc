@@ -14,6 +14,8 @@
 
 #include "mediapipe/framework/input_stream_manager.h"
 
+#include <algorithm>
+#include <thread>  // NOLINT(build/c++11)
 #include <type_traits>
 #include <utility>
 
@@ -27,6 +29,14 @@
 
 namespace mediapipe {
 
+namespace {
+
+// The value next_timestamp_bound_ holds while the producer checks a packet
+// against the bound and queues it. Never a real bound.
+Timestamp AddingBound() { return Timestamp::Unset(); }
+
+}  // namespace
+
 absl::Status InputStreamManager::Initialize(const std::string& name,
                                             const PacketType* packet_type,
                                             bool back_edge) {
@@ -48,26 +58,25 @@ void InputStreamManager::SetQueueSizeCallbacks(
 
 void InputStreamManager::PrepareForRun() {
   absl::MutexLock stream_lock(&stream_mutex_);
-  queue_.clear();
+  queue_.Clear();
   last_reported_stream_full_ = false;
   num_packets_added_ = 0;
+  peak_queue_size_ = 0;
   next_timestamp_bound_ = Timestamp::PreStream();
   last_select_timestamp_ = Timestamp::Unstarted();
   closed_ = false;
   header_ = Packet();
 }
 
-bool InputStreamManager::IsEmpty() const {
-  absl::MutexLock stream_lock(&stream_mutex_);
-  return queue_.empty();
-}
+bool InputStreamManager::IsEmpty() const { return queue_.Empty(); }
 
 Packet InputStreamManager::QueueHead() const {
-  absl::MutexLock stream_lock(&stream_mutex_);
-  if (queue_.empty()) {
+  absl::MutexLockMaybe stream_lock(StreamMutex());
+  const Packet* head = queue_.Front();
+  if (head == nullptr) {
     return Packet();
   }
-  return queue_.front();
+  return *head;
 }
 
 absl::Status InputStreamManager::SetHeader(const Packet& header) {
@@ -98,15 +107,10 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
   bool queue_became_full = false;
   {
     // Scope to prevent locking the stream when notification is called.
-    absl::MutexLock stream_lock(&stream_mutex_);
+    absl::MutexLockMaybe stream_lock(StreamMutex());
     if (closed_) {
       return absl::OkStatus();
     }
-    // Check if the queue was full before packets came in.
-    bool was_queue_full =
-        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
-    // Check if the queue becomes non-empty.
-    queue_became_non_empty = queue_.empty() && !container.empty();
     for (auto& packet : container) {
       absl::Status result = packet_type_->Validate(packet);
       if (!result.ok()) {
@@ -135,42 +139,68 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
                  << "\", a packet at Timestamp::PostStream() must be the only "
                     "Packet in an InputStream.";
         }
-        if (timestamp < next_timestamp_bound_) {
+      }
+      // Holds the bound at AddingBound() until the packet is queued, so that
+      // the consumer cannot move the bound past the packet between the check
+      // below and the push.
+      Timestamp next_timestamp_bound = LoadNextTimestampBound();
+      while (true) {
+        if (enable_timestamps_ && timestamp < next_timestamp_bound) {
           return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
                  << "Packet timestamp mismatch on a calculator receiving from "
                     "stream \""
                  << name_ << "\". Current minimum expected timestamp is "
-                 << next_timestamp_bound_.DebugString() << " but received "
+                 << next_timestamp_bound.DebugString() << " but received "
                  << timestamp.DebugString()
                  << ". Are you using a custom InputStreamHandler? Note that "
                     "some InputStreamHandlers allow timestamps that are not "
                     "strictly monotonically increasing. See for example the "
                     "ImmediateInputStreamHandler class comment.";
         }
+        if (next_timestamp_bound_.compare_exchange_weak(
+                next_timestamp_bound, AddingBound(), std::memory_order_acquire,
+                std::memory_order_relaxed)) {
+          break;
+        }
+        if (next_timestamp_bound == AddingBound()) {
+          next_timestamp_bound = LoadNextTimestampBound();
+        }
       }
-      next_timestamp_bound_ = timestamp.NextAllowedInStream();
 
       // If the caller is MovePackets(), packet's underlying holder should be
       // transferred into queue_. Otherwise, queue_ keeps a copy of the packet.
       ++num_packets_added_;
       VLOG(3) << "Input stream:" << name_
               << " has added packet at time: " << packet.Timestamp();
+      int64 size_before;
       if (std::is_const<
               typename std::remove_reference<Container>::type>::value) {
-        queue_.emplace_back(packet);
+        size_before = queue_.Push(packet);
       } else {
-        queue_.emplace_back(std::move(packet));
+        size_before = queue_.Push(std::move(packet));
+      }
+      // The bound is released after the packet is queued, so that a consumer
+      // that sees the new bound also sees the packet. Without timestamps the
+      // bound follows the latest packet, unless the stream is done.
+      Timestamp new_bound = timestamp.NextAllowedInStream();
+      if (next_timestamp_bound == Timestamp::Done() ||
+          (enable_timestamps_ && new_bound < next_timestamp_bound)) {
+        new_bound = next_timestamp_bound;
+      }
+      next_timestamp_bound_.store(new_bound, std::memory_order_release);
+      queue_became_non_empty |= (size_before == 0);
+      queue_became_full |= QueueBecameFull(size_before);
+      if (track_peak_queue_size_) {
+        int64 peak = peak_queue_size_.load(std::memory_order_relaxed);
+        while (size_before + 1 > peak &&
+               !peak_queue_size_.compare_exchange_weak(
+                   peak, size_before + 1, std::memory_order_relaxed)) {
+        }
       }
-    }
-    queue_became_full = (!was_queue_full && max_queue_size_ != -1 &&
-                         queue_.size() >= max_queue_size_);
-    if (queue_.size() > 1) {
-      VLOG(3) << "Queue size greater than 1: stream name: " << name_
-              << " queue_size: " << queue_.size();
     }
     VLOG(3) << "Input stream:" << name_
             << " becomes non-empty status:" << queue_became_non_empty
-            << " Size: " << queue_.size();
+            << " Size: " << queue_.Size();
   }
   if (queue_became_full) {
     VLOG(3) << "Queue became full: " << Name();
@@ -183,30 +213,35 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
 absl::Status InputStreamManager::SetNextTimestampBound(const Timestamp bound,
                                                        bool* notify) {
   *notify = false;
+  // Sparse streams often receive the same bound repeatedly.  An unchanged
+  // bound cannot make the node ready, so it is dropped without locking.
+  if (bound == next_timestamp_bound_.load(std::memory_order_acquire)) {
+    return absl::OkStatus();
+  }
   {
     // Scope to prevent locking the stream when notification is called.
-    absl::MutexLock stream_lock(&stream_mutex_);
+    absl::MutexLockMaybe stream_lock(StreamMutex());
     if (closed_) {
       return absl::OkStatus();
     }
 
-    if (enable_timestamps_ && bound < next_timestamp_bound_) {
+    const Timestamp next_timestamp_bound = LoadNextTimestampBound();
+    if (enable_timestamps_ && bound < next_timestamp_bound) {
       return mediapipe::UnknownErrorBuilder(MEDIAPIPE_LOC)
              << "SetNextTimestampBound must be called with a timestamp greater "
                 "than or equal to the current bound. In stream \""
              << name_ << "\". Current minimum expected timestamp is "
-             << next_timestamp_bound_.DebugString() << " but received "
+             << next_timestamp_bound.DebugString() << " but received "
              << bound.DebugString();
     }
 
     // Even if enable_timestamps_ is false, Timestamp::Done() is used to
     // indicate the end of stream. So this code is common to both timed and
     // untimed scheduling policies.
-    if (bound > next_timestamp_bound_) {
-      next_timestamp_bound_ = bound;
+    if (UpdateNextTimestampBound(bound, /*allow_decrease=*/false)) {
       VLOG(3) << "Next timestamp bound for input " << name_ << " is "
-              << next_timestamp_bound_;
-      if (queue_.empty()) {
+              << bound;
+      if (queue_.Size() == 0) {
         // If the queue was not empty then a change to the next_timestamp_bound_
         // is not detectable by the consumer.
         *notify = true;
@@ -216,29 +251,60 @@ absl::Status InputStreamManager::SetNextTimestampBound(const Timestamp bound,
   return absl::OkStatus();
 }
 
+bool InputStreamManager::UpdateNextTimestampBound(Timestamp bound,
+                                                  bool allow_decrease) {
+  Timestamp current = LoadNextTimestampBound();
+  while (bound > current ||
+         (allow_decrease && bound < current && current != Timestamp::Done())) {
+    if (next_timestamp_bound_.compare_exchange_weak(
+            current, bound, std::memory_order_release,
+            std::memory_order_relaxed)) {
+      return bound > current;
+    }
+    if (current == AddingBound()) {
+      current = LoadNextTimestampBound();
+    }
+  }
+  return false;
+}
+
+Timestamp InputStreamManager::LoadNextTimestampBound() const {
+  Timestamp bound = next_timestamp_bound_.load(std::memory_order_acquire);
+  while (bound == AddingBound()) {
+    // The producer holds the bound only while it queues one packet.
+    std::this_thread::yield();
+    bound = next_timestamp_bound_.load(std::memory_order_acquire);
+  }
+  return bound;
+}
+
 void InputStreamManager::DisableTimestamps() { enable_timestamps_ = false; }
 
 void InputStreamManager::Close() {
-  absl::MutexLock stream_lock(&stream_mutex_);
+  absl::MutexLockMaybe stream_lock(StreamMutex());
   if (closed_) {
     return;
   }
-  next_timestamp_bound_ = Timestamp::Done();
+  UpdateNextTimestampBound(Timestamp::Done(), /*allow_decrease=*/false);
   last_select_timestamp_ = Timestamp::Done();
   closed_ = true;
 }
 
 Timestamp InputStreamManager::MinTimestampOrBound(bool* is_empty) const {
-  absl::MutexLock stream_lock(&stream_mutex_);
-  if (is_empty) {
-    *is_empty = queue_.empty();
-  }
-  return MinTimestampOrBoundHelper();
+  absl::MutexLockMaybe stream_lock(StreamMutex());
+  return MinTimestampOrBoundHelper(is_empty);
 }
 
-Timestamp InputStreamManager::MinTimestampOrBoundHelper() const
-    ABSL_EXCLUSIVE_LOCKS_REQUIRED(stream_mutex_) {
-  return queue_.empty() ? next_timestamp_bound_ : queue_.front().Timestamp();
+Timestamp InputStreamManager::MinTimestampOrBoundHelper(
+    bool* is_empty) const {
+  // The bound must be read before the queue: the producer queues a packet
+  // before advancing the bound past it.
+  const Timestamp bound = LoadNextTimestampBound();
+  const Packet* head = queue_.Front();
+  if (is_empty) {
+    *is_empty = (head == nullptr);
+  }
+  return head == nullptr ? bound : head->Timestamp();
 }
 
 Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
@@ -250,45 +316,42 @@ Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
   bool queue_became_non_full = false;
   Packet packet;
   {
-    absl::MutexLock stream_lock(&stream_mutex_);
+    absl::MutexLockMaybe stream_lock(StreamMutex());
     // Make sure timestamp didn't decrease from last time.
-    CHECK_LE(last_select_timestamp_, timestamp);
+    CHECK_LE(last_select_timestamp_.load(), timestamp);
     last_select_timestamp_ = timestamp;
 
     // Make sure AddPacket and SetNextTimestampBound are not called with
     // timestamps we have already passed.
-    if (next_timestamp_bound_ <= timestamp) {
-      next_timestamp_bound_ = timestamp.NextAllowedInStream();
-    }
+    UpdateNextTimestampBound(timestamp.NextAllowedInStream(),
+                             /*allow_decrease=*/false);
 
     VLOG(3) << "Input stream " << name_
             << " selecting at timestamp:" << timestamp.Value()
-            << " next timestamp bound: " << next_timestamp_bound_;
+            << " next timestamp bound: " << LoadNextTimestampBound();
 
     // Advances time to timestamp.
     Timestamp current_timestamp = Timestamp::Unset();
 
-    // Checks if queue is full.
-    bool was_queue_full =
-        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
-
-    while (!queue_.empty() && queue_.front().Timestamp() <= timestamp) {
-      packet = std::move(queue_.front());
-      queue_.pop_front();
+    const Packet* head;
+    while ((head = queue_.Front()) != nullptr &&
+           head->Timestamp() <= timestamp) {
+      int64 size_before;
+      packet = queue_.Pop(&size_before);
+      queue_became_non_full |= QueueBecameNonFull(size_before);
       current_timestamp = packet.Timestamp();
       ++(*num_packets_dropped);
     }
     // Clear value_ if it doesn't have exactly the right timestamp.
     if (current_timestamp != timestamp) {
       // The timestamp bound reported when no packet is sent.
-      Timestamp bound = MinTimestampOrBoundHelper();
+      Timestamp bound = MinTimestampOrBoundHelper(nullptr);
       packet = Packet().At(bound.PreviousAllowedInStream());
       ++(*num_packets_dropped);
     }
 
     VLOG(3) << "Input stream removed packets:" << name_
-            << " Size:" << queue_.size();
-    queue_became_non_full = (was_queue_full && queue_.size() < max_queue_size_);
+            << " Size:" << queue_.Size();
     *stream_is_done = IsDone();
   }
   if (queue_became_non_full) {
@@ -304,24 +367,20 @@ Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
   bool queue_became_non_full = false;
   Packet packet;
   {
-    absl::MutexLock stream_lock(&stream_mutex_);
+    absl::MutexLockMaybe stream_lock(StreamMutex());
 
     VLOG(3) << "Input stream " << name_ << " selecting at queue head";
 
-    // Check if queue is full.
-    bool was_queue_full =
-        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
-
-    if (!queue_.empty()) {
-      packet = std::move(queue_.front());
-      queue_.pop_front();
+    if (queue_.Front() != nullptr) {
+      int64 size_before;
+      packet = queue_.Pop(&size_before);
+      queue_became_non_full = QueueBecameNonFull(size_before);
     } else {
       packet = Packet();
     }
 
     VLOG(3) << "Input stream removed a packet:" << name_
-            << " Size:" << queue_.size();
-    queue_became_non_full = (was_queue_full && queue_.size() < max_queue_size_);
+            << " Size:" << queue_.Size();
     *stream_is_done = IsDone();
   }
   if (queue_became_non_full) {
@@ -331,29 +390,59 @@ Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
   return packet;
 }
 
-int InputStreamManager::NumPacketsAdded() const {
-  absl::MutexLock lock(&stream_mutex_);
-  return num_packets_added_;
+int InputStreamManager::PopQueuedPackets(int max_packets,
+                                         std::vector<Packet>* packets) {
+  int num_popped = 0;
+  bool queue_became_non_full = false;
+  {
+    absl::MutexLockMaybe stream_lock(StreamMutex());
+    while (num_popped < max_packets && queue_.Front() != nullptr) {
+      int64 size_before;
+      packets->push_back(queue_.Pop(&size_before));
+      queue_became_non_full |= QueueBecameNonFull(size_before);
+      ++num_popped;
+    }
+    if (num_popped > 0 && enable_timestamps_) {
+      Timestamp timestamp = packets->back().Timestamp();
+      last_select_timestamp_ = timestamp;
+      UpdateNextTimestampBound(timestamp.NextAllowedInStream(),
+                               /*allow_decrease=*/false);
+    }
+    VLOG(3) << "Input stream removed " << num_popped << " packets:" << name_
+            << " Size:" << queue_.Size();
+  }
+  if (queue_became_non_full) {
+    VLOG(3) << "Queue became non-full: " << Name();
+    becomes_not_full_callback_(this, &last_reported_stream_full_);
+  }
+  return num_popped;
 }
 
+int InputStreamManager::NumPacketsAdded() const { return num_packets_added_; }
+
 int InputStreamManager::QueueSize() const {
-  absl::MutexLock lock(&stream_mutex_);
-  return static_cast<int>(queue_.size());
+  return static_cast<int>(queue_.Size());
 }
 
-int InputStreamManager::MaxQueueSize() const {
-  absl::MutexLock lock(&stream_mutex_);
-  return max_queue_size_;
+int InputStreamManager::TakePeakQueueSize() {
+  const int64 peak = peak_queue_size_.exchange(0, std::memory_order_relaxed);
+  return static_cast<int>(std::max<int64>(peak, queue_.Size()));
 }
 
+int InputStreamManager::MaxQueueSize() const { return max_queue_size_; }
+
 void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
   bool was_full;
   bool is_full;
   {
-    absl::MutexLock lock(&stream_mutex_);
-    was_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
-    max_queue_size_ = max_queue_size;
-    is_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    absl::MutexLockMaybe lock(StreamMutex());
+    // The new maximum is published before the size is read, and pushes and
+    // pops update the size before reading the maximum, so a concurrent push
+    // or pop that crosses the new maximum is reported by one of the two.
+    const int old_max_queue_size = max_queue_size_.exchange(max_queue_size);
+    const int64 queue_size = queue_.Size();
+    was_full = (old_max_queue_size != -1 && queue_size >= old_max_queue_size);
+    is_full = (max_queue_size != -1 && queue_size >= max_queue_size);
   }
 
   // QueueSizeCallback is called with no mutexes held.
@@ -367,33 +456,39 @@ void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
 }
 
 bool InputStreamManager::IsFull() const {
-  absl::MutexLock lock(&stream_mutex_);
-  return max_queue_size_ != -1 && queue_.size() >= max_queue_size_;
+  const int max_queue_size = max_queue_size_;
+  return max_queue_size != -1 && queue_.Size() >= max_queue_size;
+}
+
+bool InputStreamManager::QueueBecameFull(int64 size_before) const {
+  const int max_queue_size = max_queue_size_;
+  return max_queue_size != -1 && size_before + 1 == max_queue_size;
+}
+
+bool InputStreamManager::QueueBecameNonFull(int64 size_before) const {
+  const int max_queue_size = max_queue_size_;
+  return max_queue_size != -1 && size_before == max_queue_size;
 }
 
 Timestamp InputStreamManager::GetMinTimestampAmongNLatest(int n) const {
-  absl::MutexLock lock(&stream_mutex_);
-  if (queue_.empty()) {
-    return Timestamp::Unset();
-  }
-  return (queue_.cend() - std::min((size_t)n, queue_.size()))->Timestamp();
+  absl::MutexLockMaybe lock(StreamMutex());
+  return queue_.GetMinTimestampAmongNLatest(n);
 }
 
 void InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
   bool queue_became_non_full = false;
   {
-    absl::MutexLock lock(&stream_mutex_);
-    // Checks if queue is full.
-    bool was_queue_full =
-        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
-
-    while (!queue_.empty() && queue_.front().Timestamp() < timestamp) {
-      queue_.pop_front();
+    absl::MutexLockMaybe lock(StreamMutex());
+    const Packet* head;
+    while ((head = queue_.Front()) != nullptr &&
+           head->Timestamp() < timestamp) {
+      int64 size_before;
+      queue_.Pop(&size_before);
+      queue_became_non_full |= QueueBecameNonFull(size_before);
     }
 
     VLOG(3) << "Input stream removed packets:" << name_
-            << " Size:" << queue_.size();
-    queue_became_non_full = (was_queue_full && queue_.size() < max_queue_size_);
+            << " Size:" << queue_.Size();
   }
   if (queue_became_non_full) {
     VLOG(3) << "Queue became non-full: " << Name();
@@ -402,7 +497,9 @@ void InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
 }
 
 bool InputStreamManager::IsDone() const {
-  return queue_.empty() && next_timestamp_bound_ == Timestamp::Done();
+  // As in MinTimestampOrBoundHelper, the bound must be read first.
+  const Timestamp bound = LoadNextTimestampBound();
+  return bound == Timestamp::Done() && queue_.Front() == nullptr;
 }
 
 }  // namespace mediapipe
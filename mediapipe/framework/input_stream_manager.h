@@ -15,10 +15,11 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 
-#include <deque>
+#include <atomic>
 #include <functional>
 #include <list>
 #include <string>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
@@ -27,6 +28,7 @@
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/spsc_packet_queue.h"
 #include "mediapipe/framework/timestamp.h"
 
 namespace mediapipe {
@@ -43,6 +45,12 @@ namespace mediapipe {
 // An input stream is written to by exactly one output stream and is read by a
 // single node. None of its methods should hold a lock when they invoke a
 // callback in the scheduler.
+//
+// By default every method takes stream_mutex_. If the producer and the
+// consumer calls are each made by one thread at a time, see
+// SetSingleProducerSingleConsumer(), the packets are passed through a
+// lock-free ring buffer and the timestamp bound is updated with atomic
+// operations, so that adding and popping packets never takes a lock.
 class InputStreamManager {
  public:
   // Function type for becomes_full_callback and becomes_not_full_callback.
@@ -66,6 +74,22 @@ class InputStreamManager {
   // Returns true if the input stream is a back edge.
   bool BackEdge() const { return back_edge_; }
 
+  // Declares whether the stream has a single producer and a single consumer.
+  // If so, stream_mutex_ is not used. The caller must then guarantee that:
+  // * AddPackets() and MovePackets() are called by one thread at a time.
+  // * PopPacketAtTimestamp(), PopQueueHead(), QueueHead(),
+  //   MinTimestampOrBound(), GetMinTimestampAmongNLatest() and
+  //   ErasePacketsEarlierThan() are called by one thread at a time.
+  // The remaining methods may be called from any thread. Must be called
+  // before the graph starts running.
+  void SetSingleProducerSingleConsumer(bool single_producer_single_consumer) {
+    single_producer_single_consumer_ = single_producer_single_consumer;
+  }
+
+  bool SingleProducerSingleConsumer() const {
+    return single_producer_single_consumer_;
+  }
+
   // Sets the header Packet.
   absl::Status SetHeader(const Packet& header);
 
@@ -142,6 +166,13 @@ class InputStreamManager {
   // Timestamp::Done() after the pop.
   Packet PopQueueHead(bool* stream_is_done) ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
+  // Pops up to "max_packets" packets from the head of the queue and appends
+  // them to "packets".  If timestamps are enabled, advances time to the
+  // timestamp of the last packet popped, as PopPacketAtTimestamp() does.
+  // Returns the number of packets popped.
+  int PopQueuedPackets(int max_packets, std::vector<Packet>* packets)
+      ABSL_LOCKS_EXCLUDED(stream_mutex_);
+
   // Returns the number of packets in the queue.
   int NumPacketsAdded() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
@@ -151,6 +182,17 @@ class InputStreamManager {
   // Returns true iff the queue is full.
   bool IsFull() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
+  // Returns the largest number of packets queued since the previous call, or
+  // the current queue size if that is larger. Used by the profiler to sample
+  // queue depth without locking the stream. The largest size is tracked only
+  // after SetTrackPeakQueueSize(true); otherwise this returns the current
+  // queue size.
+  int TakePeakQueueSize();
+
+  // Enables tracking of the largest queue size for TakePeakQueueSize(). Must
+  // not be called while packets are being added.
+  void SetTrackPeakQueueSize(bool track) { track_peak_queue_size_ = track; }
+
   // Returns the max queue size. -1 indicates that there is no maximum.
   int MaxQueueSize() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
@@ -190,21 +232,53 @@ class InputStreamManager {
       ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
   // Returns true if the next timestamp bound reaches Timestamp::Done().
-  bool IsDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(stream_mutex_);
+  bool IsDone() const;
 
   // Returns the smallest timestamp at which this stream might see an input.
-  Timestamp MinTimestampOrBoundHelper() const;
+  // Sets is_empty to queue_.Empty() if it is not nullptr.
+  Timestamp MinTimestampOrBoundHelper(bool* is_empty) const;
+
+  // Sets next_timestamp_bound_ to "bound" if this increases it. If
+  // "allow_decrease" is true, also sets it if this decreases it, unless the
+  // bound has reached Timestamp::Done(). Returns true if the bound was
+  // increased.
+  bool UpdateNextTimestampBound(Timestamp bound, bool allow_decrease);
+
+  // Returns next_timestamp_bound_, waiting for the producer to release it if
+  // it is queuing a packet.
+  Timestamp LoadNextTimestampBound() const;
+
+  // Returns true if a push or a pop that found "size_before" packets in the
+  // queue made it full or non-full, respectively.
+  bool QueueBecameFull(int64 size_before) const;
+  bool QueueBecameNonFull(int64 size_before) const;
+
+  // Returns the mutex to lock for the current access pattern, or nullptr if
+  // the stream has a single producer and a single consumer.
+  absl::Mutex* StreamMutex() const {
+    return single_producer_single_consumer_ ? nullptr : &stream_mutex_;
+  }
 
   mutable absl::Mutex stream_mutex_;
-  std::deque<Packet> queue_ ABSL_GUARDED_BY(stream_mutex_);
+  bool single_producer_single_consumer_ = false;
+  // Mutable since peeking at the queue may lock its overflow mutex.
+  mutable internal::SpscPacketQueue queue_;
   // The number of packets added to queue_.  Used to verify a packet at
   // Timestamp::PostStream() is the only Packet in the stream.
-  int64 num_packets_added_ ABSL_GUARDED_BY(stream_mutex_);
-  Timestamp next_timestamp_bound_ ABSL_GUARDED_BY(stream_mutex_);
+  std::atomic<int64> num_packets_added_;
+  // The largest queue size reached since the last TakePeakQueueSize() call.
+  // Updated only if track_peak_queue_size_ is set.
+  std::atomic<int64> peak_queue_size_{0};
+  bool track_peak_queue_size_ = false;
+  // Written by the producer and, to skip timestamps that have been passed,
+  // by the consumer. Only ever increases if enable_timestamps_ is true. The
+  // producer holds it at a sentinel value while it checks a packet against
+  // it and queues the packet; see LoadNextTimestampBound().
+  std::atomic<Timestamp> next_timestamp_bound_;
   // The |timestamp| argument passed to the last SelectAtTimestamp() call.
   // Ignored if enable_timestamps_ is false.
-  Timestamp last_select_timestamp_ ABSL_GUARDED_BY(stream_mutex_);
-  bool closed_ ABSL_GUARDED_BY(stream_mutex_);
+  std::atomic<Timestamp> last_select_timestamp_;
+  std::atomic<bool> closed_;
   // True if packet timestamps are used.
   bool enable_timestamps_ = true;
   std::string name_;
@@ -214,7 +288,7 @@ class InputStreamManager {
   Packet header_;
 
   // The maximum queue size for this stream if set.
-  int max_queue_size_ ABSL_GUARDED_BY(stream_mutex_) = -1;
+  std::atomic<int> max_queue_size_{-1};
 
   // Callback to notify the framework that we have hit the maximum queue size.
   QueueSizeCallback becomes_full_callback_;
@@ -14,7 +14,12 @@
 
 #include "mediapipe/framework/input_stream_manager.h"
 
+#include <algorithm>
+#include <atomic>
+#include <list>
 #include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
 
 #include "absl/memory/memory.h"
 #include "mediapipe/framework/input_stream_shard.h"
@@ -26,7 +31,8 @@
 
 namespace mediapipe {
 namespace {
-class InputStreamManagerTest : public ::testing::Test {
+// The parameter selects the lock-free single-producer single-consumer mode.
+class InputStreamManagerTest : public ::testing::TestWithParam<bool> {
  protected:
   InputStreamManagerTest() {}
 
@@ -44,6 +50,7 @@ class InputStreamManagerTest : public ::testing::Test {
     input_stream_manager_ = absl::make_unique<InputStreamManager>();
     MP_ASSERT_OK(input_stream_manager_->Initialize("a_test", &packet_type_,
                                                    /*back_edge=*/false));
+    input_stream_manager_->SetSingleProducerSingleConsumer(GetParam());
 
     queue_full_callback_ =
         std::bind(&InputStreamManagerTest::ReportQueueBecomesFull, this,
@@ -89,9 +96,9 @@ class InputStreamManagerTest : public ::testing::Test {
   int queue_becomes_not_full_count_;
 };
 
-TEST_F(InputStreamManagerTest, Init) {}
+TEST_P(InputStreamManagerTest, Init) {}
 
-TEST_F(InputStreamManagerTest, AddPackets) {
+TEST_P(InputStreamManagerTest, AddPackets) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -108,7 +115,7 @@ TEST_F(InputStreamManagerTest, AddPackets) {
   }
 }
 
-TEST_F(InputStreamManagerTest, MovePackets) {
+TEST_P(InputStreamManagerTest, MovePackets) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -128,7 +135,7 @@ TEST_F(InputStreamManagerTest, MovePackets) {
 // InputStreamManager should reject the four timestamps that are not allowed in
 // a stream: Timestamp::Unset(), Timestamp::Unstarted(),
 // Timestamp::OneOverPostStream(), and Timestamp::Done().
-TEST_F(InputStreamManagerTest, AddPacketUnset) {
+TEST_P(InputStreamManagerTest, AddPacketUnset) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp::Unset()));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -139,7 +146,7 @@ TEST_F(InputStreamManagerTest, AddPacketUnset) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketUnstarted) {
+TEST_P(InputStreamManagerTest, AddPacketUnstarted) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::Unstarted()));
@@ -151,7 +158,7 @@ TEST_F(InputStreamManagerTest, AddPacketUnstarted) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketOneOverPostStream) {
+TEST_P(InputStreamManagerTest, AddPacketOneOverPostStream) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::OneOverPostStream()));
@@ -164,7 +171,7 @@ TEST_F(InputStreamManagerTest, AddPacketOneOverPostStream) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketDone) {
+TEST_P(InputStreamManagerTest, AddPacketDone) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp::Done()));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -175,7 +182,7 @@ TEST_F(InputStreamManagerTest, AddPacketDone) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketsOnlyPreStream) {
+TEST_P(InputStreamManagerTest, AddPacketsOnlyPreStream) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::PreStream()));
@@ -189,7 +196,7 @@ TEST_F(InputStreamManagerTest, AddPacketsOnlyPreStream) {
 
 // An attempt to add a packet after Timestamp::PreStream() should be rejected
 // because the next timestamp bound is Timestamp::OneOverPostStream().
-TEST_F(InputStreamManagerTest, AddPacketsAfterPreStream) {
+TEST_P(InputStreamManagerTest, AddPacketsAfterPreStream) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::PreStream()));
@@ -203,7 +210,7 @@ TEST_F(InputStreamManagerTest, AddPacketsAfterPreStream) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketsOnlyPostStream) {
+TEST_P(InputStreamManagerTest, AddPacketsOnlyPostStream) {
   std::list<Packet> packets;
   packets.push_back(
       MakePacket<std::string>("packet 1").At(Timestamp::PostStream()));
@@ -217,7 +224,7 @@ TEST_F(InputStreamManagerTest, AddPacketsOnlyPostStream) {
 
 // A packet at Timestamp::PostStream() must be the only Packet in an input
 // stream.
-TEST_F(InputStreamManagerTest, AddPacketsBeforePostStream) {
+TEST_P(InputStreamManagerTest, AddPacketsBeforePostStream) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(
@@ -230,7 +237,7 @@ TEST_F(InputStreamManagerTest, AddPacketsBeforePostStream) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, AddPacketsReverseTimestamps) {
+TEST_P(InputStreamManagerTest, AddPacketsReverseTimestamps) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(20)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(10)));
@@ -245,7 +252,7 @@ TEST_F(InputStreamManagerTest, AddPacketsReverseTimestamps) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, PopPacketAtTimestamp) {
+TEST_P(InputStreamManagerTest, PopPacketAtTimestamp) {
   std::string expected_value_at_10("packet 1");
   std::string expected_value_at_20("packet 2");
   std::string expected_value_at_30("packet 3");
@@ -329,7 +336,7 @@ TEST_F(InputStreamManagerTest, PopPacketAtTimestamp) {
   EXPECT_TRUE(stream_is_done_);
 }
 
-TEST_F(InputStreamManagerTest, PopQueueHead) {
+TEST_P(InputStreamManagerTest, PopQueueHead) {
   input_stream_manager_->DisableTimestamps();
   std::string expected_value_at_10("packet 1");
   std::string expected_value_at_20("packet 2");
@@ -393,7 +400,7 @@ TEST_F(InputStreamManagerTest, PopQueueHead) {
   EXPECT_TRUE(stream_is_done_);
 }
 
-TEST_F(InputStreamManagerTest, BadPacketType) {
+TEST_P(InputStreamManagerTest, BadPacketType) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<int>(10).At(Timestamp(10)));
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
@@ -404,7 +411,7 @@ TEST_F(InputStreamManagerTest, BadPacketType) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, Close) {
+TEST_P(InputStreamManagerTest, Close) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -427,7 +434,7 @@ TEST_F(InputStreamManagerTest, Close) {
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
 }
 
-TEST_F(InputStreamManagerTest, ReuseInputStreamManager) {
+TEST_P(InputStreamManagerTest, ReuseInputStreamManager) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -480,7 +487,7 @@ TEST_F(InputStreamManagerTest, ReuseInputStreamManager) {
   EXPECT_TRUE(input_stream_manager_->IsEmpty());
 }
 
-TEST_F(InputStreamManagerTest, MultipleNotifications) {
+TEST_P(InputStreamManagerTest, MultipleNotifications) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -516,7 +523,7 @@ TEST_F(InputStreamManagerTest, MultipleNotifications) {
   EXPECT_TRUE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, SetHeader) {
+TEST_P(InputStreamManagerTest, SetHeader) {
   Packet header = MakePacket<std::string>("blah");
   MP_ASSERT_OK(input_stream_manager_->SetHeader(header));
 
@@ -525,7 +532,7 @@ TEST_F(InputStreamManagerTest, SetHeader) {
   EXPECT_EQ(header.Timestamp(), input_stream_manager_->Header().Timestamp());
 }
 
-TEST_F(InputStreamManagerTest, BackwardsInTime) {
+TEST_P(InputStreamManagerTest, BackwardsInTime) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -592,7 +599,7 @@ TEST_F(InputStreamManagerTest, BackwardsInTime) {
   EXPECT_FALSE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, SelectBackwardsInTime) {
+TEST_P(InputStreamManagerTest, SelectBackwardsInTime) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -636,7 +643,7 @@ TEST_F(InputStreamManagerTest, SelectBackwardsInTime) {
                "");
 }
 
-TEST_F(InputStreamManagerTest, TimestampBound) {
+TEST_P(InputStreamManagerTest, TimestampBound) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
   packets.push_back(MakePacket<std::string>("packet 2").At(Timestamp(20)));
@@ -746,7 +753,7 @@ TEST_F(InputStreamManagerTest, TimestampBound) {
             input_stream_manager_->MinTimestampOrBound(&is_empty));
 }
 
-TEST_F(InputStreamManagerTest, QueueSizeTest) {
+TEST_P(InputStreamManagerTest, QueueSizeTest) {
   std::list<Packet> packets;
   int max_queue_size = 2;
   input_stream_manager_->SetMaxQueueSize(max_queue_size);
@@ -783,11 +790,12 @@ TEST_F(InputStreamManagerTest, QueueSizeTest) {
   expected_queue_becomes_not_full_count_ = 1;
 }
 
-TEST_F(InputStreamManagerTest, InputReleaseTest) {
+TEST_P(InputStreamManagerTest, InputReleaseTest) {
   packet_type_.Set<LifetimeTracker::Object>();
   input_stream_manager_ = absl::make_unique<InputStreamManager>();
   MP_ASSERT_OK(input_stream_manager_->Initialize("a_test", &packet_type_,
                                                  /*back_edge=*/false));
+  input_stream_manager_->SetSingleProducerSingleConsumer(GetParam());
   input_stream_manager_->PrepareForRun();
   input_stream_manager_->SetQueueSizeCallbacks(queue_full_callback_,
                                                queue_not_full_callback_);
@@ -833,7 +841,7 @@ TEST_F(InputStreamManagerTest, InputReleaseTest) {
 
 // An attempt to add a packet after Timestamp::PreStream() should be allowed
 // if packet timestamps don't need to be increasing.
-TEST_F(InputStreamManagerTest, AddPacketsAfterPreStreamUntimed) {
+TEST_P(InputStreamManagerTest, AddPacketsAfterPreStreamUntimed) {
   input_stream_manager_->DisableTimestamps();
   std::list<Packet> packets;
   packets.push_back(
@@ -849,7 +857,7 @@ TEST_F(InputStreamManagerTest, AddPacketsAfterPreStreamUntimed) {
 
 // A packet at Timestamp::PostStream() doesn't need to be the only Packet in
 // an input stream if packet timestamps don't need to be increasing.
-TEST_F(InputStreamManagerTest, AddPacketsBeforePostStreamUntimed) {
+TEST_P(InputStreamManagerTest, AddPacketsBeforePostStreamUntimed) {
   input_stream_manager_->DisableTimestamps();
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
@@ -863,7 +871,7 @@ TEST_F(InputStreamManagerTest, AddPacketsBeforePostStreamUntimed) {
   EXPECT_TRUE(notify_);
 }
 
-TEST_F(InputStreamManagerTest, BackwardsInTimeUntimed) {
+TEST_P(InputStreamManagerTest, BackwardsInTimeUntimed) {
   input_stream_manager_->DisableTimestamps();
   std::list<Packet> packets;
   packets.push_back(MakePacket<std::string>("packet 1").At(Timestamp(10)));
@@ -924,5 +932,133 @@ TEST_F(InputStreamManagerTest, BackwardsInTimeUntimed) {
   EXPECT_TRUE(notify_);
 }
 
+// Queues more packets than fit in the lock-free ring buffer.
+TEST_P(InputStreamManagerTest, LongQueueKeepsOrder) {
+  constexpr int kNumPackets = 300;
+  std::list<Packet> packets;
+  for (int i = 1; i <= kNumPackets; ++i) {
+    packets.push_back(MakePacket<std::string>("packet").At(Timestamp(i)));
+  }
+  MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  EXPECT_EQ(kNumPackets, input_stream_manager_->QueueSize());
+  EXPECT_EQ(Timestamp(kNumPackets - 9),
+            input_stream_manager_->GetMinTimestampAmongNLatest(10));
+  EXPECT_EQ(Timestamp(1),
+            input_stream_manager_->GetMinTimestampAmongNLatest(kNumPackets));
+
+  // Interleave pops with new packets while the queue is long.
+  for (int i = 1; i <= kNumPackets; ++i) {
+    popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+        Timestamp(i), &num_packets_dropped_, &stream_is_done_);
+    EXPECT_EQ(Timestamp(i), popped_packet_.Timestamp());
+    EXPECT_EQ(0, num_packets_dropped_);
+    packets.clear();
+    packets.push_back(
+        MakePacket<std::string>("packet").At(Timestamp(kNumPackets + i)));
+    MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  }
+  input_stream_manager_->ErasePacketsEarlierThan(Timestamp(kNumPackets + 101));
+  EXPECT_EQ(Timestamp(kNumPackets + 101),
+            input_stream_manager_->QueueHead().Timestamp());
+  EXPECT_EQ(kNumPackets - 100, input_stream_manager_->QueueSize());
+}
+
+// A producer thread and a consumer thread, as in a running graph.
+TEST_P(InputStreamManagerTest, ConcurrentProducerAndConsumer) {
+  constexpr int kNumPackets = 20000;
+  constexpr int kMaxQueueSize = 8;
+  std::atomic<int> full_count{0};
+  std::atomic<int> not_full_count{0};
+  input_stream_manager_->SetQueueSizeCallbacks(
+      [&full_count](InputStreamManager*, bool*) { ++full_count; },
+      [&not_full_count](InputStreamManager*, bool*) { ++not_full_count; });
+  input_stream_manager_->SetMaxQueueSize(kMaxQueueSize);
+
+  std::thread producer([this]() {
+    for (int i = 0; i < kNumPackets; ++i) {
+      bool notify;
+      if (i % 3 == 0) {
+        MP_ASSERT_OK(input_stream_manager_->SetNextTimestampBound(
+            Timestamp(2 * i), &notify));
+      }
+      // Only every other timestamp has a packet.
+      std::list<Packet> packets = {Adopt(new std::string("packet"))
+                                       .At(Timestamp(2 * i))};
+      MP_ASSERT_OK(input_stream_manager_->MovePackets(&packets, &notify));
+    }
+    bool notify;
+    MP_ASSERT_OK(
+        input_stream_manager_->SetNextTimestampBound(Timestamp::Done(), &notify));
+  });
+
+  int num_packets_received = 0;
+  Timestamp last_timestamp = Timestamp::Unstarted();
+  bool stream_is_done = false;
+  while (!stream_is_done) {
+    bool is_empty;
+    Timestamp timestamp = input_stream_manager_->MinTimestampOrBound(&is_empty);
+    if (is_empty) {
+      if (timestamp == Timestamp::Done()) break;
+      std::this_thread::yield();
+      continue;
+    }
+    Packet packet = input_stream_manager_->PopPacketAtTimestamp(
+        timestamp, &num_packets_dropped_, &stream_is_done);
+    ASSERT_EQ(0, num_packets_dropped_);
+    ASSERT_EQ(timestamp, packet.Timestamp());
+    ASSERT_LT(last_timestamp, timestamp);
+    last_timestamp = timestamp;
+    ++num_packets_received;
+  }
+  producer.join();
+  EXPECT_EQ(kNumPackets, num_packets_received);
+  EXPECT_TRUE(input_stream_manager_->IsEmpty());
+  EXPECT_EQ(full_count.load(), not_full_count.load());
+}
+
+// The consumer selects timestamps ahead of the producer, as handlers that
+// align several streams do. A packet is either rejected or queued ahead of
+// every selected timestamp; it never ends up behind the consumer.
+TEST_P(InputStreamManagerTest, PacketsBehindConsumerAreRejected) {
+  constexpr int kNumPackets = 20000;
+  std::atomic<bool> producer_done{false};
+  int num_rejected = 0;
+  std::thread producer([&]() {
+    for (int i = 0; i < kNumPackets; ++i) {
+      bool notify;
+      std::list<Packet> packets = {
+          Adopt(new std::string("packet")).At(Timestamp(i))};
+      if (!input_stream_manager_->MovePackets(&packets, &notify).ok()) {
+        ++num_rejected;
+      }
+    }
+    producer_done = true;
+  });
+
+  int num_popped = 0;
+  Timestamp last_selected = Timestamp::Unstarted();
+  auto pop_at = [&](Timestamp timestamp) {
+    Packet head = input_stream_manager_->QueueHead();
+    if (!head.IsEmpty()) {
+      EXPECT_LT(last_selected, head.Timestamp());
+    }
+    bool stream_is_done;
+    Packet packet = input_stream_manager_->PopPacketAtTimestamp(
+        timestamp, &num_packets_dropped_, &stream_is_done);
+    num_popped += num_packets_dropped_ + (packet.IsEmpty() ? 0 : 1);
+    last_selected = timestamp;
+  };
+  for (int t = 0; !producer_done; ++t) {
+    pop_at(Timestamp(std::min(t, kNumPackets)));
+  }
+  producer.join();
+  pop_at(Timestamp(kNumPackets));
+  EXPECT_EQ(kNumPackets, num_popped + num_rejected);
+  EXPECT_TRUE(input_stream_manager_->IsEmpty());
+}
+
+INSTANTIATE_TEST_SUITE_P(LockedAndLockFree, InputStreamManagerTest,
+                         testing::Bool());
+
 }  // namespace
 }  // namespace mediapipe
@@ -15,7 +15,7 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_SHARD_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_SHARD_H_
 
-#include <queue>
+#include <deque>
 #include <string>
 #include <utility>
 
@@ -51,6 +51,18 @@ class InputStreamShard : public InputStream {
     return !packet_queue_.empty() ? packet_queue_.front() : empty_packet_;
   }
 
+  // Returns the packet of input set "index" of a batched call to
+  // Calculator::Process(). See CalculatorContext::BatchSize().
+  const Packet& BatchValue(int index) const {
+    CHECK_LT(index, NumberOfPackets());
+    return packet_queue_[index];
+  }
+
+  Packet& BatchValue(int index) {
+    CHECK_LT(index, NumberOfPackets());
+    return packet_queue_[index];
+  }
+
   // Returns a reference to the name string of the InputStreamManager.
   const std::string& Name() const { return *name_; }
 
@@ -63,7 +75,7 @@ class InputStreamShard : public InputStream {
 
   void ClearCurrentPacket() {
     if (!packet_queue_.empty()) {
-      packet_queue_.pop();
+      packet_queue_.pop_front();
     }
   }
 
@@ -72,7 +84,7 @@ class InputStreamShard : public InputStream {
   void AddPacket(Packet&& value, bool is_done);
 
   // Packet storage for batch processing.
-  std::queue<Packet> packet_queue_;
+  std::deque<Packet> packet_queue_;
   Packet empty_packet_;
 
   // Pointer to the name string of the InputStreamManager.
@@ -14,6 +14,8 @@
 
 #include "mediapipe/framework/output_stream_manager.h"
 
+#include "absl/algorithm/container.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/input_stream_handler.h"
 #include "mediapipe/framework/port/status_builder.h"
@@ -52,10 +54,7 @@ void OutputStreamManager::Close() {
     next_timestamp_bound_ = Timestamp::Done();
   }
 
-  for (const auto& mirror : mirrors_) {
-    mirror.input_stream_handler->SetNextTimestampBound(mirror.id,
-                                                       Timestamp::Done());
-  }
+  SetMirrorsNextTimestampBound(Timestamp::Done());
 }
 
 bool OutputStreamManager::IsClosed() const {
@@ -164,9 +163,13 @@ Timestamp OutputStreamManager::ComputeOutputTimestampBound(
 void OutputStreamManager::PropagateUpdatesToMirrors(
     Timestamp next_timestamp_bound, OutputStreamShard* output_stream_shard) {
   CHECK(output_stream_shard);
+  // Whether the bound differs from the last one sent to the mirrors.  Sparse
+  // streams often repeat the same bound, which the mirrors already hold.
+  bool bound_changed = false;
   {
     if (next_timestamp_bound != Timestamp::Unset()) {
       absl::MutexLock lock(&stream_mutex_);
+      bound_changed = next_timestamp_bound != next_timestamp_bound_;
       next_timestamp_bound_ = next_timestamp_bound;
       VLOG(3) << "Next timestamp bound for output " << output_stream_spec_.name
               << " is " << next_timestamp_bound_;
@@ -179,14 +182,14 @@ void OutputStreamManager::PropagateUpdatesToMirrors(
           << " next timestamp: " << next_timestamp_bound;
   bool add_packets = !packets_to_propagate->empty();
   bool set_bound =
-      (next_timestamp_bound != Timestamp::Unset()) &&
+      bound_changed &&
       (!add_packets ||
        packets_to_propagate->back().Timestamp().NextAllowedInStream() !=
            next_timestamp_bound);
-  int mirror_count = mirrors_.size();
-  for (int idx = 0; idx < mirror_count; ++idx) {
-    const Mirror& mirror = mirrors_[idx];
-    if (add_packets) {
+  if (add_packets) {
+    int mirror_count = mirrors_.size();
+    for (int idx = 0; idx < mirror_count; ++idx) {
+      const Mirror& mirror = mirrors_[idx];
       // If the stream is the last element in mirrors_, moves packets from
       // output_queue_. Otherwise, copies the packets.
       if (idx == mirror_count - 1) {
@@ -197,15 +200,31 @@ void OutputStreamManager::PropagateUpdatesToMirrors(
                                                 *packets_to_propagate);
       }
     }
-    if (set_bound) {
-      mirror.input_stream_handler->SetNextTimestampBound(mirror.id,
-                                                         next_timestamp_bound);
-    }
+  }
+  if (set_bound) {
+    SetMirrorsNextTimestampBound(next_timestamp_bound);
   }
   // Clear out the packets.
   packets_to_propagate->clear();
 }
 
+void OutputStreamManager::SetMirrorsNextTimestampBound(Timestamp bound) {
+  // All mirrors are updated before any node is notified, so that a node
+  // reading this stream through several mirrors checks its readiness once.
+  absl::InlinedVector<InputStreamHandler*, 4> handlers_to_notify;
+  for (const auto& mirror : mirrors_) {
+    if (mirror.input_stream_handler->UpdateNextTimestampBound(mirror.id,
+                                                              bound) &&
+        !absl::c_linear_search(handlers_to_notify,
+                               mirror.input_stream_handler)) {
+      handlers_to_notify.push_back(mirror.input_stream_handler);
+    }
+  }
+  for (InputStreamHandler* handler : handlers_to_notify) {
+    handler->NotifyInputStreamsUpdated();
+  }
+}
+
 void OutputStreamManager::ResetShard(OutputStreamShard* output_stream_shard) {
   Timestamp next_timestamp_bound;
   bool closed = false;
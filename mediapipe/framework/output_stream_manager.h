@@ -111,6 +111,10 @@ class OutputStreamManager {
     const CollectionItemId id;
   };
 
+  // Sets the next timestamp bound of all mirrors, notifying each downstream
+  // node at most once.
+  void SetMirrorsNextTimestampBound(Timestamp bound);
+
   // The output stream spec shared across all output stream shards and the
   // output stream manager.
   OutputStreamSpec output_stream_spec_;
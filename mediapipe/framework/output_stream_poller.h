@@ -15,7 +15,9 @@
 #ifndef MEDIAPIPE_FRAMEWORK_OUTPUT_STREAM_POLLER_H_
 #define MEDIAPIPE_FRAMEWORK_OUTPUT_STREAM_POLLER_H_
 
+#include <limits>
 #include <memory>
+#include <vector>
 
 #include "mediapipe/framework/graph_output_stream.h"
 
@@ -48,6 +50,20 @@ class OutputStreamPoller {
     return poller->Next(packet);
   }
 
+  // Gets all the packets queued on the stream, up to max_packets, taking the
+  // stream lock once (block until at least one packet is available or the
+  // stream is done).  A timestamp bound, if observed, is returned as a
+  // single empty packet.  Returns true if successful.
+  ABSL_MUST_USE_RESULT bool NextBatch(
+      std::vector<Packet>* packets,
+      int max_packets = std::numeric_limits<int>::max()) {
+    auto poller = internal_poller_impl_.lock();
+    if (!poller) {
+      return false;
+    }
+    return poller->NextBatch(max_packets, packets);
+  }
+
   void SetMaxQueueSize(int queue_size) {
     auto poller = internal_poller_impl_.lock();
     CHECK(poller) << "OutputStreamPollerImpl is already destroyed.";
@@ -14,6 +14,9 @@
 
 #include "mediapipe/framework/packet.h"
 
+#include <atomic>
+#include <cstdint>
+
 #include "absl/strings/str_cat.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/canonical_errors.h"
@@ -25,9 +28,30 @@
 
 namespace mediapipe {
 namespace packet_internal {
+namespace {
+
+std::atomic<int64_t> consumed_count{0};
+std::atomic<int64_t> copied_count{0};
+std::atomic<int64_t> failed_count{0};
+
+}  // namespace
 
 HolderBase::~HolderBase() {}
 
+void RecordConsumeOutcome(ConsumeOutcome outcome) {
+  switch (outcome) {
+    case ConsumeOutcome::kConsumed:
+      consumed_count.fetch_add(1, std::memory_order_relaxed);
+      break;
+    case ConsumeOutcome::kCopied:
+      copied_count.fetch_add(1, std::memory_order_relaxed);
+      break;
+    case ConsumeOutcome::kFailed:
+      failed_count.fetch_add(1, std::memory_order_relaxed);
+      break;
+  }
+}
+
 Packet Create(HolderBase* holder) {
   Packet result;
   result.holder_.reset(holder);
@@ -66,6 +90,15 @@ absl::StatusOr<Packet> PacketFromDynamicProto(const std::string& type_name,
 
 }  // namespace packet_internal
 
+PacketConsumeStats GetPacketConsumeStats() {
+  PacketConsumeStats stats;
+  stats.consumed =
+      packet_internal::consumed_count.load(std::memory_order_relaxed);
+  stats.copied = packet_internal::copied_count.load(std::memory_order_relaxed);
+  stats.failed = packet_internal::failed_count.load(std::memory_order_relaxed);
+  return stats;
+}
+
 Packet Packet::At(class Timestamp timestamp) const& {
   Packet result(*this);
   result.timestamp_ = timestamp;
@@ -18,6 +18,7 @@
 #define MEDIAPIPE_FRAMEWORK_PACKET_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -55,6 +56,20 @@ const std::shared_ptr<HolderBase>& GetHolderShared(const Packet& packet);
 std::shared_ptr<HolderBase> GetHolderShared(Packet&& packet);
 absl::StatusOr<Packet> PacketFromDynamicProto(const std::string& type_name,
                                               const std::string& serialized);
+
+// The outcome of a Packet::Consume() or Packet::ConsumeOrCopy() call, which
+// is counted in PacketConsumeStats.
+enum class ConsumeOutcome { kConsumed, kCopied, kFailed };
+void RecordConsumeOutcome(ConsumeOutcome outcome);
+
+// Returns a copy of |value| for Packet::ConsumeOrCopy().  Payload types which
+// are not copy-constructible, such as ImageFrame and Tensor, declare an
+// overload of CopyPacketPayload next to the type, which is found by
+// argument-dependent lookup.
+template <typename T>
+std::unique_ptr<T> CopyPacketPayload(const T& value) {
+  return absl::make_unique<T>(value);
+}
 }  // namespace packet_internal
 
 // A generic container class which can hold data of any type.  The type of
@@ -348,6 +363,19 @@ std::shared_ptr<const T> SharedPtrWithPacket(Packet packet) {
       ptr, [packet = std::move(packet)](const T* ptr) mutable { packet = {}; });
 }
 
+// Counts the outcomes of Packet::Consume() and Packet::ConsumeOrCopy() in
+// this process.  Copies and failures mean that payloads meant to be modified
+// in place were still shared, for example by a stream with several consumers.
+struct PacketConsumeStats {
+  // The calls that took over the payload without copying it.
+  int64_t consumed = 0;
+  // The ConsumeOrCopy() calls that copied a shared payload.
+  int64_t copied = 0;
+  // The Consume() calls that failed because the payload was shared.
+  int64_t failed = 0;
+};
+PacketConsumeStats GetPacketConsumeStats();
+
 //// Implementation details.
 namespace packet_internal {
 
@@ -518,8 +546,7 @@ class Holder : public HolderBase {
       return InternalError(
           "Foreign holder can't release data ptr without ownership.");
     }
-    // Casts away constness to make the data mutable after the release.
-    std::unique_ptr<T> data_ptr(const_cast<T*>(ptr_));
+    std::unique_ptr<T> data_ptr(ReleaseData());
     ptr_ = nullptr;
     return std::move(data_ptr);
   }
@@ -547,6 +574,14 @@ class Holder : public HolderBase {
   // Holder itself may be shared by several Packets.
   const T* ptr_;
 
+  // Returns a pointer to the data that the caller takes ownership of. Called
+  // by Release(), which then clears ptr_. Holders that do not store the data
+  // in its own heap allocation override this to hand out a separate object.
+  virtual T* ReleaseData() {
+    // Casts away constness to make the data mutable after the release.
+    return const_cast<T*>(ptr_);
+  }
+
   // Returns the MessageLite pointer to the data, if the underlying object type
   // is protocol buffer, otherwise, nullptr is returned.
   const proto_ns::MessageLite* GetProtoMessageLite() override {
@@ -640,9 +675,13 @@ inline absl::StatusOr<std::unique_ptr<T>> Packet::Consume() {
     if (release_result.ok()) {
       VLOG(2) << "Setting " << DebugString() << " to empty.";
       holder_.reset();
+      packet_internal::RecordConsumeOutcome(
+          packet_internal::ConsumeOutcome::kConsumed);
     }
     return release_result;
   }
+  packet_internal::RecordConsumeOutcome(
+      packet_internal::ConsumeOutcome::kFailed);
   // If packet isn't the sole owner of the holder, returns kFailedPrecondition
   // error with message.
   return absl::Status(absl::StatusCode::kFailedPrecondition,
@@ -662,6 +701,8 @@ inline absl::StatusOr<std::unique_ptr<T>> Packet::ConsumeOrCopy(
     if (release_result.ok()) {
       VLOG(2) << "Setting " << DebugString() << " to empty.";
       holder_.reset();
+      packet_internal::RecordConsumeOutcome(
+          packet_internal::ConsumeOutcome::kConsumed);
     }
     if (was_copied) {
       *was_copied = false;
@@ -669,9 +710,12 @@ inline absl::StatusOr<std::unique_ptr<T>> Packet::ConsumeOrCopy(
     return release_result;
   }
   VLOG(2) << "Copying the data of " << DebugString();
-  std::unique_ptr<T> data_ptr = absl::make_unique<T>(Get<T>());
+  using packet_internal::CopyPacketPayload;
+  std::unique_ptr<T> data_ptr = CopyPacketPayload(Get<T>());
   VLOG(2) << "Setting " << DebugString() << " to empty.";
   holder_.reset();
+  packet_internal::RecordConsumeOutcome(
+      packet_internal::ConsumeOutcome::kCopied);
   if (was_copied) {
     *was_copied = true;
   }
@@ -692,6 +736,8 @@ inline absl::StatusOr<std::unique_ptr<T>> Packet::ConsumeOrCopy(
     if (release_result.ok()) {
       VLOG(2) << "Setting " << DebugString() << " to empty.";
       holder_.reset();
+      packet_internal::RecordConsumeOutcome(
+          packet_internal::ConsumeOutcome::kConsumed);
     }
     if (was_copied) {
       *was_copied = false;
@@ -708,6 +754,8 @@ inline absl::StatusOr<std::unique_ptr<T>> Packet::ConsumeOrCopy(
             std::begin(*data_ptr));
   VLOG(2) << "Setting " << DebugString() << " to empty.";
   holder_.reset();
+  packet_internal::RecordConsumeOutcome(
+      packet_internal::ConsumeOutcome::kCopied);
   if (was_copied) {
     *was_copied = true;
   }
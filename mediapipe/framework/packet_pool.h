@@ -0,0 +1,220 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// MakePacketFromPool<T>() creates a Packet whose holder, shared_ptr control
+// block and payload live in a single block taken from a per-thread free list.
+//
+// MakePacket<T>() performs three heap allocations per packet: one for the
+// payload, one for the Holder and one for the shared_ptr control block. For
+// streams that produce a packet on every frame, such as detections, tensors
+// or image frames, MakePacketFromPool<T>() performs none once the free list
+// of the current thread is warm. Any memory owned by the payload itself
+// (e.g. the buffer of a std::vector) is still allocated by the payload.
+//
+// Usage:
+//   Packet packet =
+//       MakePacketFromPool<std::vector<Detection>>(std::move(detections))
+//           .At(timestamp);
+//
+// The returned Packet behaves like any other Packet. Consume() and
+// ConsumeOrCopy() succeed under the same conditions, but move the payload
+// into a new heap-allocated object, since the payload shares its block with
+// the holder.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PACKET_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_PACKET_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+namespace packet_internal {
+
+// Maximum number of free blocks of each size that a thread keeps. Blocks
+// released beyond this limit are returned to the heap.
+constexpr int kMaxPooledBlocksPerThread = 256;
+
+// A per-thread cache of free blocks of kSize bytes aligned to kAlign.
+//
+// A block is returned to the cache of the thread that releases it, which is
+// not necessarily the thread that allocated it. In a graph, packets are
+// usually released by the executor threads, which also create the next
+// packets, so blocks circulate between the thread caches without taking any
+// lock.
+template <size_t kSize, size_t kAlign>
+class PooledBlockCache {
+ public:
+  static void* Allocate() {
+    FreeList& free_list = free_list_;
+    if (free_list.head != nullptr) {
+      FreeBlock* block = free_list.head;
+      free_list.head = block->next;
+      --free_list.size;
+      return block;
+    }
+    return NewBlock();
+  }
+
+  static void Deallocate(void* ptr) {
+    FreeList& free_list = free_list_;
+    if (free_list.destroyed || free_list.size >= kMaxPooledBlocksPerThread) {
+      DeleteBlock(ptr);
+      return;
+    }
+    // Makes sure the blocks are released when the thread exits.
+    static_cast<void>(reclaimer_);
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    block->next = free_list.head;
+    free_list.head = block;
+    ++free_list.size;
+  }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+  static_assert(kSize >= sizeof(FreeBlock), "Block too small");
+
+  // Trivially destructible, so that it remains usable for blocks released
+  // by other thread_local destructors after reclaimer_ has run.
+  struct FreeList {
+    FreeBlock* head;
+    int size;
+    bool destroyed;
+  };
+
+  struct Reclaimer {
+    ~Reclaimer() {
+      FreeList& free_list = free_list_;
+      while (free_list.head != nullptr) {
+        FreeBlock* block = free_list.head;
+        free_list.head = block->next;
+        DeleteBlock(block);
+      }
+      free_list.size = 0;
+      free_list.destroyed = true;
+    }
+  };
+
+  static void* NewBlock() {
+    if (kAlign > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      return ::operator new(kSize, std::align_val_t(kAlign));
+    }
+    return ::operator new(kSize);
+  }
+
+  static void DeleteBlock(void* ptr) {
+    if (kAlign > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      ::operator delete(ptr, std::align_val_t(kAlign));
+    } else {
+      ::operator delete(ptr);
+    }
+  }
+
+  static thread_local FreeList free_list_;
+  static thread_local Reclaimer reclaimer_;
+};
+
+template <size_t kSize, size_t kAlign>
+thread_local typename PooledBlockCache<kSize, kAlign>::FreeList
+    PooledBlockCache<kSize, kAlign>::free_list_ = {nullptr, 0, false};
+
+template <size_t kSize, size_t kAlign>
+thread_local typename PooledBlockCache<kSize, kAlign>::Reclaimer
+    PooledBlockCache<kSize, kAlign>::reclaimer_;
+
+// Allocator for std::allocate_shared that serves single objects from
+// PooledBlockCache. allocate_shared rebinds it to its internal control block
+// type, so the cache is keyed by the size of the combined block.
+template <typename U>
+class PooledBlockAllocator {
+ public:
+  using value_type = U;
+
+  PooledBlockAllocator() = default;
+  template <typename V>
+  PooledBlockAllocator(const PooledBlockAllocator<V>&) {}  // NOLINT
+
+  U* allocate(size_t n) {
+    if (n != 1) return std::allocator<U>().allocate(n);
+    return static_cast<U*>(PooledBlockCache<sizeof(U), alignof(U)>::Allocate());
+  }
+
+  void deallocate(U* ptr, size_t n) {
+    if (n != 1) {
+      std::allocator<U>().deallocate(ptr, n);
+      return;
+    }
+    PooledBlockCache<sizeof(U), alignof(U)>::Deallocate(ptr);
+  }
+
+  template <typename V>
+  bool operator==(const PooledBlockAllocator<V>&) const {
+    return true;
+  }
+  template <typename V>
+  bool operator!=(const PooledBlockAllocator<V>&) const {
+    return false;
+  }
+};
+
+// A Holder that stores its payload inline instead of owning a separate heap
+// object.
+template <typename T>
+class PooledHolder : public Holder<T> {
+ public:
+  static_assert(!std::is_array<T>::value,
+                "MakePacketFromPool does not support arrays.");
+
+  template <typename... Args>
+  explicit PooledHolder(Args&&... args)
+      : Holder<T>(nullptr), value_(std::forward<Args>(args)...) {
+    this->ptr_ = &value_;
+  }
+  ~PooledHolder() override {
+    // value_ is destroyed as a member; keep ~Holder from deleting it.
+    this->ptr_ = nullptr;
+  }
+
+ protected:
+  T* ReleaseData() override { return new T(std::move(value_)); }
+
+ private:
+  T value_;
+};
+
+}  // namespace packet_internal
+
+// Create a packet containing an object of type T initialized with the
+// provided arguments, like MakePacket<T>(), but taking the memory for the
+// holder and the payload from a per-thread pool. See the top of this file.
+template <typename T, typename... Args>
+Packet MakePacketFromPool(Args&&... args) {  // NOLINT(build/c++11)
+  using Holder = packet_internal::PooledHolder<T>;
+  return packet_internal::Create(
+      std::allocate_shared<Holder>(
+          packet_internal::PooledBlockAllocator<Holder>(),
+          std::forward<Args>(args)...),
+      Timestamp::Unset());
+}
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PACKET_POOL_H_
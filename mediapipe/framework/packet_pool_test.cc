@@ -0,0 +1,177 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_pool.h"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+// Counts the heap allocations made by the test, so that the tests and
+// benchmarks can check how many allocations a packet costs.
+static std::atomic<int64_t> num_allocations{0};
+
+void* operator new(size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace mediapipe {
+namespace {
+
+// Payload without heap-allocated members, like a small matrix or a fixed
+// set of landmarks.
+using FixedPayload = std::array<float, 16>;
+
+class Counted {
+ public:
+  explicit Counted(int* live) : live_(live) { ++*live_; }
+  Counted(Counted&& other) : live_(other.live_) { ++*live_; }
+  ~Counted() { --*live_; }
+
+ private:
+  int* live_;
+};
+
+TEST(PacketPoolTest, HoldsPayload) {
+  Packet packet = MakePacketFromPool<std::vector<int>>(3, 7).At(Timestamp(5));
+  EXPECT_EQ(packet.Timestamp(), Timestamp(5));
+  EXPECT_THAT(packet.Get<std::vector<int>>(), testing::ElementsAre(7, 7, 7));
+  MP_EXPECT_OK(packet.ValidateAsType<std::vector<int>>());
+  Packet copy = packet;
+  EXPECT_EQ(copy, packet);
+}
+
+TEST(PacketPoolTest, DestroysPayloadWithLastPacket) {
+  int live = 0;
+  Packet packet = MakePacketFromPool<Counted>(&live);
+  Packet copy = packet;
+  EXPECT_EQ(live, 1);
+  packet = Packet();
+  EXPECT_EQ(live, 1);
+  copy = Packet();
+  EXPECT_EQ(live, 0);
+}
+
+TEST(PacketPoolTest, Consume) {
+  Packet packet = MakePacketFromPool<std::vector<int>>(3, 7);
+  Packet copy = packet;
+  EXPECT_FALSE(packet.Consume<std::vector<int>>().ok());
+  copy = Packet();
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<std::vector<int>> data,
+                          packet.Consume<std::vector<int>>());
+  EXPECT_THAT(*data, testing::ElementsAre(7, 7, 7));
+  EXPECT_TRUE(packet.IsEmpty());
+}
+
+TEST(PacketPoolTest, ConsumeOrCopy) {
+  Packet packet = MakePacketFromPool<std::vector<int>>(3, 7);
+  bool was_copied = true;
+  MP_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<std::vector<int>> data,
+      packet.ConsumeOrCopy<std::vector<int>>(&was_copied));
+  EXPECT_FALSE(was_copied);
+  EXPECT_THAT(*data, testing::ElementsAre(7, 7, 7));
+  EXPECT_TRUE(packet.IsEmpty());
+}
+
+TEST(PacketPoolTest, ReusesBlocks) {
+  // Warms up the free list of this thread.
+  MakePacketFromPool<FixedPayload>();
+  const int64_t start = num_allocations.load();
+  for (int i = 0; i < 100; ++i) {
+    Packet packet = MakePacketFromPool<FixedPayload>().At(Timestamp(i));
+    Packet copy = packet;
+  }
+  EXPECT_EQ(num_allocations.load() - start, 0);
+}
+
+TEST(PacketPoolTest, ReleaseOnOtherThread) {
+  std::vector<Packet> packets;
+  for (int i = 0; i < 2 * packet_internal::kMaxPooledBlocksPerThread; ++i) {
+    packets.push_back(MakePacketFromPool<FixedPayload>());
+  }
+  std::thread thread([&packets]() {
+    packets.clear();
+    // Blocks released to this thread are reused and then freed on exit.
+    Packet packet = MakePacketFromPool<FixedPayload>();
+  });
+  thread.join();
+  EXPECT_TRUE(packets.empty());
+}
+
+// Simulates a stream that produces one packet per frame, which is sent to
+// two downstream nodes and then released. Reports the number of heap
+// allocations per frame.
+template <typename T, Packet (*Make)()>
+void BM_PacketPerFrame(benchmark::State& state) {
+  int64_t frame = 0;
+  const int64_t start = num_allocations.load();
+  for (auto _ : state) {
+    Packet packet = Make().At(Timestamp(frame++));
+    Packet consumer_1 = packet;
+    Packet consumer_2 = packet;
+    benchmark::DoNotOptimize(consumer_1.Get<T>());
+    benchmark::DoNotOptimize(consumer_2.Get<T>());
+  }
+  state.counters["allocs_per_frame"] = benchmark::Counter(
+      num_allocations.load() - start, benchmark::Counter::kAvgIterations);
+}
+
+template <typename T>
+Packet MakeDefault() {
+  return MakePacket<T>();
+}
+
+template <typename T>
+Packet MakeDefaultFromPool() {
+  return MakePacketFromPool<T>();
+}
+
+Packet MakeDetections() {
+  std::vector<Detection> detections(4);
+  return MakePacket<std::vector<Detection>>(std::move(detections));
+}
+
+Packet MakeDetectionsFromPool() {
+  std::vector<Detection> detections(4);
+  return MakePacketFromPool<std::vector<Detection>>(std::move(detections));
+}
+
+BENCHMARK_TEMPLATE(BM_PacketPerFrame, FixedPayload, MakeDefault<FixedPayload>);
+BENCHMARK_TEMPLATE(BM_PacketPerFrame, FixedPayload,
+                   MakeDefaultFromPool<FixedPayload>);
+BENCHMARK_TEMPLATE(BM_PacketPerFrame, std::vector<Detection>, MakeDetections);
+BENCHMARK_TEMPLATE(BM_PacketPerFrame, std::vector<Detection>,
+                   MakeDetectionsFromPool);
+
+}  // namespace
+}  // namespace mediapipe
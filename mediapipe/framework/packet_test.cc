@@ -20,6 +20,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "mediapipe/framework/packet_test.pb.h"
 #include "mediapipe/framework/port/core_proto_inc.h"
@@ -483,6 +484,55 @@ TEST(PacketTest, TestConsumeOrCopyBoundedArray) {
   EXPECT_TRUE(packet2.IsEmpty());
 }
 
+// A move-only payload which supports ConsumeOrCopy through an overload of
+// CopyPacketPayload, as ImageFrame and Tensor do.
+struct MoveOnlyPayload {
+  explicit MoveOnlyPayload(int value) : value(value) {}
+  MoveOnlyPayload(MoveOnlyPayload&&) = default;
+  MoveOnlyPayload(const MoveOnlyPayload&) = delete;
+  int value;
+};
+
+std::unique_ptr<MoveOnlyPayload> CopyPacketPayload(
+    const MoveOnlyPayload& payload) {
+  return absl::make_unique<MoveOnlyPayload>(payload.value);
+}
+
+TEST(PacketTest, ConsumeOrCopyMoveOnlyPayload) {
+  const PacketConsumeStats stats_before = GetPacketConsumeStats();
+  Packet packet = MakePacket<MoveOnlyPayload>(7);
+  Packet packet_copy = packet;
+  const MoveOnlyPayload* original = &packet.Get<MoveOnlyPayload>();
+
+  // The payload is shared, so it is copied.
+  bool was_copied = false;
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<MoveOnlyPayload> copy,
+                          packet_copy.ConsumeOrCopy<MoveOnlyPayload>(
+                              &was_copied));
+  EXPECT_TRUE(was_copied);
+  EXPECT_NE(copy.get(), original);
+  EXPECT_EQ(copy->value, 7);
+
+  // The payload is no longer shared, so its ownership is transferred.
+  MP_ASSERT_OK_AND_ASSIGN(std::unique_ptr<MoveOnlyPayload> consumed,
+                          packet.ConsumeOrCopy<MoveOnlyPayload>(&was_copied));
+  EXPECT_FALSE(was_copied);
+  EXPECT_EQ(consumed.get(), original);
+
+  const PacketConsumeStats stats = GetPacketConsumeStats();
+  EXPECT_EQ(stats.consumed - stats_before.consumed, 1);
+  EXPECT_EQ(stats.copied - stats_before.copied, 1);
+  EXPECT_EQ(stats.failed - stats_before.failed, 0);
+}
+
+TEST(PacketTest, ConsumeStatsCountFailures) {
+  const PacketConsumeStats stats_before = GetPacketConsumeStats();
+  Packet packet = MakePacket<int>(1);
+  Packet packet_copy = packet;
+  EXPECT_FALSE(packet_copy.Consume<int>().ok());
+  EXPECT_EQ(GetPacketConsumeStats().failed - stats_before.failed, 1);
+}
+
 TEST(PacketTest, MessageHolderRegistration) {
   using testing::Contains;
   Packet packet = MakePacket<mediapipe::SimpleProto>();
@@ -0,0 +1,167 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+namespace {
+using CalculatorTrace = GraphTrace::CalculatorTrace;
+
+// Identifies a packet by stream id and packet timestamp.
+using PacketKey = std::pair<int32, int64>;
+
+// Returns |text| quoted and escaped as a JSON string.
+std::string JsonString(absl::string_view text) {
+  std::string result = "\"";
+  for (char c : text) {
+    switch (c) {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppend(&result, absl::StrFormat("\\u%04x", c));
+        } else {
+          result += c;
+        }
+    }
+  }
+  result += "\"";
+  return result;
+}
+
+// Returns the time of a CalculatorTrace, relative to the trace base_time.
+int64 EventTime(const CalculatorTrace& event) {
+  return event.has_start_time() ? event.start_time() : event.finish_time();
+}
+
+}  // namespace
+
+void AppendChromeTraceEvents(const GraphTrace& trace,
+                             const std::vector<std::string>& calculator_names,
+                             std::string* result) {
+  auto node_name = [&](int node_id) {
+    return (node_id >= 0 && node_id < calculator_names.size())
+               ? JsonString(calculator_names[node_id])
+               : JsonString(absl::StrCat("node_", node_id));
+  };
+  auto stream_name = [&](int stream_id) {
+    return (stream_id >= 0 && stream_id < trace.stream_name_size())
+               ? trace.stream_name(stream_id)
+               : absl::StrCat("stream_", stream_id);
+  };
+
+  // Index the threads and the producer of each output packet.
+  std::set<int32> thread_ids;
+  std::map<PacketKey, const CalculatorTrace*> producers;
+  for (const CalculatorTrace& event : trace.calculator_trace()) {
+    thread_ids.insert(event.thread_id());
+    for (const GraphTrace::StreamTrace& output : event.output_trace()) {
+      producers[{output.stream_id(), output.packet_timestamp()}] = &event;
+    }
+  }
+  for (int32 thread_id : thread_ids) {
+    absl::StrAppend(result, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,",
+                    "\"tid\":", thread_id, ",\"args\":{\"name\":",
+                    JsonString(absl::StrCat("mediapipe_thread_", thread_id)),
+                    "}},\n");
+  }
+
+  // One slice or instant event per calculator run, and one flow arrow per
+  // input packet whose producer is in this trace.
+  std::map<int32, std::vector<std::pair<int64, int>>> queue_changes;
+  for (const CalculatorTrace& event : trace.calculator_trace()) {
+    std::string common = absl::StrCat(
+        "\"name\":", node_name(event.node_id()),
+        ",\"cat\":", JsonString(GraphTrace::EventType_Name(event.event_type())),
+        ",\"pid\":0,\"tid\":", event.thread_id(),
+        ",\"ts\":", trace.base_time() + EventTime(event));
+    std::string args;
+    if (event.has_input_timestamp()) {
+      args = absl::StrCat(",\"args\":{\"input_timestamp\":",
+                          trace.base_timestamp() + event.input_timestamp(),
+                          "}");
+    }
+    if (event.has_start_time() && event.has_finish_time()) {
+      int64 duration =
+          std::max<int64>(0, event.finish_time() - event.start_time());
+      absl::StrAppend(result, "{\"ph\":\"X\",", common, ",\"dur\":", duration,
+                      args, "},\n");
+    } else {
+      absl::StrAppend(result, "{\"ph\":\"i\",\"s\":\"t\",", common, args,
+                      "},\n");
+    }
+
+    for (const GraphTrace::StreamTrace& input : event.input_trace()) {
+      if (input.has_start_time() && input.has_finish_time()) {
+        queue_changes[input.stream_id()].push_back({input.start_time(), 1});
+        queue_changes[input.stream_id()].push_back({input.finish_time(), -1});
+      }
+      auto producer =
+          producers.find({input.stream_id(), input.packet_timestamp()});
+      if (producer == producers.end()) {
+        continue;
+      }
+      std::string flow = absl::StrCat(
+          "\"name\":", JsonString(stream_name(input.stream_id())),
+          ",\"cat\":\"packet\",\"id\":",
+          JsonString(absl::StrCat(
+              stream_name(input.stream_id()), "@",
+              trace.base_timestamp() + input.packet_timestamp(), ">",
+              event.node_id())),
+          ",\"pid\":0");
+      absl::StrAppend(
+          result, "{\"ph\":\"s\",", flow,
+          ",\"tid\":", producer->second->thread_id(),
+          ",\"ts\":", trace.base_time() + EventTime(*producer->second),
+          "},\n");
+      absl::StrAppend(result, "{\"ph\":\"f\",\"bp\":\"e\",", flow,
+                      ",\"tid\":", event.thread_id(),
+                      ",\"ts\":", trace.base_time() + EventTime(event),
+                      "},\n");
+    }
+  }
+
+  // The number of packets queued on each input stream, counting the packets
+  // consumed during this trace.
+  for (auto& entry : queue_changes) {
+    std::vector<std::pair<int64, int>>& changes = entry.second;
+    std::sort(changes.begin(), changes.end());
+    std::string name =
+        JsonString(absl::StrCat("queue_size ", stream_name(entry.first)));
+    int queue_size = 0;
+    for (const auto& change : changes) {
+      queue_size += change.second;
+      absl::StrAppend(result, "{\"ph\":\"C\",\"name\":", name,
+                      ",\"pid\":0,\"ts\":", trace.base_time() + change.first,
+                      ",\"args\":{\"size\":", queue_size, "}},\n");
+    }
+  }
+}
+
+}  // namespace mediapipe
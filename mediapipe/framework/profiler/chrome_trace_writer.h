@@ -0,0 +1,43 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+
+namespace mediapipe {
+
+// Appends the events of a GraphTrace to |result| in the Chrome trace-event
+// JSON format, which is read by chrome://tracing and ui.perfetto.dev.
+//
+// Each calculator run appears on the track of the thread that ran it, each
+// packet hop from an output stream to an input stream appears as a flow arrow,
+// and the number of packets queued on each input stream appears as a counter.
+// |calculator_names| lists the calculator node names indexed by node id.
+//
+// Every event is followed by ",\n", so that the output of successive calls
+// can be appended to a file beginning with "[\n".  The trace-event readers
+// accept such a file without the closing "]", so it can be read while it
+// is still being written.
+void AppendChromeTraceEvents(const GraphTrace& trace,
+                             const std::vector<std::string>& calculator_names,
+                             std::string* result);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_CHROME_TRACE_WRITER_H_
@@ -0,0 +1,112 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+// A source node on thread 1 outputs a packet, which waits 5 usec in the
+// input stream queue of a node on thread 2.
+GraphTrace TwoNodeTrace() {
+  return ParseTextProtoOrDie<GraphTrace>(R"pb(
+    base_time: 1000000
+    base_timestamp: 100
+    stream_name: ""
+    stream_name: "input_video"
+    calculator_trace {
+      node_id: 0
+      input_timestamp: 0
+      event_type: PROCESS
+      start_time: 10
+      finish_time: 20
+      thread_id: 1
+      output_trace { packet_timestamp: 0 stream_id: 1 }
+    }
+    calculator_trace {
+      node_id: 1
+      input_timestamp: 0
+      event_type: PROCESS
+      start_time: 25
+      finish_time: 40
+      thread_id: 2
+      input_trace {
+        start_time: 20
+        finish_time: 25
+        packet_timestamp: 0
+        stream_id: 1
+      }
+    }
+  )pb");
+}
+
+TEST(ChromeTraceWriterTest, CalculatorSlices) {
+  std::string json;
+  AppendChromeTraceEvents(TwoNodeTrace(), {"source", "sink"}, &json);
+  EXPECT_THAT(json,
+              HasSubstr(R"({"ph":"M","name":"thread_name","pid":0,"tid":1,)"
+                        R"("args":{"name":"mediapipe_thread_1"}},)"));
+  EXPECT_THAT(json, HasSubstr(R"({"ph":"X","name":"source","cat":"PROCESS",)"
+                              R"("pid":0,"tid":1,"ts":1000010,"dur":10,)"
+                              R"("args":{"input_timestamp":100}},)"));
+  EXPECT_THAT(json, HasSubstr(R"({"ph":"X","name":"sink","cat":"PROCESS",)"
+                              R"("pid":0,"tid":2,"ts":1000025,"dur":15,)"
+                              R"("args":{"input_timestamp":100}},)"));
+  EXPECT_EQ(json.substr(json.size() - 2), ",\n");
+}
+
+TEST(ChromeTraceWriterTest, PacketFlows) {
+  std::string json;
+  AppendChromeTraceEvents(TwoNodeTrace(), {"source", "sink"}, &json);
+  EXPECT_THAT(json, HasSubstr(R"({"ph":"s","name":"input_video",)"
+                              R"("cat":"packet","id":"input_video@100>1",)"
+                              R"("pid":0,"tid":1,"ts":1000010},)"));
+  EXPECT_THAT(json, HasSubstr(R"({"ph":"f","bp":"e","name":"input_video",)"
+                              R"("cat":"packet","id":"input_video@100>1",)"
+                              R"("pid":0,"tid":2,"ts":1000025},)"));
+}
+
+TEST(ChromeTraceWriterTest, QueueSizeCounters) {
+  std::string json;
+  AppendChromeTraceEvents(TwoNodeTrace(), {"source", "sink"}, &json);
+  EXPECT_THAT(json, HasSubstr(R"({"ph":"C","name":"queue_size input_video",)"
+                              R"("pid":0,"ts":1000020,"args":{"size":1}},)"));
+  EXPECT_THAT(json, HasSubstr(R"({"ph":"C","name":"queue_size input_video",)"
+                              R"("pid":0,"ts":1000025,"args":{"size":0}},)"));
+}
+
+TEST(ChromeTraceWriterTest, EscapesNames) {
+  GraphTrace trace = ParseTextProtoOrDie<GraphTrace>(R"pb(
+    calculator_trace { node_id: 0 event_type: OPEN start_time: 5 thread_id: 0 }
+  )pb");
+  std::string json;
+  AppendChromeTraceEvents(trace, {"a\"b\\c"}, &json);
+  EXPECT_THAT(json, HasSubstr(R"({"ph":"i","s":"t","name":"a\"b\\c",)"
+                              R"("cat":"OPEN","pid":0,"tid":0,"ts":5},)"));
+  EXPECT_THAT(json, Not(HasSubstr(R"("ph":"X")")));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -28,6 +28,7 @@
 #include "mediapipe/framework/port/re2.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/profiler/chrome_trace_writer.h"
 #include "mediapipe/framework/profiler/profiler_resource_util.h"
 #include "mediapipe/framework/tool/name_util.h"
 #include "mediapipe/framework/tool/tag_map.h"
@@ -176,23 +177,39 @@ void GraphProfiler::Initialize(
     profile.set_name(node_name);
     InitializeTimeHistogram(interval_size_usec, num_intervals,
                             profile.mutable_process_runtime());
+    const CalculatorGraphConfig::Node& node_config =
+        validated_graph_config.Config().node(node_id);
     if (profiler_config_.enable_stream_latency()) {
       InitializeTimeHistogram(interval_size_usec, num_intervals,
                               profile.mutable_process_input_latency());
       InitializeTimeHistogram(interval_size_usec, num_intervals,
                               profile.mutable_process_output_latency());
 
-      const CalculatorGraphConfig::Node& node_config =
-          validated_graph_config.Config().node(node_id);
       InitializeOutputStreams(node_config);
+    }
+    if (profiler_config_.enable_stream_latency() ||
+        profiler_config_.enable_scheduler_telemetry()) {
       InitializeInputStreams(node_config, interval_size_usec, num_intervals,
                              &profile);
     }
+    if (profiler_config_.enable_scheduler_telemetry()) {
+      InitializeTimeHistogram(interval_size_usec, num_intervals,
+                              profile.mutable_scheduler_wait_time());
+    }
 
     auto iter = calculator_profiles_.insert({node_name, profile});
     CHECK(iter.second) << absl::Substitute(
         "Calculator \"$0\" has already been added.", node_name);
   }
+  scheduler_telemetry_enabled_ = profiler_config_.enable_scheduler_telemetry();
+  if (scheduler_telemetry_enabled_) {
+    executor_stats_[""] = std::make_unique<ExecutorStats>();
+    for (const auto& executor_config :
+         validated_graph_config.Config().executor()) {
+      executor_stats_[executor_config.name()] =
+          std::make_unique<ExecutorStats>();
+    }
+  }
   profile_builder_ = std::make_unique<GraphProfileBuilder>(this);
   graph_id_ = ++next_instance_id_;
 
@@ -231,17 +248,26 @@ void GraphProfiler::Reset() {
     ResetTimeHistogram(calculator_profile->mutable_process_runtime());
     ResetTimeHistogram(calculator_profile->mutable_process_input_latency());
     ResetTimeHistogram(calculator_profile->mutable_process_output_latency());
+    calculator_profile->set_deadline_misses(0);
+    calculator_profile->set_deadline_drops(0);
+    if (calculator_profile->has_scheduler_wait_time()) {
+      ResetTimeHistogram(calculator_profile->mutable_scheduler_wait_time());
+    }
     for (auto& input_stream_profile :
          *(calculator_profile->mutable_input_stream_profiles())) {
       ResetTimeHistogram(input_stream_profile.mutable_latency());
+      input_stream_profile.clear_max_queue_size();
+      input_stream_profile.clear_queue_size_total();
     }
   }
+  ResetExecutorStats();
 }
 
 // Begins profiling for a single graph run.
 absl::Status GraphProfiler::Start(mediapipe::Executor* executor) {
   // If specified, start periodic profile output while the graph runs.
   Resume();
+  ResetExecutorStats();
   if (is_tracing_ && IsTraceIntervalEnabled(profiler_config_, tracer()) &&
       executor != nullptr) {
     // Inform the user via logging the path to the trace logs.
@@ -341,6 +367,31 @@ absl::Status GraphProfiler::GetCalculatorProfiles(
   return absl::OkStatus();
 }
 
+absl::Status GraphProfiler::GetExecutorProfiles(
+    std::vector<ExecutorProfile>* profiles) {
+  absl::ReaderMutexLock lock(&profiler_mutex_);
+  RET_CHECK(is_initialized_)
+      << "GetExecutorProfiles can only be called after Initialize()";
+  const int64 elapsed_time_usec = TimeNowUsec() - executor_stats_start_usec_;
+  for (const auto& entry : executor_stats_) {
+    ExecutorProfile profile;
+    profile.set_name(entry.first);
+    profile.set_busy_time(entry.second->busy_time_usec);
+    profile.set_num_tasks(entry.second->num_tasks);
+    profile.set_elapsed_time(elapsed_time_usec);
+    profiles->push_back(std::move(profile));
+  }
+  return absl::OkStatus();
+}
+
+void GraphProfiler::ResetExecutorStats() {
+  for (auto& entry : executor_stats_) {
+    entry.second->busy_time_usec = 0;
+    entry.second->num_tasks = 0;
+  }
+  executor_stats_start_usec_ = TimeNowUsec();
+}
+
 void GraphProfiler::InitializeTimeHistogram(int64 interval_size_usec,
                                             int64 num_intervals,
                                             TimeHistogram* histogram) {
@@ -565,6 +616,77 @@ void GraphProfiler::AddProcessSample(
   }
 }
 
+void GraphProfiler::AddDeadlineMiss(const CalculatorContext& calculator_context,
+                                    bool dropped) {
+  absl::ReaderMutexLock lock(&profiler_mutex_);
+  if (!is_profiling_) {
+    return;
+  }
+  auto profile_iter = calculator_profiles_.find(calculator_context.NodeName());
+  CHECK(profile_iter != calculator_profiles_.end()) << absl::Substitute(
+      "Calculator \"$0\" has not been added during initialization.",
+      calculator_context.NodeName());
+  CalculatorProfile* calculator_profile = &profile_iter->second;
+  if (dropped) {
+    calculator_profile->set_deadline_drops(
+        calculator_profile->deadline_drops() + 1);
+  } else {
+    calculator_profile->set_deadline_misses(
+        calculator_profile->deadline_misses() + 1);
+  }
+}
+
+void GraphProfiler::AddSchedulerSample(const std::string& executor_name,
+                                       const std::string& node_name,
+                                       int64 queue_time_usec,
+                                       int64 start_time_usec,
+                                       int64 end_time_usec) {
+  absl::ReaderMutexLock lock(&profiler_mutex_);
+  if (!is_profiling_ || !scheduler_telemetry_enabled_) {
+    return;
+  }
+  auto stats_iter = executor_stats_.find(executor_name);
+  if (stats_iter != executor_stats_.end()) {
+    stats_iter->second->busy_time_usec.fetch_add(
+        end_time_usec - start_time_usec, std::memory_order_relaxed);
+    stats_iter->second->num_tasks.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (node_name.empty()) {
+    return;
+  }
+  auto profile_iter = calculator_profiles_.find(node_name);
+  CHECK(profile_iter != calculator_profiles_.end()) << absl::Substitute(
+      "Calculator \"$0\" has not been added during initialization.",
+      node_name);
+  AddTimeSample(queue_time_usec, start_time_usec,
+                profile_iter->second.mutable_scheduler_wait_time());
+}
+
+void GraphProfiler::AddInputQueueSizes(
+    const CalculatorContext& calculator_context,
+    const std::vector<int>& queue_sizes) {
+  absl::ReaderMutexLock lock(&profiler_mutex_);
+  if (!is_profiling_ || !scheduler_telemetry_enabled_) {
+    return;
+  }
+  auto profile_iter = calculator_profiles_.find(calculator_context.NodeName());
+  CHECK(profile_iter != calculator_profiles_.end()) << absl::Substitute(
+      "Calculator \"$0\" has not been added during initialization.",
+      calculator_context.NodeName());
+  CalculatorProfile* calculator_profile = &profile_iter->second;
+  if (calculator_profile->input_stream_profiles_size() != queue_sizes.size()) {
+    return;
+  }
+  for (int i = 0; i < queue_sizes.size(); ++i) {
+    StreamProfile* stream_profile =
+        calculator_profile->mutable_input_stream_profiles(i);
+    stream_profile->set_max_queue_size(
+        std::max<int64>(stream_profile->max_queue_size(), queue_sizes[i]));
+    stream_profile->set_queue_size_total(stream_profile->queue_size_total() +
+                                         queue_sizes[i]);
+  }
+}
+
 std::unique_ptr<GlProfilingHelper> GraphProfiler::CreateGlProfilingHelper() {
   if (!IsTracerEnabled(profiler_config_)) {
     return nullptr;
@@ -602,6 +724,17 @@ class OstreamStream : public proto_ns::io::ZeroCopyOutputStream {
   OstreamStream& operator=(const OstreamStream&) = delete;
 };
 
+// Returns the canonical names of the calculator nodes, indexed by node id.
+std::vector<std::string> CanonicalNodeNames(
+    const CalculatorGraphConfig& graph_config) {
+  std::vector<std::string> canonical_names;
+  canonical_names.reserve(graph_config.node().size());
+  for (int i = 0; i < graph_config.node().size(); ++i) {
+    canonical_names.push_back(CanonicalNodeName(graph_config, i));
+  }
+  return canonical_names;
+}
+
 // Sets the canonical node name in each CalculatorGraphConfig::Node
 // and also in the GraphTrace if present.
 void AssignNodeNames(GraphProfile* profile) {
@@ -612,11 +745,7 @@ void AssignNodeNames(GraphProfile* profile) {
   if (graph_trace) {
     graph_trace->clear_calculator_name();
   }
-  std::vector<std::string> canonical_names;
-  canonical_names.reserve(graph_config->node().size());
-  for (int i = 0; i < graph_config->node().size(); ++i) {
-    canonical_names.push_back(CanonicalNodeName(*graph_config, i));
-  }
+  std::vector<std::string> canonical_names = CanonicalNodeNames(*graph_config);
   for (int i = 0; i < graph_config->node().size(); ++i) {
     graph_config->mutable_node(i)->set_name(canonical_names[i]);
   }
@@ -642,6 +771,9 @@ void CleanCalculatorProfiles(GraphProfile* profile) {
     CleanTimeHistogram(p.mutable_process_runtime());
     CleanTimeHistogram(p.mutable_process_input_latency());
     CleanTimeHistogram(p.mutable_process_output_latency());
+    if (p.has_scheduler_wait_time()) {
+      CleanTimeHistogram(p.mutable_scheduler_wait_time());
+    }
     for (StreamProfile& s : *p.mutable_input_stream_profiles()) {
       CleanTimeHistogram(s.mutable_latency());
     }
@@ -690,6 +822,11 @@ absl::Status GraphProfiler::CaptureProfile(
       *result->mutable_calculator_profiles()->Add() = std::move(p);
     }
   }
+  std::vector<ExecutorProfile> executor_profiles;
+  status.Update(GetExecutorProfiles(&executor_profiles));
+  for (ExecutorProfile& p : executor_profiles) {
+    *result->add_executor_profiles() = std::move(p);
+  }
   this->Reset();
   CleanCalculatorProfiles(result);
   if (populate_config == PopulateGraphConfig::kFull) {
@@ -725,14 +862,26 @@ absl::Status GraphProfiler::WriteProfile() {
   }
 
   // Write the GraphProfile to the trace_log_path.
+  bool is_chrome_trace = profiler_config_.trace_log_format() ==
+                         ProfilerConfig::CHROME_TRACE_JSON;
   int log_index = previous_log_index_ / log_interval_count % log_file_count;
-  std::string log_path = absl::StrCat(trace_log_path, log_index, ".binarypb");
+  std::string log_path = absl::StrCat(trace_log_path, log_index,
+                                      is_chrome_trace ? ".json" : ".binarypb");
   std::ofstream ofs;
   if (is_new_file) {
     ofs.open(log_path, std::ofstream::out | std::ofstream::trunc);
   } else {
     ofs.open(log_path, std::ofstream::out | std::ofstream::app);
   }
+  if (is_chrome_trace) {
+    std::string events = is_new_file ? "[\n" : "";
+    AppendChromeTraceEvents(trace,
+                            CanonicalNodeNames(validated_graph_->Config()),
+                            &events);
+    ofs << events;
+    RET_CHECK(ofs.good()) << "Could not write Chrome trace to: " << log_path;
+    return absl::OkStatus();
+  }
   OstreamStream out(&ofs);
   RET_CHECK(profile.SerializeToZeroCopyStream(&out))
       << "Could not write binary GraphProfile to: " << log_path;
@@ -17,6 +17,7 @@
 
 #include <atomic>
 #include <cstddef>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -140,12 +141,48 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Record a tracing event.
   void LogEvent(const TraceEvent& event);
 
+  // Counts an input set of the calculator that missed its deadline. If
+  // "dropped" is true, Process() was not called for it.
+  void AddDeadlineMiss(const CalculatorContext& calculator_context,
+                       bool dropped) ABSL_LOCKS_EXCLUDED(profiler_mutex_);
+
+  // Returns true while scheduler telemetry is recorded. See
+  // ProfilerConfig.enable_scheduler_telemetry.
+  bool IsRecordingSchedulerTelemetry() const {
+    return is_profiling_ && scheduler_telemetry_enabled_;
+  }
+
+  // Returns true if the profiler config enables scheduler telemetry, even
+  // while the profiler is paused.
+  bool IsSchedulerTelemetryEnabled() const {
+    return scheduler_telemetry_enabled_;
+  }
+
+  // Records a task of the executor "executor_name" that entered the ready
+  // queue at "queue_time_usec" and ran from "start_time_usec" to
+  // "end_time_usec". "node_name" is empty for tasks that run Open().
+  void AddSchedulerSample(const std::string& executor_name,
+                          const std::string& node_name, int64 queue_time_usec,
+                          int64 start_time_usec, int64 end_time_usec)
+      ABSL_LOCKS_EXCLUDED(profiler_mutex_);
+
+  // Records the largest queue size of each input stream of the calculator
+  // since its previous Process() call, in input stream order.
+  void AddInputQueueSizes(const CalculatorContext& calculator_context,
+                          const std::vector<int>& queue_sizes)
+      ABSL_LOCKS_EXCLUDED(profiler_mutex_);
+
   // Collects the runtime profile for Open(), Process(), and Close() of each
   // calculator in the graph. May be called at any time after the graph has been
   // initialized.
   absl::Status GetCalculatorProfiles(std::vector<CalculatorProfile>*) const
       ABSL_LOCKS_EXCLUDED(profiler_mutex_);
 
+  // Collects the task profile of each executor in the graph. Empty unless
+  // scheduler telemetry is enabled.
+  absl::Status GetExecutorProfiles(std::vector<ExecutorProfile>*)
+      ABSL_LOCKS_EXCLUDED(profiler_mutex_);
+
   // Records recent profiling and tracing data.  Includes events since the
   // previous call to CaptureProfile.
   //
@@ -240,7 +277,16 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Gets a numerical identifier for this GraphProfiler object.
   uint64_t GetGraphId() { return graph_id_; }
 
+  // Helper method to get the clock time in microsecond.
+  int64 TimeNowUsec() { return ToUnixMicros(clock_->TimeNow()); }
+
  private:
+  // Task counters of an executor, updated concurrently by its threads.
+  struct ExecutorStats {
+    std::atomic<int64> busy_time_usec{0};
+    std::atomic<int64> num_tasks{0};
+  };
+
   // This can be used to add packet info for the input streams to the graph.
   // It treats the stream defined by |stream_name| as a stream produced by a
   // source calculator and thus uses |timestamp_usec| for the packet production
@@ -310,8 +356,8 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // trace_log_path.
   absl::StatusOr<std::string> GetTraceLogPath();
 
-  // Helper method to get the clock time in microsecond.
-  int64 TimeNowUsec() { return ToUnixMicros(clock_->TimeNow()); }
+  // Resets the executor task counters and starts a new profiling interval.
+  void ResetExecutorStats();
 
  private:
   // The settings for this tracer.
@@ -327,6 +373,15 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // If true, the tracer records timing events.
   std::atomic_bool is_tracing_;
 
+  // If true, ProfilerConfig.enable_scheduler_telemetry is set.
+  bool scheduler_telemetry_enabled_ = false;
+
+  // The task counters of each executor, keyed by executor name. The keys are
+  // fixed by Initialize().
+  std::map<std::string, std::unique_ptr<ExecutorStats>> executor_stats_;
+  // The start of the current executor profiling interval.
+  std::atomic<int64> executor_stats_start_usec_{0};
+
   // Stores all the calculator profiles with the calculator name as the key.
   using CalculatorProfileMap = ShardedMap<std::string, CalculatorProfile>;
   CalculatorProfileMap calculator_profiles_;
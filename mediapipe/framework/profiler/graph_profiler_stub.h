@@ -20,15 +20,18 @@
 
 namespace mediapipe {
 class CalculatorProfile;
+class ExecutorProfile;
 class GraphTrace;
 class GraphProfile;
 }  // namespace mediapipe
 
 namespace mediapipe {
 using mediapipe::CalculatorProfile;
+using mediapipe::ExecutorProfile;
 using mediapipe::GraphProfile;
 using mediapipe::GraphTrace;
 
+class CalculatorContext;
 class ValidatedGraphConfig;
 class Executor;
 class Packet;
@@ -84,10 +87,23 @@ class GraphProfilerStub {
   inline void Initialize(const ValidatedGraphConfig& validated_graph_config) {}
   inline void SetClock(const std::shared_ptr<mediapipe::Clock>& clock) {}
   inline void LogEvent(const TraceEvent& event) {}
+  inline void AddDeadlineMiss(const CalculatorContext& calculator_context,
+                              bool dropped) {}
+  inline bool IsRecordingSchedulerTelemetry() const { return false; }
+  inline bool IsSchedulerTelemetryEnabled() const { return false; }
+  inline void AddSchedulerSample(const std::string& executor_name,
+                                 const std::string& node_name,
+                                 int64 queue_time_usec, int64 start_time_usec,
+                                 int64 end_time_usec) {}
+  inline void AddInputQueueSizes(const CalculatorContext& calculator_context,
+                                 const std::vector<int>& queue_sizes) {}
   inline absl::Status GetCalculatorProfiles(
       std::vector<CalculatorProfile>*) const {
     return absl::OkStatus();
   }
+  inline absl::Status GetExecutorProfiles(std::vector<ExecutorProfile>*) {
+    return absl::OkStatus();
+  }
   absl::Status CaptureProfile(
       GraphProfile* result,
       PopulateGraphConfig populate_config = PopulateGraphConfig::kNo) {
@@ -106,6 +122,7 @@ class GraphProfilerStub {
     return nullptr;
   }
   const std::shared_ptr<mediapipe::Clock> GetClock() const { return nullptr; }
+  inline int64 TimeNowUsec() { return 0; }
 };
 
 // The API class used to access the preferred profiler, such as
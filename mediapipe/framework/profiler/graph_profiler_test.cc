@@ -1232,6 +1232,63 @@ TEST(GraphProfilerTest, ParallelReads) {
   EXPECT_EQ(1001, out_1_packets.size());
 }
 
+TEST(GraphProfilerTest, SchedulerTelemetry) {
+  CalculatorGraphConfig config;
+  QCHECK(google::protobuf::TextFormat::ParseFromString(R"(
+    profiler_config {
+     enable_profiler: true
+     enable_scheduler_telemetry: true
+    }
+    node {
+      calculator: "RangeCalculator"
+      input_side_packet: "range_step"
+      output_stream: "out"
+      output_stream: "sum"
+      output_stream: "mean"
+    }
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "out"
+      input_stream: "sum"
+      input_stream: "mean"
+      output_stream: "out_1"
+      output_stream: "sum_1"
+      output_stream: "mean_1"
+    }
+    )",
+                                                       &config));
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun(
+      {{"range_step", MakePacket<std::pair<uint32, uint32>>(100, 1)}}));
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  std::vector<CalculatorProfile> profiles;
+  MP_ASSERT_OK(graph.profiler()->GetCalculatorProfiles(&profiles));
+  ASSERT_EQ(2, profiles.size());
+  for (const CalculatorProfile& profile : profiles) {
+    ASSERT_TRUE(profile.has_scheduler_wait_time()) << profile.name();
+    int64 num_waits = 0;
+    for (int64 count : profile.scheduler_wait_time().count()) {
+      num_waits += count;
+    }
+    EXPECT_GT(num_waits, 0) << profile.name();
+    if (profile.name() == "PassThroughCalculator") {
+      ASSERT_EQ(3, profile.input_stream_profiles_size());
+      EXPECT_GE(profile.input_stream_profiles(0).max_queue_size(), 1);
+      EXPECT_GT(profile.input_stream_profiles(0).queue_size_total(), 0);
+    }
+  }
+
+  std::vector<ExecutorProfile> executor_profiles;
+  MP_ASSERT_OK(graph.profiler()->GetExecutorProfiles(&executor_profiles));
+  ASSERT_EQ(1, executor_profiles.size());
+  EXPECT_EQ("", executor_profiles[0].name());
+  EXPECT_GT(executor_profiles[0].num_tasks(), 100);
+  EXPECT_GE(executor_profiles[0].busy_time(), 0);
+  EXPECT_GE(executor_profiles[0].elapsed_time(), 0);
+}
+
 // Returns the set of calculator names in a GraphProfile captured from
 // CalculatorGraph initialized from a certain CalculatorGraphConfig.
 std::set<std::string> GetCalculatorNames(const CalculatorGraphConfig& config) {
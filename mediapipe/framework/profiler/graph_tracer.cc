@@ -14,6 +14,10 @@
 
 #include "mediapipe/framework/profiler/graph_tracer.h"
 
+#include <algorithm>
+#include <atomic>
+
+#include "absl/memory/memory.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "mediapipe/framework/calculator_context.h"
@@ -32,11 +36,31 @@ const absl::Duration kDefaultTraceLogInterval = absl::Milliseconds(500);
 
 // Returns a unique identifier for the current thread.
 inline int GetCurrentThreadId() {
-  static int next_thread_id = 0;
+  static std::atomic<int> next_thread_id(0);
   static thread_local int thread_id = next_thread_id++;
   return thread_id;
 }
 
+// Returns a unique identifier for a new GraphTracer.
+int64 NewTracerId() {
+  static std::atomic<int64> next_tracer_id(0);
+  return next_tracer_id++;
+}
+
+// The TraceBuffer most recently used by the current thread, and the id of
+// the tracer that owns it. Tracer ids are never reused, so the buffer of a
+// destroyed tracer is never returned. A thread logging for a single graph
+// needs no lock.
+struct ThreadTraceBufferCache {
+  int64 tracer_id = -1;
+  TraceBuffer* buffer = nullptr;
+};
+
+ThreadTraceBufferCache& GetThreadTraceBufferCache() {
+  static thread_local ThreadTraceBufferCache cache;
+  return cache;
+}
+
 }  // namespace
 
 absl::Duration GraphTracer::GetTraceLogInterval() {
@@ -52,7 +76,9 @@ int64 GraphTracer::GetTraceLogCapacity() {
 }
 
 GraphTracer::GraphTracer(const ProfilerConfig& profiler_config)
-    : profiler_config_(profiler_config), trace_buffer_(GetTraceLogCapacity()) {
+    : profiler_config_(profiler_config),
+      trace_buffer_(GetTraceLogCapacity()),
+      tracer_id_(NewTracerId()) {
   for (int disabled : profiler_config_.trace_event_types_disabled()) {
     EventType event_type = static_cast<EventType>(disabled);
     (*trace_event_registry())[event_type].set_enabled(false);
@@ -68,7 +94,57 @@ void GraphTracer::LogEvent(TraceEvent event) {
     return;
   }
   event.set_thread_id(GetCurrentThreadId());
-  trace_buffer_.push_back(event);
+  if (profiler_config_.trace_per_thread_buffers()) {
+    GetThreadTraceBuffer()->push_back(event);
+  } else {
+    trace_buffer_.push_back(event);
+  }
+}
+
+TraceBuffer* GraphTracer::GetThreadTraceBuffer() {
+  ThreadTraceBufferCache& cache = GetThreadTraceBufferCache();
+  if (cache.tracer_id != tracer_id_) {
+    absl::MutexLock lock(&thread_buffers_mutex_);
+    std::unique_ptr<ThreadTraceBuffer>& thread_buffer =
+        thread_buffers_[GetCurrentThreadId()];
+    if (thread_buffer == nullptr) {
+      thread_buffer =
+          absl::make_unique<ThreadTraceBuffer>(GetTraceLogCapacity());
+    }
+    cache.tracer_id = tracer_id_;
+    cache.buffer = &thread_buffer->buffer;
+  }
+  return cache.buffer;
+}
+
+void GraphTracer::MergeThreadTraceBuffers() {
+  if (!profiler_config_.trace_per_thread_buffers()) {
+    return;
+  }
+  std::vector<TraceEvent> events;
+  {
+    absl::MutexLock lock(&thread_buffers_mutex_);
+    for (auto& entry : thread_buffers_) {
+      ThreadTraceBuffer* thread_buffer = entry.second.get();
+      const TraceBuffer& buffer = thread_buffer->buffer;
+      TraceBuffer::iterator buffer_end = buffer.end();
+      TraceBuffer::iterator iter(&buffer, thread_buffer->merged);
+      if (iter < buffer.begin()) {
+        iter = buffer.begin();
+      }
+      for (; iter < buffer_end; ++iter) {
+        events.push_back(*iter);
+      }
+      thread_buffer->merged = buffer_end - TraceBuffer::iterator(&buffer, 0);
+    }
+  }
+  std::stable_sort(events.begin(), events.end(),
+                   [](const TraceEvent& a, const TraceEvent& b) {
+                     return a.event_time < b.event_time;
+                   });
+  for (const TraceEvent& event : events) {
+    trace_buffer_.push_back(event);
+  }
 }
 
 void GraphTracer::LogInputEvents(GraphTrace::EventType event_type,
@@ -114,6 +190,7 @@ void GraphTracer::LogOutputEvents(GraphTrace::EventType event_type,
 }
 
 Timestamp GraphTracer::TimestampAfter(absl::Time begin_time) {
+  MergeThreadTraceBuffers();
   return TraceBuilder::TimestampAfter(trace_buffer_, begin_time);
 }
 
@@ -125,6 +202,7 @@ absl::Mutex* trace_builder_mutex() {
 
 void GraphTracer::GetTrace(absl::Time begin_time, absl::Time end_time,
                            GraphTrace* result) {
+  MergeThreadTraceBuffers();
   absl::MutexLock lock(trace_builder_mutex());
   trace_builder_.CreateTrace(trace_buffer_, begin_time, end_time, result);
   trace_builder_.Clear();
@@ -132,12 +210,16 @@ void GraphTracer::GetTrace(absl::Time begin_time, absl::Time end_time,
 
 void GraphTracer::GetLog(absl::Time begin_time, absl::Time end_time,
                          GraphTrace* result) {
+  MergeThreadTraceBuffers();
   absl::MutexLock lock(trace_builder_mutex());
   trace_builder_.CreateLog(trace_buffer_, begin_time, end_time, result);
   trace_builder_.Clear();
 }
 
-const TraceBuffer& GraphTracer::GetTraceBuffer() { return trace_buffer_; }
+const TraceBuffer& GraphTracer::GetTraceBuffer() {
+  MergeThreadTraceBuffers();
+  return trace_buffer_;
+}
 
 Timestamp GraphTracer::GetOutputTimestamp(const CalculatorContext* context) {
   for (const OutputStreamShard& out_stream : context->Outputs()) {
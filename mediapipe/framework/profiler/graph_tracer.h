@@ -15,7 +15,13 @@
 #ifndef MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_TRACER_H_
 #define MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_TRACER_H_
 
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
 
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_context.h"
@@ -44,6 +50,10 @@ namespace mediapipe {
 //
 //   end_time = current_time - max_packet_latency
 //
+// If ProfilerConfig::trace_per_thread_buffers is set, each logging thread
+// appends to its own TraceBuffer, and those buffers are merged into the
+// shared TraceBuffer only by the methods that read trace events.
+//
 class GraphTracer {
  public:
   // Returns the interval between trace log output.
@@ -82,6 +92,19 @@ class GraphTracer {
   const TraceBuffer& GetTraceBuffer();
 
  private:
+  // The TraceEvents logged by one thread, and the number already merged.
+  struct ThreadTraceBuffer {
+    explicit ThreadTraceBuffer(size_t capacity) : buffer(capacity) {}
+    TraceBuffer buffer;
+    size_t merged = 0;
+  };
+
+  // Returns the TraceBuffer owned by the current thread.
+  TraceBuffer* GetThreadTraceBuffer();
+
+  // Moves newly logged per-thread TraceEvents into trace_buffer_.
+  void MergeThreadTraceBuffers();
+
   // Returns the timestamp of the first output packet.
   Timestamp GetOutputTimestamp(const CalculatorContext* context);
 
@@ -91,6 +114,14 @@ class GraphTracer {
   // The circular buffer of TraceEvents.
   TraceBuffer trace_buffer_;
 
+  // Identifies this tracer in the thread-local buffer caches.
+  const int64 tracer_id_;
+
+  // The per-thread circular buffers of TraceEvents, by thread id.
+  absl::Mutex thread_buffers_mutex_;
+  std::map<int, std::unique_ptr<ThreadTraceBuffer>> thread_buffers_
+      ABSL_GUARDED_BY(thread_buffers_mutex_);
+
   // The builder for the GraphTrace protobuf.
   TraceBuilder trace_builder_;
 };
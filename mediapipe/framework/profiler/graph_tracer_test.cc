@@ -18,6 +18,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
@@ -28,6 +29,7 @@
 #include "mediapipe/framework/calculator_profile.pb.h"
 #include "mediapipe/framework/deps/clock.h"
 #include "mediapipe/framework/port/advanced_proto_inc.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/file_helpers.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -328,6 +330,115 @@ TEST_F(GraphTracerTest, GraphTrace) {
   EXPECT_EQ(4, trace.calculator_trace().size());
 }
 
+// Shows that events logged into per-thread buffers are merged in event_time
+// order when the trace is read, and are merged only once.
+TEST_F(GraphTracerTest, PerThreadBuffers) {
+  ProfilerConfig profiler_config;
+  profiler_config.set_trace_enabled(true);
+  profiler_config.set_trace_per_thread_buffers(true);
+  tracer_ = absl::make_unique<GraphTracer>(profiler_config);
+
+  // Each thread logs every kNumThreads-th microsecond.
+  constexpr int kNumThreads = 4;
+  constexpr int kNumEvents = 100;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([this, t] {
+      for (int i = 0; i < kNumEvents; ++i) {
+        tracer_->LogEvent(
+            TraceEvent(GraphTrace::PROCESS)
+                .set_event_time(start_time_ +
+                                absl::Microseconds(i * kNumThreads + t))
+                .set_node_id(t));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  const TraceBuffer& buffer = tracer_->GetTraceBuffer();
+  ASSERT_EQ(kNumThreads * kNumEvents, buffer.end() - buffer.begin());
+  for (int i = 0; i < kNumThreads * kNumEvents; ++i) {
+    TraceEvent event = buffer.Get(i);
+    EXPECT_EQ(start_time_ + absl::Microseconds(i), event.event_time);
+    EXPECT_EQ(i % kNumThreads, event.node_id);
+  }
+
+  tracer_->LogEvent(TraceEvent(GraphTrace::PROCESS)
+                        .set_event_time(start_time_ + absl::Seconds(1)));
+  EXPECT_EQ(kNumThreads * kNumEvents + 1,
+            tracer_->GetTraceBuffer().end() - buffer.begin());
+}
+
+// A thread that alternates between tracers logs each event to the tracer it
+// was logged with, including after another tracer is destroyed.
+TEST_F(GraphTracerTest, PerThreadBuffersWithSeveralTracers) {
+  ProfilerConfig profiler_config;
+  profiler_config.set_trace_enabled(true);
+  profiler_config.set_trace_per_thread_buffers(true);
+  auto tracer_a = absl::make_unique<GraphTracer>(profiler_config);
+  auto tracer_b = absl::make_unique<GraphTracer>(profiler_config);
+  constexpr int kNumEvents = 10;
+  for (int i = 0; i < kNumEvents; ++i) {
+    const absl::Time event_time = start_time_ + absl::Microseconds(i);
+    tracer_a->LogEvent(TraceEvent(GraphTrace::PROCESS)
+                           .set_event_time(event_time)
+                           .set_node_id(1));
+    tracer_b->LogEvent(TraceEvent(GraphTrace::PROCESS)
+                           .set_event_time(event_time)
+                           .set_node_id(2));
+  }
+  tracer_b.reset();
+  auto tracer_c = absl::make_unique<GraphTracer>(profiler_config);
+  tracer_c->LogEvent(TraceEvent(GraphTrace::PROCESS)
+                         .set_event_time(start_time_)
+                         .set_node_id(3));
+  tracer_a->LogEvent(TraceEvent(GraphTrace::PROCESS)
+                         .set_event_time(start_time_ +
+                                         absl::Microseconds(kNumEvents))
+                         .set_node_id(1));
+
+  const TraceBuffer& buffer_a = tracer_a->GetTraceBuffer();
+  ASSERT_EQ(kNumEvents + 1, buffer_a.end() - buffer_a.begin());
+  for (int i = 0; i < kNumEvents + 1; ++i) {
+    EXPECT_EQ(1, buffer_a.Get(i).node_id);
+  }
+  const TraceBuffer& buffer_c = tracer_c->GetTraceBuffer();
+  ASSERT_EQ(1, buffer_c.end() - buffer_c.begin());
+  EXPECT_EQ(3, buffer_c.Get(0).node_id);
+}
+
+// Each benchmark thread logs one TraceEvent per iteration, into either the
+// shared TraceBuffer or its own per-thread TraceBuffer.
+void BM_LogEvent(benchmark::State& state) {
+  static GraphTracer* tracer = nullptr;
+  if (state.thread_index() == 0) {
+    ProfilerConfig profiler_config;
+    profiler_config.set_trace_enabled(true);
+    profiler_config.set_trace_per_thread_buffers(state.range(0));
+    tracer = new GraphTracer(profiler_config);
+  }
+  std::string stream_id = "input";
+  absl::Time event_time = absl::Now();
+  int64 i = 0;
+  for (auto _ : state) {
+    tracer->LogEvent(TraceEvent(GraphTrace::PROCESS)
+                         .set_event_time(event_time)
+                         .set_input_ts(Timestamp(i))
+                         .set_node_id(state.thread_index())
+                         .set_stream_id(&stream_id));
+    ++i;
+  }
+  if (state.thread_index() == 0) {
+    delete tracer;
+    tracer = nullptr;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_LogEvent)->Arg(0)->Arg(1)->ThreadRange(1, 16)->UseRealTime();
+
 // Tests showing GraphTracer logging packet latencies.
 class GraphTracerE2ETest : public ::testing::Test {
  protected:
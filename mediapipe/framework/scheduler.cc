@@ -39,6 +39,7 @@ Scheduler::Scheduler(CalculatorGraph* graph)
     : graph_(graph), shared_(), default_queue_(&shared_) {
   shared_.error_callback =
       std::bind(&CalculatorGraph::RecordError, graph_, std::placeholders::_1);
+  shared_.profiler = graph_->profiler();
   default_queue_.SetIdleCallback(std::bind(&Scheduler::QueueIdleStateChanged,
                                            this, std::placeholders::_1));
   scheduler_queues_.push_back(&default_queue_);
@@ -72,6 +73,7 @@ void Scheduler::Reset() {
   }
   shared_.stopping = false;
   shared_.has_error = false;
+  shared_.deadlines.Reset();
 }
 
 void Scheduler::CloseAllSourceNodes() { shared_.stopping = true; }
@@ -89,7 +91,7 @@ absl::Status Scheduler::SetNonDefaultExecutor(const std::string& name,
                                              "be called after the scheduler "
                                              "has started";
   auto inserted = non_default_queues_.emplace(
-      name, absl::make_unique<SchedulerQueue>(&shared_));
+      name, absl::make_unique<SchedulerQueue>(&shared_, name));
   RET_CHECK(inserted.second)
       << "SetNonDefaultExecutor must be called only once for the executor \""
       << name << "\"";
@@ -450,7 +452,9 @@ void Scheduler::AssignNodeToSchedulerQueue(CalculatorNode* node) {
   } else {
     queue = &default_queue_;
   }
+  queue->RegisterNode(node);
   node->SetSchedulerQueue(queue);
+  node->SetDeadlineTracker(&shared_.deadlines);
 }
 
 void Scheduler::QueueIdleStateChanged(bool idle) {
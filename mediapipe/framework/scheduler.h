@@ -26,7 +26,9 @@
 
 #include "absl/base/macros.h"
 #include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_node.h"
+#include "mediapipe/framework/deadline_tracker.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/scheduler_queue.h"
@@ -59,6 +61,15 @@ class Scheduler {
   absl::Status SetNonDefaultExecutor(const std::string& name,
                                      Executor* executor);
 
+  // Configures the deadlines of the input sets of the graph. Must be called
+  // before the nodes are assigned to scheduler queues.
+  absl::Status SetDeadlineConfig(const DeadlineConfig& config) {
+    return shared_.deadlines.Configure(config);
+  }
+
+  // Returns the deadlines of the input sets of the graph.
+  DeadlineTracker* deadlines() { return &shared_.deadlines; }
+
   // Resets the data members at the beginning of each graph run.
   void Reset();
 
@@ -15,12 +15,12 @@
 #include "mediapipe/framework/scheduler_queue.h"
 
 #include <memory>
-#include <queue>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 
-#include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator_node.h"
 #include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/mediapipe_profiling.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/status.h"
@@ -34,6 +34,19 @@
 namespace mediapipe {
 namespace internal {
 
+namespace {
+
+// The scheduler queue whose task is running on this thread, if any.
+thread_local const SchedulerQueue* current_queue = nullptr;
+
+// The number of inline node runs nested on this thread.
+thread_local int inline_depth = 0;
+
+// The fused unit of the node running on this thread, or -1.
+thread_local int current_unit = -1;
+
+}  // namespace
+
 SchedulerQueue::Item::Item(CalculatorNode* node, CalculatorContext* cc)
     : node_(node), cc_(cc) {
   CHECK(node);
@@ -67,6 +80,10 @@ bool SchedulerQueue::Item::operator<(const SchedulerQueue::Item& that) const {
     // If both are OpenNode(), higher ids run after lower ids.
     return id_ > that.id_;
   }
+  if (deadline_ != that.deadline_) {
+    // Later deadlines run after earlier deadlines.
+    return deadline_ > that.deadline_;
+  }
   if (is_source_) {
     // Sources run after non-sources.
     if (!that.is_source_) return true;
@@ -88,17 +105,16 @@ bool SchedulerQueue::Item::operator<(const SchedulerQueue::Item& that) const {
 
 void SchedulerQueue::Reset() {
   absl::MutexLock lock(&mutex_);
-  num_pending_tasks_ = 0;
+  num_active_items_ = 0;
   num_tasks_to_add_ = 0;
   running_count_ = 0;
 }
 
 void SchedulerQueue::SetExecutor(Executor* executor) { executor_ = executor; }
 
-bool SchedulerQueue::IsIdle() {
-  VLOG(3) << "Scheduler queue empty: " << queue_.empty()
-          << ", # of pending tasks: " << num_pending_tasks_;
-  return queue_.empty() && num_pending_tasks_ == 0;
+void SchedulerQueue::RegisterNode(const CalculatorNode* node) {
+  queue_.SetEarliestDeadlineFirst(shared_->deadlines.earliest_deadline_first());
+  queue_.Reserve(node->Id() + 1);
 }
 
 void SchedulerQueue::SetRunning(bool running) {
@@ -120,7 +136,40 @@ void SchedulerQueue::AddNode(CalculatorNode* node, CalculatorContext* cc) {
     CHECK(node->IsSource()) << node->DebugName();
     return;
   }
-  AddItemToQueue(Item(node, cc));
+  if (CanRunInline(node)) {
+    // The calling task keeps the queue active, so the idle state does not
+    // change while the node runs.
+    VLOG(4) << node->DebugName() << " is running inline.";
+    if (shared_->profiler &&
+        shared_->profiler->IsRecordingSchedulerTelemetry()) {
+      // The run has no queue wait, and its run time is already part of the
+      // busy time of the enclosing task.
+      const int64 time_usec = shared_->profiler->TimeNowUsec();
+      shared_->profiler->AddSchedulerSample(executor_name_, cc->NodeName(),
+                                            time_usec, time_usec, time_usec);
+    }
+    const int outer_unit = current_unit;
+    current_unit = node->FusedUnitHead();
+    // Fused units are acyclic, so nesting within a unit is bounded by its
+    // size. Only entering another unit counts towards the nesting limit.
+    const int depth_increment = current_unit == outer_unit ? 0 : 1;
+    inline_depth += depth_increment;
+    RunCalculatorNode(node, cc);
+    inline_depth -= depth_increment;
+    current_unit = outer_unit;
+    return;
+  }
+  Item item(node, cc);
+  if (!item.IsSource() && shared_->deadlines.earliest_deadline_first()) {
+    item.SetDeadline(shared_->deadlines.Deadline(cc->InputTimestamp()));
+  }
+  AddItemToQueue(std::move(item));
+}
+
+bool SchedulerQueue::CanRunInline(const CalculatorNode* node) const {
+  return node->RunsInline() && current_queue == this &&
+         (node->FusedUnitHead() == current_unit ||
+          inline_depth < kMaxInlineDepth);
 }
 
 void SchedulerQueue::AddNodeForOpen(CalculatorNode* node) {
@@ -132,17 +181,26 @@ void SchedulerQueue::AddNodeForOpen(CalculatorNode* node) {
 
 void SchedulerQueue::AddItemToQueue(Item&& item) {
   const CalculatorNode* node = item.Node();
+  if (shared_->profiler &&
+      shared_->profiler->IsRecordingSchedulerTelemetry()) {
+    item.SetQueueTimeUsec(shared_->profiler->TimeNowUsec());
+  }
   bool was_idle;
+  {
+    // The item is active before it can be popped, so the queue cannot be
+    // seen as idle while the item waits in it.
+    absl::MutexLock lock(&mutex_);
+    was_idle = num_active_items_++ == 0;
+  }
+  queue_.Push(std::move(item));
+  VLOG(4) << node->DebugName() << " was added to the scheduler queue.";
   int tasks_to_add = 0;
   {
     absl::MutexLock lock(&mutex_);
-    was_idle = IsIdle();
-    queue_.push(item);
     ++num_tasks_to_add_;
-    VLOG(4) << node->DebugName() << " was added to the scheduler queue.";
-
     // Now grab the tasks to execute while still holding the lock. This will
-    // gather any waiting tasks, in addition to the one we just added.
+    // gather any waiting tasks, in addition to the one we just added, so no
+    // other thread can submit our task before the callback below.
     if (running_count_ > 0) {
       tasks_to_add = GetTasksToSubmitToExecutor();
     }
@@ -162,9 +220,8 @@ void SchedulerQueue::AddItemToQueue(Item&& item) {
 }
 
 int SchedulerQueue::GetTasksToSubmitToExecutor() {
-  int tasks_to_add = num_tasks_to_add_;
+  const int tasks_to_add = num_tasks_to_add_;
   num_tasks_to_add_ = 0;
-  num_pending_tasks_ += tasks_to_add;
   return tasks_to_add;
 }
 
@@ -186,29 +243,39 @@ void SchedulerQueue::SubmitWaitingTasksToExecutor() {
 }
 
 void SchedulerQueue::RunNextTask() {
-  CalculatorNode* node;
-  CalculatorContext* calculator_context;
-  bool is_open_node;
-  {
-    absl::MutexLock lock(&mutex_);
-
-    CHECK(!queue_.empty()) << "Called RunNextTask when the queue is empty. "
-                              "This should not happen.";
-
-    node = queue_.top().Node();
-    calculator_context = queue_.top().Context();
-    is_open_node = queue_.top().IsOpenNode();
-    queue_.pop();
-
-    CHECK(!node->Closed())
-        << "Scheduled a node that was closed. This should not happen.";
+  CHECK(!queue_.Empty()) << "Called RunNextTask when the queue is empty. "
+                            "This should not happen.";
+  // Every task corresponds to an item that was pushed before the task was
+  // submitted, so an item is available. Pop may still miss it while other
+  // threads are popping and pushing concurrently. Each miss means another
+  // thread made progress, so yield to it before trying again.
+  absl::optional<Item> item = queue_.Pop();
+  while (!item) {
+    std::this_thread::yield();
+    item = queue_.Pop();
   }
+  CalculatorNode* node = item->Node();
+  CalculatorContext* calculator_context = item->Context();
+  const bool is_open_node = item->IsOpenNode();
+  CHECK(!node->Closed())
+      << "Scheduled a node that was closed. This should not happen.";
+  // The node name outlives any reuse of the calculator context by the run.
+  static const std::string* const kNoNodeName = new std::string();
+  const std::string& node_name =
+      calculator_context ? calculator_context->NodeName() : *kNoNodeName;
+  const int64 queue_time_usec = item->QueueTimeUsec();
+  const int64 start_time_usec =
+      queue_time_usec >= 0 ? shared_->profiler->TimeNowUsec() : 0;
 
   // On iOS, calculators may rely on the existence of an autorelease pool
   // (either directly, or because system code they call does). We do not
   // want to rely on executors setting up an autorelease pool for us (e.g.
   // an executor creating standard pthread will not, by default), so we
   // do it here to ensure all executors are covered.
+  const SchedulerQueue* const outer_queue = current_queue;
+  const int outer_unit = current_unit;
+  current_queue = this;
+  current_unit = node->FusedUnitHead();
   AUTORELEASEPOOL {
     if (is_open_node) {
       DCHECK(!calculator_context);
@@ -217,13 +284,21 @@ void SchedulerQueue::RunNextTask() {
       RunCalculatorNode(node, calculator_context);
     }
   }
+  current_queue = outer_queue;
+  current_unit = outer_unit;
+  if (queue_time_usec >= 0) {
+    shared_->profiler->AddSchedulerSample(executor_name_, node_name,
+                                          queue_time_usec, start_time_usec,
+                                          shared_->profiler->TimeNowUsec());
+  }
 
   bool is_idle;
   {
     absl::MutexLock lock(&mutex_);
-    DCHECK_GT(num_pending_tasks_, 0);
-    --num_pending_tasks_;
-    is_idle = IsIdle();
+    DCHECK_GT(num_active_items_, 0);
+    --num_active_items_;
+    VLOG(3) << "Scheduler queue active items: " << num_active_items_;
+    is_idle = num_active_items_ == 0;
   }
   if (is_idle && idle_callback_) {
     // Became idle.
@@ -295,16 +370,16 @@ void SchedulerQueue::OpenCalculatorNode(CalculatorNode* node) {
 }
 
 void SchedulerQueue::CleanupAfterRun() {
+  // No task may be running at this point, so every active item is still in
+  // the queue and none of them has been submitted to the executor.
   bool was_idle;
   {
     absl::MutexLock lock(&mutex_);
-    was_idle = IsIdle();
-    CHECK_EQ(num_pending_tasks_, 0);
-    CHECK_EQ(num_tasks_to_add_, queue_.size());
+    was_idle = num_active_items_ == 0;
+    CHECK_EQ(num_tasks_to_add_, queue_.Size());
+    CHECK_EQ(num_active_items_, queue_.Clear());
+    num_active_items_ = 0;
     num_tasks_to_add_ = 0;
-    while (!queue_.empty()) {
-      queue_.pop();
-    }
   }
   if (!was_idle && idle_callback_) {
     // Became idle.
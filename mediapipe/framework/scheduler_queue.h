@@ -18,14 +18,17 @@
 #include <atomic>
 #include <functional>
 #include <memory>
-#include <queue>
+#include <string>
 #include <utility>
 
 #include "absl/base/macros.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/deadline_tracker.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/scheduler_ready_queue.h"
 #include "mediapipe/framework/scheduler_shared.h"
 
 namespace mediapipe {
@@ -35,6 +38,11 @@ class CalculatorNode;
 namespace internal {
 
 // Manages a priority queue of nodes to be run on the associated executor.
+//
+// The ready nodes are kept in a ReadyQueue, so AddNode and RunNextTask do not
+// serialize on a queue-wide mutex while pushing and popping. Only the counters
+// that track the idle state and the tasks to submit are updated under mutex_,
+// which keeps the idle callbacks in order.
 class SchedulerQueue : public TaskQueue {
  public:
   // Callback to be invoked when the queue's idle state changes.
@@ -55,9 +63,26 @@ class SchedulerQueue : public TaskQueue {
 
     bool IsOpenNode() const { return is_open_node_; }
 
+    bool IsSource() const { return is_source_; }
+
+    int Id() const { return id_; }
+
+    // The deadline of the task, in microseconds since the Unix epoch. Only
+    // set in earliest-deadline-first mode.
+    int64 Deadline() const { return deadline_; }
+    void SetDeadline(int64 deadline) { deadline_ = deadline; }
+
+    // The profiler time at which the item entered the queue, or -1 if
+    // scheduler telemetry was not recorded for it.
+    int64 QueueTimeUsec() const { return queue_time_usec_; }
+    void SetQueueTimeUsec(int64 time_usec) { queue_time_usec_ = time_usec; }
+
     // This comparison is meant to be used with a std::priority_queue. Since
     // the priority queue returns higher priority items first, this function
     // means "this is lower priority than that", i.e. "this runs after that".
+    // - OpenNode() tasks run first.
+    // - In earliest-deadline-first mode, earlier deadlines run first. Sources
+    //   have no deadline. The rules below break ties.
     // - Non-sources have priority over sources.
     // - Sources are sorted by layer (lower layer numbers run first), then by
     //   Calculator::SourceProcessOrder (smaller values run first), then by
@@ -68,6 +93,8 @@ class SchedulerQueue : public TaskQueue {
 
    private:
     int64 source_process_order_ = 0;
+    int64 deadline_ = DeadlineTracker::kNoDeadline;
+    int64 queue_time_usec_ = -1;
     CalculatorNode* node_;
     CalculatorContext* cc_;
     int id_ = 0;
@@ -76,12 +103,20 @@ class SchedulerQueue : public TaskQueue {
     bool is_open_node_ = false;  // True if the task should run OpenNode().
   };
 
-  explicit SchedulerQueue(SchedulerShared* shared) : shared_(shared) {}
+  // "executor_name" names the executor of the queue in profiles. It is empty
+  // for the default executor.
+  explicit SchedulerQueue(SchedulerShared* shared,
+                          std::string executor_name = "")
+      : executor_name_(std::move(executor_name)), shared_(shared) {}
 
   // Sets the executor that will run the nodes. Must be called before the
   // scheduler is started.
   void SetExecutor(Executor* executor);
 
+  // Prepares the queue to run the given node. Must be called for every node
+  // assigned to this queue before the scheduler is started.
+  void RegisterNode(const CalculatorNode* node);
+
   // Sets the idle callback. It is called exactly once whenever the queue goes
   // from idle to active, or vice versa.
   // Note: if the queue is accessed by multiple threads, it is possible for
@@ -107,10 +142,9 @@ class SchedulerQueue : public TaskQueue {
   // queue was not running.
   void SetRunning(bool running) ABSL_LOCKS_EXCLUDED(mutex_);
 
-  // Gets the number of tasks that need to be submitted to the executor, and
-  // updates num_pending_tasks_. If this method is called and returns a
-  // non-zero value, the executor's AddTask method *must* be called for each
-  // task returned, but it can be called without holding the lock.
+  // Gets the number of tasks that need to be submitted to the executor. If
+  // this method returns a non-zero value, the executor's AddTask method *must*
+  // be called for each task returned.
   int GetTasksToSubmitToExecutor() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   // Submits tasks that are waiting (e.g. that were added while the queue was
@@ -121,32 +155,43 @@ class SchedulerQueue : public TaskQueue {
   // not already running. Note that if the node was running, then it will be
   // rescheduled upon completion (after checking dependencies), so this call is
   // not lost.
-  void AddNode(CalculatorNode* node, CalculatorContext* cc)
-      ABSL_LOCKS_EXCLUDED(mutex_);
+  // If the node runs inline and this is called from a task of this queue, the
+  // node is run immediately on the calling thread instead, up to
+  // kMaxInlineDepth nested inline runs. Nodes of the fused unit that is
+  // running on the calling thread are always run immediately.
+  void AddNode(CalculatorNode* node, CalculatorContext* cc);
 
   // Adds a node to the scheduler queue for an OpenNode() call.
-  void AddNodeForOpen(CalculatorNode* node) ABSL_LOCKS_EXCLUDED(mutex_);
+  void AddNodeForOpen(CalculatorNode* node);
 
   // Adds an Item to queue_.
-  void AddItemToQueue(Item&& item);
+  void AddItemToQueue(Item&& item) ABSL_LOCKS_EXCLUDED(mutex_);
 
   void CleanupAfterRun() ABSL_LOCKS_EXCLUDED(mutex_);
 
+  // The maximum number of inline node runs nested on one thread, not counting
+  // nodes of the same fused unit, whose nesting is bounded by
+  // ValidatedGraphConfig::kMaxFusedUnitDepth. Limits the stack depth for long
+  // chains of inline nodes.
+  static constexpr int kMaxInlineDepth = 8;
+
  private:
+  // Returns true if the node can be run inline by the calling thread.
+  bool CanRunInline(const CalculatorNode* node) const;
+
   // Used internally by RunNextTask. Invokes ProcessNode or CloseNode, followed
   // by EndScheduling.
-  void RunCalculatorNode(CalculatorNode* node, CalculatorContext* cc)
-      ABSL_LOCKS_EXCLUDED(mutex_);
+  void RunCalculatorNode(CalculatorNode* node, CalculatorContext* cc);
 
   // Used internally by RunNextTask. Invokes OpenNode, followed by
   // CheckIfBecameReady.
-  void OpenCalculatorNode(CalculatorNode* node) ABSL_LOCKS_EXCLUDED(mutex_);
-
-  // Checks whether the queue has no queued nodes or pending tasks.
-  bool IsIdle() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void OpenCalculatorNode(CalculatorNode* node);
 
   Executor* executor_ = nullptr;
 
+  // The name of the executor, reported with scheduler telemetry.
+  const std::string executor_name_;
+
   IdleCallback idle_callback_;
 
   // The net number of times SetRunning(true) has been called.
@@ -156,18 +201,24 @@ class SchedulerQueue : public TaskQueue {
   // Invariant: running_count_ <= 1.
   int running_count_ ABSL_GUARDED_BY(mutex_) = 0;
 
-  // Number of tasks added to the Executor and not yet complete.
-  int num_pending_tasks_ ABSL_GUARDED_BY(mutex_);
+  // Number of items that were added and have not finished running yet, i.e.
+  // the number of queued nodes plus the number of running tasks. The queue is
+  // idle when this is 0.
+  int num_active_items_ ABSL_GUARDED_BY(mutex_) = 0;
 
   // Number of tasks that need to be added to the Executor.
-  int num_tasks_to_add_ ABSL_GUARDED_BY(mutex_);
+  int num_tasks_to_add_ ABSL_GUARDED_BY(mutex_) = 0;
 
-  // Queue of nodes that need to be run.
-  std::priority_queue<Item> queue_ ABSL_GUARDED_BY(mutex_);
-
-  SchedulerShared* const shared_;
+  // Queue of nodes that need to be run. An item is counted in
+  // num_active_items_ before it is pushed, and its task is counted in
+  // num_tasks_to_add_ after, so every submitted task has an item.
+  ReadyQueue<Item> queue_;
 
+  // Guards the counters above. It is only held to update them, never while
+  // pushing to or popping from queue_.
   absl::Mutex mutex_;
+
+  SchedulerShared* const shared_;
 };
 
 }  // namespace internal
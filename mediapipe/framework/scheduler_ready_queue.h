@@ -0,0 +1,247 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_SCHEDULER_READY_QUEUE_H_
+#define MEDIAPIPE_FRAMEWORK_SCHEDULER_READY_QUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "absl/base/optimization.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/memory/memory.h"
+#include "absl/numeric/bits.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
+
+namespace mediapipe {
+namespace internal {
+
+// A concurrent priority queue of ready scheduler items.
+//
+// The ordering is the one defined by Item::operator< (see
+// SchedulerQueue::Item): OpenNode() items run first, then non-source items
+// with larger node ids first, then source items. Since non-source items are
+// ordered by node id alone, they are kept in one bucket per node id, and a
+// bitmap of non-empty buckets lets Pop find the highest id with a few atomic
+// loads. Each bucket has its own mutex, so threads only contend when they
+// touch the same node. OpenNode() and source items are rare and keep using a
+// std::priority_queue under a separate mutex.
+//
+// In earliest-deadline-first mode, non-source items are ordered by deadline
+// first. They stay in their per-node buckets, and Pop picks the bucket whose
+// head has the earliest deadline. This relies on the items of one node
+// having non-decreasing deadlines in push order, which holds since deadlines
+// follow input timestamps. The cost is one atomic load per non-empty bucket
+// in Pop.
+//
+// Item must provide Id(), IsSource(), IsOpenNode(), Deadline() and
+// operator<.
+//
+// The queue is linearizable per bucket but not globally: a Pop that races
+// with a Push of a higher priority item may return a lower priority item.
+// When the queue is not being modified concurrently, Pop always returns the
+// same item as std::priority_queue<Item>::top().
+template <typename Item>
+class ReadyQueue {
+ public:
+  ReadyQueue() = default;
+  ReadyQueue(const ReadyQueue&) = delete;
+  ReadyQueue& operator=(const ReadyQueue&) = delete;
+
+  // The deadline of items that have none.
+  static constexpr int64_t kNoDeadline = std::numeric_limits<int64_t>::max();
+
+  // Enables earliest-deadline-first mode. Must not be called concurrently
+  // with any other method, nor while the queue holds items.
+  void SetEarliestDeadlineFirst(bool earliest_deadline_first) {
+    earliest_deadline_first_ = earliest_deadline_first;
+  }
+
+  // Makes room for non-source items with ids in [0, num_ids). Must not be
+  // called concurrently with any other method. Non-source items with larger
+  // ids still work, but go through the slower priority_queue and only run
+  // once all buckets are empty.
+  void Reserve(int num_ids) {
+    if (num_ids <= static_cast<int>(buckets_.size())) return;
+    while (static_cast<int>(buckets_.size()) < num_ids) {
+      buckets_.push_back(absl::make_unique<Bucket>());
+    }
+    const int num_words = (num_ids + 63) / 64;
+    auto ready_words = absl::make_unique<std::atomic<uint64_t>[]>(num_words);
+    for (int i = 0; i < num_words; ++i) {
+      ready_words[i].store(
+          i < num_words_ ? ready_words_[i].load(std::memory_order_relaxed) : 0,
+          std::memory_order_relaxed);
+    }
+    ready_words_ = std::move(ready_words);
+    num_words_ = num_words;
+  }
+
+  void Push(Item item) {
+    const int id = item.Id();
+    if (item.IsOpenNode() || item.IsSource() || id < 0 ||
+        id >= static_cast<int>(buckets_.size())) {
+      absl::MutexLock lock(&others_mutex_);
+      others_.push(std::move(item));
+      num_others_.fetch_add(1, std::memory_order_release);
+      if (others_.top().IsOpenNode()) {
+        has_open_node_.store(true, std::memory_order_release);
+      }
+    } else {
+      Bucket& bucket = *buckets_[id];
+      absl::MutexLock lock(&bucket.mutex);
+      bucket.items.push_back(std::move(item));
+      if (bucket.items.size() == 1) {
+        bucket.head_deadline.store(bucket.items.front().Deadline(),
+                                   std::memory_order_relaxed);
+        ready_words_[id / 64].fetch_or(uint64_t{1} << (id % 64),
+                                       std::memory_order_release);
+      }
+    }
+    size_.fetch_add(1, std::memory_order_release);
+  }
+
+  // Removes and returns the highest priority item. Returns nullopt if no item
+  // was found; this can happen spuriously while other threads are popping, so
+  // callers that know an item is available should retry.
+  absl::optional<Item> Pop() {
+    absl::optional<Item> item;
+    if (has_open_node_.load(std::memory_order_acquire)) {
+      item = PopOther(/*open_node_only=*/true);
+      if (item) return item;
+    }
+    if (earliest_deadline_first_) {
+      const int id = EarliestDeadlineBucket();
+      if (id >= 0) {
+        item = PopBucket(id);
+        if (item) return item;
+      }
+      // Lost a race for the bucket; take any item in priority order below.
+    }
+    for (int w = num_words_ - 1; w >= 0; --w) {
+      uint64_t bits = ready_words_[w].load(std::memory_order_acquire);
+      while (bits != 0) {
+        const int bit = 63 - absl::countl_zero(bits);
+        bits &= ~(uint64_t{1} << bit);
+        item = PopBucket(w * 64 + bit);
+        if (item) return item;
+      }
+    }
+    return PopOther(/*open_node_only=*/false);
+  }
+
+  // Returns the number of items in the queue. May be stale by the time it
+  // returns, but never smaller than the number of Push calls that have
+  // returned minus the number of Pop calls that have started.
+  int64_t Size() const { return size_.load(std::memory_order_acquire); }
+
+  bool Empty() const { return Size() == 0; }
+
+  // Removes all the items and returns how many there were. Must not be called
+  // concurrently with Push or Pop.
+  int64_t Clear() {
+    int64_t count = 0;
+    while (Pop()) ++count;
+    return count;
+  }
+
+ private:
+  struct ABSL_CACHELINE_ALIGNED Bucket {
+    absl::Mutex mutex;
+    // Items of the same node have the same priority; keep them in FIFO order
+    // so that parallel invocations run in the order they were prepared.
+    std::deque<Item> items ABSL_GUARDED_BY(mutex);
+    // The deadline of the first item. Written under mutex, read without it
+    // in earliest-deadline-first mode.
+    std::atomic<int64_t> head_deadline{kNoDeadline};
+  };
+
+  // Returns the id of the non-empty bucket whose head has the earliest
+  // deadline, preferring larger ids on ties, or -1 if all are empty.
+  int EarliestDeadlineBucket() const {
+    int best_id = -1;
+    int64_t best_deadline = kNoDeadline;
+    for (int w = num_words_ - 1; w >= 0; --w) {
+      uint64_t bits = ready_words_[w].load(std::memory_order_acquire);
+      while (bits != 0) {
+        const int bit = 63 - absl::countl_zero(bits);
+        bits &= ~(uint64_t{1} << bit);
+        const int id = w * 64 + bit;
+        const int64_t deadline =
+            buckets_[id]->head_deadline.load(std::memory_order_relaxed);
+        if (best_id < 0 || deadline < best_deadline) {
+          best_id = id;
+          best_deadline = deadline;
+        }
+      }
+    }
+    return best_id;
+  }
+
+  absl::optional<Item> PopBucket(int id) {
+    Bucket& bucket = *buckets_[id];
+    absl::MutexLock lock(&bucket.mutex);
+    if (bucket.items.empty()) return absl::nullopt;
+    absl::optional<Item> item(std::move(bucket.items.front()));
+    bucket.items.pop_front();
+    if (bucket.items.empty()) {
+      ready_words_[id / 64].fetch_and(~(uint64_t{1} << (id % 64)),
+                                      std::memory_order_relaxed);
+    } else {
+      bucket.head_deadline.store(bucket.items.front().Deadline(),
+                                 std::memory_order_relaxed);
+    }
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return item;
+  }
+
+  absl::optional<Item> PopOther(bool open_node_only) {
+    if (num_others_.load(std::memory_order_acquire) == 0) return absl::nullopt;
+    absl::MutexLock lock(&others_mutex_);
+    if (others_.empty()) return absl::nullopt;
+    if (open_node_only && !others_.top().IsOpenNode()) return absl::nullopt;
+    absl::optional<Item> item(others_.top());
+    others_.pop();
+    num_others_.fetch_sub(1, std::memory_order_relaxed);
+    has_open_node_.store(!others_.empty() && others_.top().IsOpenNode(),
+                         std::memory_order_release);
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return item;
+  }
+
+  std::vector<std::unique_ptr<Bucket>> buckets_;
+  // Bit (id % 64) of word (id / 64) is set if bucket id may be non-empty.
+  std::unique_ptr<std::atomic<uint64_t>[]> ready_words_;
+  int num_words_ = 0;
+  bool earliest_deadline_first_ = false;
+
+  absl::Mutex others_mutex_;
+  std::priority_queue<Item> others_ ABSL_GUARDED_BY(others_mutex_);
+  std::atomic<int64_t> num_others_{0};
+  std::atomic<bool> has_open_node_{false};
+
+  std::atomic<int64_t> size_{0};
+};
+
+}  // namespace internal
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_SCHEDULER_READY_QUEUE_H_
@@ -0,0 +1,289 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/scheduler_ready_queue.h"
+
+#include <queue>
+#include <random>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace internal {
+namespace {
+
+// Has the same ordering as SchedulerQueue::Item, without needing a
+// CalculatorNode.
+class FakeItem {
+ public:
+  FakeItem(int id, bool is_source, int layer, int64_t order, bool is_open_node,
+           int serial,
+           int64_t deadline = ReadyQueue<FakeItem>::kNoDeadline)
+      : id_(id),
+        is_source_(is_source),
+        layer_(layer),
+        order_(order),
+        is_open_node_(is_open_node),
+        serial_(serial),
+        deadline_(deadline) {}
+
+  int Id() const { return id_; }
+  bool IsSource() const { return is_source_; }
+  bool IsOpenNode() const { return is_open_node_; }
+  int serial() const { return serial_; }
+  int64_t Deadline() const { return deadline_; }
+
+  bool operator<(const FakeItem& that) const {
+    if (is_open_node_ || that.is_open_node_) {
+      if (!that.is_open_node_) return false;
+      if (!is_open_node_) return true;
+      return id_ > that.id_;
+    }
+    if (deadline_ != that.deadline_) return deadline_ > that.deadline_;
+    if (is_source_) {
+      if (!that.is_source_) return true;
+      if (layer_ != that.layer_) return layer_ > that.layer_;
+      if (order_ != that.order_) return order_ > that.order_;
+      return id_ > that.id_;
+    }
+    if (that.is_source_) return false;
+    return id_ < that.id_;
+  }
+
+  // Whether the two items have the same priority.
+  bool SamePriority(const FakeItem& that) const {
+    return !(*this < that) && !(that < *this);
+  }
+
+ private:
+  int id_;
+  bool is_source_;
+  int layer_;
+  int64_t order_;
+  bool is_open_node_;
+  int serial_;
+  int64_t deadline_;
+};
+
+std::vector<FakeItem> MakeItems(int num_items, int num_ids, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::vector<FakeItem> items;
+  for (int i = 0; i < num_items; ++i) {
+    const int kind = rng() % 10;
+    const int id = rng() % num_ids;
+    items.emplace_back(id, /*is_source=*/kind == 0, /*layer=*/rng() % 3,
+                       /*order=*/rng() % 5, /*is_open_node=*/kind == 1, i);
+  }
+  return items;
+}
+
+TEST(ReadyQueueTest, EmptyQueue) {
+  ReadyQueue<FakeItem> queue;
+  queue.Reserve(10);
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_FALSE(queue.Pop().has_value());
+}
+
+TEST(ReadyQueueTest, MatchesPriorityQueueOrder) {
+  constexpr int kNumIds = 150;
+  ReadyQueue<FakeItem> queue;
+  queue.Reserve(kNumIds);
+  std::priority_queue<FakeItem> expected;
+  // Interleave pushes and pops to exercise partially filled buckets.
+  std::vector<FakeItem> items = MakeItems(2000, kNumIds, /*seed=*/1);
+  for (int i = 0; i < items.size(); ++i) {
+    queue.Push(items[i]);
+    expected.push(items[i]);
+    if (i % 3 == 2) {
+      absl::optional<FakeItem> item = queue.Pop();
+      ASSERT_TRUE(item.has_value());
+      EXPECT_TRUE(item->SamePriority(expected.top()));
+      expected.pop();
+    }
+  }
+  EXPECT_EQ(queue.Size(), expected.size());
+  while (!expected.empty()) {
+    absl::optional<FakeItem> item = queue.Pop();
+    ASSERT_TRUE(item.has_value());
+    EXPECT_TRUE(item->SamePriority(expected.top()));
+    expected.pop();
+  }
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(ReadyQueueTest, EarliestDeadlineFirstMatchesPriorityQueueOrder) {
+  constexpr int kNumIds = 150;
+  ReadyQueue<FakeItem> queue;
+  queue.SetEarliestDeadlineFirst(true);
+  queue.Reserve(kNumIds);
+  std::priority_queue<FakeItem> expected;
+  std::vector<FakeItem> items = MakeItems(2000, kNumIds, /*seed=*/2);
+  for (int i = 0; i < items.size(); ++i) {
+    const FakeItem& item = items[i];
+    // As in a graph, sources have no deadline and the deadlines of a node
+    // increase with its input timestamps.
+    const int64_t deadline =
+        item.IsSource() ? ReadyQueue<FakeItem>::kNoDeadline
+                        : i / 10 + (item.Id() % 7) * 50;
+    FakeItem with_deadline(item.Id(), item.IsSource(), 0, 0,
+                           item.IsOpenNode(), i, deadline);
+    queue.Push(with_deadline);
+    expected.push(with_deadline);
+    if (i % 3 == 2) {
+      absl::optional<FakeItem> popped = queue.Pop();
+      ASSERT_TRUE(popped.has_value());
+      EXPECT_TRUE(popped->SamePriority(expected.top()));
+      expected.pop();
+    }
+  }
+  while (!expected.empty()) {
+    absl::optional<FakeItem> popped = queue.Pop();
+    ASSERT_TRUE(popped.has_value());
+    EXPECT_TRUE(popped->SamePriority(expected.top()));
+    expected.pop();
+  }
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(ReadyQueueTest, SameNodeItemsAreFifo) {
+  ReadyQueue<FakeItem> queue;
+  queue.Reserve(1);
+  for (int i = 0; i < 5; ++i) {
+    queue.Push(FakeItem(0, false, 0, 0, false, i));
+  }
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(queue.Pop()->serial(), i);
+  }
+}
+
+TEST(ReadyQueueTest, ReservePreservesQueuedItems) {
+  ReadyQueue<FakeItem> queue;
+  queue.Reserve(2);
+  queue.Push(FakeItem(1, false, 0, 0, false, 0));
+  queue.Reserve(200);
+  queue.Push(FakeItem(150, false, 0, 0, false, 1));
+  EXPECT_EQ(queue.Pop()->Id(), 150);
+  EXPECT_EQ(queue.Pop()->Id(), 1);
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(ReadyQueueTest, IdsBeyondReserveAreNotLost) {
+  ReadyQueue<FakeItem> queue;
+  queue.Reserve(1);
+  queue.Push(FakeItem(5, false, 0, 0, false, 0));
+  queue.Push(FakeItem(0, false, 0, 0, false, 1));
+  EXPECT_EQ(queue.Clear(), 2);
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(ReadyQueueTest, ConcurrentPushAndPop) {
+  constexpr int kNumThreads = 8;
+  constexpr int kItemsPerThread = 5000;
+  constexpr int kNumIds = 100;
+  ReadyQueue<FakeItem> queue;
+  queue.Reserve(kNumIds);
+  std::vector<std::vector<bool>> seen(kNumThreads,
+                                      std::vector<bool>(kItemsPerThread));
+  absl::Mutex seen_mutex;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      std::vector<FakeItem> items = MakeItems(kItemsPerThread, kNumIds, t);
+      for (int i = 0; i < kItemsPerThread; ++i) {
+        queue.Push(FakeItem(items[i].Id(), items[i].IsSource(), 0, 0,
+                            items[i].IsOpenNode(), t * kItemsPerThread + i));
+        // Like SchedulerQueue::RunNextTask, every pop follows a push.
+        absl::optional<FakeItem> item = queue.Pop();
+        while (!item) item = queue.Pop();
+        absl::MutexLock lock(&seen_mutex);
+        const int serial = item->serial();
+        EXPECT_FALSE(seen[serial / kItemsPerThread][serial % kItemsPerThread]);
+        seen[serial / kItemsPerThread][serial % kItemsPerThread] = true;
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_TRUE(queue.Empty());
+  for (const auto& thread_seen : seen) {
+    EXPECT_THAT(thread_seen, testing::Each(true));
+  }
+}
+
+// The scheduler queue before ReadyQueue: a std::priority_queue guarded by a
+// single mutex.
+class MutexPriorityQueue {
+ public:
+  void Reserve(int num_ids) {}
+  void Push(FakeItem item) {
+    absl::MutexLock lock(&mutex_);
+    queue_.push(std::move(item));
+  }
+  absl::optional<FakeItem> Pop() {
+    absl::MutexLock lock(&mutex_);
+    if (queue_.empty()) return absl::nullopt;
+    absl::optional<FakeItem> item(queue_.top());
+    queue_.pop();
+    return item;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::priority_queue<FakeItem> queue_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Each benchmark thread repeatedly adds a ready node and runs the next one,
+// as the executor threads do for a wide graph with state.range(0) nodes.
+template <typename Queue>
+void BM_AddAndRunNode(benchmark::State& state) {
+  static Queue* queue = nullptr;
+  const int num_ids = state.range(0);
+  if (state.thread_index() == 0) {
+    queue = new Queue();
+    queue->Reserve(num_ids);
+  }
+  std::vector<FakeItem> items = MakeItems(1024, num_ids, state.thread_index());
+  int i = 0;
+  for (auto _ : state) {
+    queue->Push(FakeItem(items[i].Id(), false, 0, 0, false, i));
+    absl::optional<FakeItem> item = queue->Pop();
+    while (!item) item = queue->Pop();
+    benchmark::DoNotOptimize(item);
+    i = (i + 1) % items.size();
+  }
+  if (state.thread_index() == 0) {
+    delete queue;
+    queue = nullptr;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_AddAndRunNode, MutexPriorityQueue)
+    ->Arg(64)
+    ->Arg(512)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_AddAndRunNode, ReadyQueue<FakeItem>)
+    ->Arg(64)
+    ->Arg(512)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace internal
+}  // namespace mediapipe
@@ -23,12 +23,16 @@
 
 #include "absl/base/macros.h"
 #include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deadline_tracker.h"
 #include "mediapipe/framework/deps/clock.h"
 #include "mediapipe/framework/deps/monotonic_clock.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/status.h"
 
 namespace mediapipe {
+
+class ProfilingContext;
+
 namespace internal {
 
 // This is meant for testing purposes only.
@@ -108,6 +112,10 @@ struct SchedulerShared {
   std::function<void(const absl::Status& error)> error_callback;
   // Collects timing information for measuring overhead.
   internal::SchedulerTimer timer;
+  // Computes the deadlines of input sets, if the graph configures them.
+  internal::DeadlineTracker deadlines;
+  // Records scheduler telemetry. Owned by the graph; may be null.
+  ProfilingContext* profiler = nullptr;
 };
 
 }  // namespace internal
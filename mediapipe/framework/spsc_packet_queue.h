@@ -0,0 +1,169 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_SPSC_PACKET_QUEUE_H_
+#define MEDIAPIPE_FRAMEWORK_SPSC_PACKET_QUEUE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+
+#include "absl/base/optimization.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+namespace internal {
+
+// A FIFO queue of packets for one producer thread and one consumer thread.
+//
+// Packets go into a bounded lock-free ring buffer. Push and Pop only touch
+// the ring's indices, which live on separate cache lines. When the ring is
+// full, Push spills into an overflow deque guarded by a mutex. It keeps
+// spilling until the consumer has drained the overflow, so that the FIFO
+// order is preserved. Input stream queues normally hold a few packets, so
+// the overflow is only used for bursts.
+//
+// Push may be called by one thread at a time ("the producer"). Front, Pop,
+// GetMinTimestampAmongNLatest and Clear may be called by one thread at a
+// time ("the consumer"). Size and Empty may be called from any thread.
+// Callers that need several producers or consumers must serialize them
+// with a mutex, which also makes every operation linearizable.
+class SpscPacketQueue {
+ public:
+  static constexpr int kRingCapacity = 64;
+
+  SpscPacketQueue() : ring_(absl::make_unique<Packet[]>(kRingCapacity)) {}
+  SpscPacketQueue(const SpscPacketQueue&) = delete;
+  SpscPacketQueue& operator=(const SpscPacketQueue&) = delete;
+
+  // Appends a packet. Returns the size of the queue before the push.
+  int64_t Push(Packet packet) {
+    // Counted before the packet is visible, so that Size() never
+    // underestimates the number of packets a consumer can see.
+    const int64_t size_before = size_.fetch_add(1);
+    // Only the producer adds to the overflow, so it cannot become non-empty
+    // behind our back.
+    if (overflow_size_.load(std::memory_order_acquire) == 0) {
+      const uint64_t tail = tail_.load(std::memory_order_relaxed);
+      if (tail - head_.load(std::memory_order_acquire) < kRingCapacity) {
+        ring_[tail % kRingCapacity] = std::move(packet);
+        tail_.store(tail + 1, std::memory_order_release);
+        return size_before;
+      }
+    }
+    absl::MutexLock lock(&overflow_mutex_);
+    overflow_.push_back(std::move(packet));
+    overflow_size_.fetch_add(1, std::memory_order_release);
+    return size_before;
+  }
+
+  // Returns the packet at the head of the queue, or nullptr if the queue is
+  // empty. The pointer stays valid until the next call to Pop or Clear.
+  const Packet* Front() {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head != tail_.load(std::memory_order_acquire)) {
+      return &ring_[head % kRingCapacity];
+    }
+    if (overflow_size_.load(std::memory_order_acquire) == 0) return nullptr;
+    absl::MutexLock lock(&overflow_mutex_);
+    // The ring may have been refilled and then overflowed since it was found
+    // empty. Its packets are older than the ones in the overflow.
+    if (head != tail_.load(std::memory_order_acquire)) {
+      return &ring_[head % kRingCapacity];
+    }
+    return &overflow_.front();
+  }
+
+  // Removes and returns the packet at the head of the queue, which must not
+  // be empty. Sets "size_before" to the size of the queue before the pop.
+  Packet Pop(int64_t* size_before) {
+    Packet packet;
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head != tail_.load(std::memory_order_acquire)) {
+      packet = std::move(ring_[head % kRingCapacity]);
+      head_.store(head + 1, std::memory_order_release);
+    } else {
+      absl::MutexLock lock(&overflow_mutex_);
+      if (head != tail_.load(std::memory_order_acquire)) {
+        packet = std::move(ring_[head % kRingCapacity]);
+        head_.store(head + 1, std::memory_order_release);
+      } else {
+        packet = std::move(overflow_.front());
+        overflow_.pop_front();
+        overflow_size_.fetch_sub(1, std::memory_order_release);
+      }
+    }
+    *size_before = size_.fetch_sub(1);
+    return packet;
+  }
+
+  // If the queue holds at least n packets, returns the timestamp of the n-th
+  // latest one. Otherwise returns the timestamp of the head of the queue, or
+  // Timestamp::Unset() if the queue is empty.
+  Timestamp GetMinTimestampAmongNLatest(int n) {
+    absl::MutexLock lock(&overflow_mutex_);
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    const int64_t ring_size = tail_.load(std::memory_order_acquire) - head;
+    const int64_t size = ring_size + overflow_.size();
+    if (size == 0) {
+      return Timestamp::Unset();
+    }
+    const int64_t index = size - std::min<int64_t>(n, size);
+    if (index < ring_size) {
+      return ring_[(head + index) % kRingCapacity].Timestamp();
+    }
+    return overflow_[index - ring_size].Timestamp();
+  }
+
+  // Returns the number of packets in the queue. This may briefly count a
+  // packet that is being pushed or popped.
+  int64_t Size() const { return size_.load(); }
+
+  // Returns true if the queue holds no packet that the consumer could see.
+  bool Empty() const {
+    return head_.load(std::memory_order_acquire) ==
+               tail_.load(std::memory_order_acquire) &&
+           overflow_size_.load(std::memory_order_acquire) == 0;
+  }
+
+  // Removes all the packets. Must not be called concurrently with Push.
+  void Clear() {
+    int64_t size_before;
+    while (Front() != nullptr) Pop(&size_before);
+  }
+
+ private:
+  std::unique_ptr<Packet[]> ring_;
+  // Both indices only ever increase; slot i is ring_[i % kRingCapacity].
+  // head_ is written by the consumer and tail_ by the producer.
+  ABSL_CACHELINE_ALIGNED std::atomic<uint64_t> head_{0};
+  ABSL_CACHELINE_ALIGNED std::atomic<uint64_t> tail_{0};
+  ABSL_CACHELINE_ALIGNED std::atomic<int64_t> size_{0};
+
+  absl::Mutex overflow_mutex_;
+  std::deque<Packet> overflow_ ABSL_GUARDED_BY(overflow_mutex_);
+  std::atomic<int64_t> overflow_size_{0};
+};
+
+}  // namespace internal
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_SPSC_PACKET_QUEUE_H_
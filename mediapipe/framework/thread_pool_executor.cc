@@ -14,21 +14,24 @@
 
 #include "mediapipe/framework/thread_pool_executor.h"
 
+#include <iterator>
+#include <set>
 #include <utility>
 
+#include "absl/algorithm/container.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/thread_pool_executor.pb.h"
 #include "mediapipe/util/cpu_util.h"
 
 namespace mediapipe {
 
-// static
-absl::StatusOr<Executor*> ThreadPoolExecutor::Create(
-    const MediaPipeOptions& extendable_options) {
-  auto& options =
-      extendable_options.GetExtension(ThreadPoolExecutorOptions::ext);
+namespace internal {
+
+absl::StatusOr<ThreadOptions> ThreadOptionsFromExecutorOptions(
+    const ThreadPoolExecutorOptions& options) {
   if (!options.has_num_threads()) {
     return absl::InvalidArgumentError(
         "num_threads is not specified in ThreadPoolExecutorOptions.");
@@ -70,7 +73,61 @@ absl::StatusOr<Executor*> ThreadPoolExecutor::Create(
     default:
       break;
   }
+  if (options.cpu_id_size() > 0) {
+    std::set<int> cpu_set;
+    for (int cpu_id : options.cpu_id()) {
+      if (cpu_id < 0) {
+        return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+               << "The cpu_id field in ThreadPoolExecutorOptions should be "
+                  "non-negative but contains "
+               << cpu_id;
+      }
+      cpu_set.insert(cpu_id);
+    }
+    thread_options.set_cpu_set(cpu_set);
+  }
+  if (options.has_numa_node()) {
+    const std::set<int> node_cpu_set = NumaNodeCoreIds(options.numa_node());
+    if (node_cpu_set.empty()) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "The numa_node field in ThreadPoolExecutorOptions refers to "
+                "NUMA node "
+             << options.numa_node() << ", which has no processors.";
+    }
+    std::set<int> cpu_set;
+    if (options.cpu_id_size() > 0) {
+      absl::c_set_intersection(thread_options.cpu_set(), node_cpu_set,
+                               std::inserter(cpu_set, cpu_set.begin()));
+      if (cpu_set.empty()) {
+        return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+               << "None of the processors in the cpu_id field of "
+                  "ThreadPoolExecutorOptions belongs to NUMA node "
+               << options.numa_node();
+      }
+    } else {
+      cpu_set = node_cpu_set;
+    }
+    thread_options.set_cpu_set(cpu_set);
+    thread_options.set_numa_node(options.numa_node());
+  }
+#else
+  if (options.cpu_id_size() > 0 || options.has_numa_node()) {
+    LOG(WARNING) << "The cpu_id and numa_node fields in "
+                    "ThreadPoolExecutorOptions are only supported on Linux.";
+  }
 #endif
+  return thread_options;
+}
+
+}  // namespace internal
+
+// static
+absl::StatusOr<Executor*> ThreadPoolExecutor::Create(
+    const MediaPipeOptions& extendable_options) {
+  auto& options =
+      extendable_options.GetExtension(ThreadPoolExecutorOptions::ext);
+  ASSIGN_OR_RETURN(ThreadOptions thread_options,
+                   internal::ThreadOptionsFromExecutorOptions(options));
   return new ThreadPoolExecutor(thread_options, options.num_threads());
 }
 
@@ -19,9 +19,20 @@
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/port/statusor.h"
 #include "mediapipe/framework/port/threadpool.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
 
 namespace mediapipe {
 
+namespace internal {
+
+// Validates the ThreadPoolExecutorOptions and converts them to the
+// ThreadOptions of the worker threads. Shared by the executors that accept
+// ThreadPoolExecutorOptions.
+absl::StatusOr<ThreadOptions> ThreadOptionsFromExecutorOptions(
+    const ThreadPoolExecutorOptions& options);
+
+}  // namespace internal
+
 // A multithreaded executor based on a thread pool.
 class ThreadPoolExecutor : public Executor {
  public:
@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/validated_graph_config.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "absl/container/flat_hash_set.h"
@@ -333,6 +334,33 @@ absl::Status ValidatedGraphConfig::Initialize(
   config_ = std::move(input_config);
   MP_RETURN_IF_ERROR(
       PerformBasicTransforms(graph_registry, graph_options, service_manager));
+  return InitializeCanonicalConfig();
+}
+
+absl::Status ValidatedGraphConfig::InitializeFromSnapshot(
+    absl::string_view snapshot) {
+  RET_CHECK(!initialized_)
+      << "ValidatedGraphConfig can be initialized only once.";
+  RET_CHECK(config_.ParseFromArray(snapshot.data(), snapshot.size()))
+      << "Could not parse the ValidatedGraphConfig snapshot.";
+  for (const auto& node : config_.node()) {
+    RET_CHECK(!GraphRegistry::global_graph_registry.IsRegistered(
+        config_.package(), node.calculator()))
+        << "The ValidatedGraphConfig snapshot contains the unexpanded "
+           "subgraph: "
+        << node.calculator();
+  }
+  return InitializeCanonicalConfig();
+}
+
+absl::StatusOr<std::string> ValidatedGraphConfig::SerializeSnapshot() const {
+  RET_CHECK(initialized_) << "ValidatedGraphConfig is not initialized.";
+  std::string snapshot;
+  RET_CHECK(config_.SerializeToString(&snapshot));
+  return snapshot;
+}
+
+absl::Status ValidatedGraphConfig::InitializeCanonicalConfig() {
   // Initialize the basic node information.
   MP_RETURN_IF_ERROR(InitializeGeneratorInfo());
   MP_RETURN_IF_ERROR(InitializeCalculatorInfo());
@@ -400,6 +428,8 @@ absl::Status ValidatedGraphConfig::Initialize(
 
   MP_RETURN_IF_ERROR(ValidateExecutors());
 
+  ComputeFusedUnits();
+
 #if !defined(MEDIAPIPE_MOBILE)
   VLOG(1) << "ValidatedGraphConfig produced canonical config:\n"
           << config_.DebugString();
@@ -1009,6 +1039,48 @@ absl::Status ValidatedGraphConfig::ValidateExecutors() {
   return absl::OkStatus();
 }
 
+void ValidatedGraphConfig::ComputeFusedUnits() {
+  // Calculators are sorted topologically, so every forward edge points from a
+  // calculator that has already been assigned to a unit.
+  fused_unit_heads_.resize(calculators_.size());
+  // The length of the longest chain of calculators in the unit that ends at
+  // each calculator.
+  std::vector<int> unit_depths(calculators_.size(), 1);
+  for (int node_index = 0; node_index < calculators_.size(); ++node_index) {
+    fused_unit_heads_[node_index] = node_index;
+    const NodeTypeInfo& node_type_info = calculators_[node_index];
+    const CalculatorGraphConfig::Node& node_config = config_.node(node_index);
+    const int num_input_streams =
+        node_type_info.InputStreamTypes().NumEntries();
+    if (!node_type_info.Contract().GetRunInline() ||
+        node_config.max_in_flight() > 1 || num_input_streams == 0) {
+      continue;
+    }
+    int unit_head = -1;
+    int unit_depth = 0;
+    for (int i = 0; i < num_input_streams; ++i) {
+      const EdgeInfo& input_stream =
+          input_streams_[node_type_info.InputStreamBaseIndex() + i];
+      const NodeTypeInfo::NodeRef& producer =
+          output_streams_[input_stream.upstream].parent_node;
+      if (input_stream.back_edge ||
+          producer.type != NodeTypeInfo::NodeType::CALCULATOR ||
+          (unit_head != -1 &&
+           fused_unit_heads_[producer.index] != unit_head)) {
+        unit_head = -1;
+        break;
+      }
+      unit_head = fused_unit_heads_[producer.index];
+      unit_depth = std::max(unit_depth, unit_depths[producer.index]);
+    }
+    if (unit_head != -1 && unit_depth < kMaxFusedUnitDepth &&
+        config_.node(unit_head).executor() == node_config.executor()) {
+      fused_unit_heads_[node_index] = unit_head;
+      unit_depths[node_index] = unit_depth + 1;
+    }
+  }
+}
+
 // static
 bool ValidatedGraphConfig::IsReservedExecutorName(const std::string& name) {
   return name == "default" || name == "gpu" || absl::StartsWith(name, "__");
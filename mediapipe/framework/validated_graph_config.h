@@ -16,9 +16,12 @@
 #define MEDIAPIPE_FRAMEWORK_VALIDATED_GRAPH_CONFIG_H_
 
 #include <map>
+#include <string>
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_contract.h"
 #include "mediapipe/framework/graph_service_manager.h"
@@ -223,6 +226,18 @@ class ValidatedGraphConfig {
       const Subgraph::SubgraphOptions* graph_options = nullptr,
       const GraphServiceManager* service_manager = nullptr);
 
+  // Initializes the ValidatedGraphConfig from a snapshot returned by
+  // SerializeSnapshot.  The snapshot holds the canonical config, so subgraph
+  // and template expansion and node sorting are skipped.  The calculator
+  // contracts and stream types are still validated.
+  absl::Status InitializeFromSnapshot(absl::string_view snapshot);
+
+  // Returns the canonical config as a binary snapshot, which can be saved and
+  // passed to InitializeFromSnapshot.  Objects that subgraphs add to graph
+  // services during expansion, such as task model resources, are not part of
+  // the snapshot.
+  absl::StatusOr<std::string> SerializeSnapshot() const;
+
   // Returns true if the ValidatedGraphConfig has been initialized.
   bool Initialized() const { return initialized_; }
 
@@ -282,6 +297,20 @@ class ValidatedGraphConfig {
     return output_streams_[iter->second].parent_node.index;
   }
 
+  // Returns the index of the first calculator of the fused unit containing
+  // the calculator with index |node_index|. A calculator that is not fused
+  // with its producers is the first calculator of its own unit. The scheduler
+  // runs all calculators of a fused unit on the thread of the unit's first
+  // calculator.
+  int FusedUnitHead(int node_index) const {
+    return fused_unit_heads_[node_index];
+  }
+
+  // The maximum length of a chain of calculators within a fused unit. The
+  // scheduler runs a unit by nested calls on one thread, so this bounds the
+  // stack depth of a unit.
+  static constexpr int kMaxFusedUnitDepth = 8;
+
   std::vector<int> OutputStreamToConsumers(int idx) const {
     auto iter = output_streams_to_consumer_nodes_.find(idx);
     if (iter == output_streams_to_consumer_nodes_.end()) {
@@ -317,6 +346,9 @@ class ValidatedGraphConfig {
       const Subgraph::SubgraphOptions* graph_options,
       const GraphServiceManager* service_manager);
 
+  // Validates config_ after subgraph expansion and the basic transforms.
+  absl::Status InitializeCanonicalConfig();
+
   // Initialize the PacketGenerator information.
   absl::Status InitializeGeneratorInfo();
   // Initialize the Calculator information.
@@ -394,6 +426,14 @@ class ValidatedGraphConfig {
   // Compute the dependence of nodes on sources.
   absl::Status ComputeSourceDependence();
 
+  // Groups calculators into fused units. A calculator joins the unit of its
+  // producers if it runs inline, has max_in_flight 1, and all its input
+  // streams are forward edges from calculators of a single unit on the same
+  // executor, and the unit is not already kMaxFusedUnitDepth calculators deep
+  // at its producers. For example, a split, a few transforms and a
+  // concatenate of inline calculators form a single unit.
+  void ComputeFusedUnits();
+
   // Infer the type of types set to "Any" by what they are connected to.
   absl::Status ResolveAnyTypes(std::vector<EdgeInfo>* input_edges,
                                std::vector<EdgeInfo>* output_edges);
@@ -427,6 +467,9 @@ class ValidatedGraphConfig {
   // Mapping from stream name to the output_streams_ index which produces it.
   std::map<std::string, int> stream_to_producer_;
 
+  // For each calculator, the index of the first calculator of its fused unit.
+  std::vector<int> fused_unit_heads_;
+
   // Mapping from output streams to consumer node ids. Used for profiling.
   std::map<int, std::vector<int>> output_streams_to_consumer_nodes_;
 
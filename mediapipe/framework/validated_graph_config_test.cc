@@ -10,8 +10,10 @@
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/graph_service.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"
 
 namespace mediapipe {
@@ -163,4 +165,175 @@ TEST(ValidatedGraphConfigTest, InitializeSubgraphWithServiceCalculatorB) {
   }
 }
 
+TEST(ValidatedGraphConfigTest, InitializeFromSnapshot) {
+  CalculatorGraphConfig graph;
+  graph.add_node()->set_calculator("AlwaysCalculatorASubgraph");
+  graph.add_node()->set_calculator("CalculatorB");
+
+  ValidatedGraphConfig expanded;
+  MP_ASSERT_OK(expanded.Initialize(graph,
+                                   /*graph_registry=*/nullptr,
+                                   /*service_manager=*/nullptr));
+  MP_ASSERT_OK_AND_ASSIGN(std::string snapshot, expanded.SerializeSnapshot());
+
+  ValidatedGraphConfig restored;
+  MP_EXPECT_OK(restored.InitializeFromSnapshot(snapshot));
+  ASSERT_TRUE(restored.Initialized());
+  EXPECT_THAT(restored.Config(), EqualsProto(expanded.Config()));
+  EXPECT_EQ(restored.CalculatorInfos().size(),
+            expanded.CalculatorInfos().size());
+}
+
+TEST(ValidatedGraphConfigTest, InitializeFromSnapshotRejectsSubgraphs) {
+  CalculatorGraphConfig graph;
+  graph.add_node()->set_calculator("AlwaysCalculatorASubgraph");
+
+  ValidatedGraphConfig config;
+  EXPECT_FALSE(config.InitializeFromSnapshot(graph.SerializeAsString()).ok());
+  EXPECT_FALSE(config.Initialized());
+}
+
+TEST(ValidatedGraphConfigTest, SerializeSnapshotRequiresInitialize) {
+  ValidatedGraphConfig config;
+  EXPECT_FALSE(config.SerializeSnapshot().ok());
+}
+
+// A calculator that runs inline, with any number of int inputs and outputs.
+class InlineCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    for (CollectionItemId id = cc->Inputs().BeginId();
+         id < cc->Inputs().EndId(); ++id) {
+      cc->Inputs().Get(id).Set<int>();
+    }
+    for (CollectionItemId id = cc->Outputs().BeginId();
+         id < cc->Outputs().EndId(); ++id) {
+      cc->Outputs().Get(id).Set<int>();
+    }
+    cc->SetRunInline(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(InlineCalculator);
+
+TEST(ValidatedGraphConfigTest, FusesInlineCalculators) {
+  CalculatorGraphConfig graph = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    executor { name: "other" }
+    # Fed by a graph input stream, starts a unit.
+    node {
+      calculator: "InlineCalculator"
+      input_stream: "in"
+      output_stream: "a"
+    }
+    # Split, transform and concatenate: fused with node 0.
+    node { calculator: "InlineCalculator" input_stream: "a" output_stream: "b" }
+    node { calculator: "InlineCalculator" input_stream: "a" output_stream: "c" }
+    node {
+      calculator: "InlineCalculator"
+      input_stream: "b"
+      input_stream: "c"
+      output_stream: "d"
+    }
+    # Does not run inline.
+    node {
+      calculator: "CalculatorB"
+      input_stream: "NN:d"
+      output_stream: "NN:e"
+    }
+    # Fused with node 4 although node 4 does not run inline.
+    node { calculator: "InlineCalculator" input_stream: "e" output_stream: "f" }
+    # Runs on another executor.
+    node {
+      calculator: "InlineCalculator"
+      input_stream: "d"
+      output_stream: "g"
+      executor: "other"
+    }
+    # Has inputs from two units.
+    node {
+      calculator: "InlineCalculator"
+      input_stream: "d"
+      input_stream: "f"
+      output_stream: "h"
+    }
+    # May run in parallel.
+    node {
+      calculator: "InlineCalculator"
+      input_stream: "d"
+      output_stream: "i"
+      max_in_flight: 2
+    }
+  )pb");
+
+  ValidatedGraphConfig config;
+  MP_ASSERT_OK(config.Initialize(graph));
+  std::vector<int> fused_unit_heads;
+  for (int i = 0; i < config.CalculatorInfos().size(); ++i) {
+    fused_unit_heads.push_back(config.FusedUnitHead(i));
+  }
+  EXPECT_THAT(fused_unit_heads,
+              testing::ElementsAre(0, 0, 0, 0, 4, 4, 6, 7, 8));
+}
+
+TEST(ValidatedGraphConfigTest, SplitsLongChainsIntoFusedUnits) {
+  constexpr int kChainLength = 20;
+  CalculatorGraphConfig graph;
+  graph.add_input_stream("s0");
+  for (int i = 0; i < kChainLength; ++i) {
+    CalculatorGraphConfig::Node* node = graph.add_node();
+    node->set_calculator("InlineCalculator");
+    node->add_input_stream(absl::StrCat("s", i));
+    node->add_output_stream(absl::StrCat("s", i + 1));
+  }
+
+  ValidatedGraphConfig config;
+  MP_ASSERT_OK(config.Initialize(graph));
+  for (int i = 0; i < kChainLength; ++i) {
+    EXPECT_EQ(config.FusedUnitHead(i),
+              i / ValidatedGraphConfig::kMaxFusedUnitDepth *
+                  ValidatedGraphConfig::kMaxFusedUnitDepth);
+  }
+}
+
+// Builds a graph with |num_subgraphs| subgraph nodes, each expanding into a
+// single calculator.
+CalculatorGraphConfig SubgraphChainConfig(int num_subgraphs) {
+  CalculatorGraphConfig graph;
+  for (int i = 0; i < num_subgraphs; ++i) {
+    graph.add_node()->set_calculator("AlwaysCalculatorASubgraph");
+  }
+  return graph;
+}
+
+void BM_InitializeExpanding(benchmark::State& state) {
+  CalculatorGraphConfig graph = SubgraphChainConfig(state.range(0));
+  for (auto _ : state) {
+    ValidatedGraphConfig config;
+    CHECK(config.Initialize(graph, /*graph_registry=*/nullptr,
+                            /*service_manager=*/nullptr)
+              .ok());
+  }
+}
+BENCHMARK(BM_InitializeExpanding)->Arg(10)->Arg(100);
+
+void BM_InitializeFromSnapshot(benchmark::State& state) {
+  ValidatedGraphConfig expanded;
+  CHECK(expanded
+            .Initialize(SubgraphChainConfig(state.range(0)),
+                        /*graph_registry=*/nullptr,
+                        /*service_manager=*/nullptr)
+            .ok());
+  std::string snapshot = expanded.SerializeSnapshot().value();
+  for (auto _ : state) {
+    ValidatedGraphConfig config;
+    CHECK(config.InitializeFromSnapshot(snapshot).ok());
+  }
+}
+BENCHMARK(BM_InitializeFromSnapshot)->Arg(10)->Arg(100);
+
 }  // namespace mediapipe
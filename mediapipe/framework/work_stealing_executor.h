@@ -0,0 +1,58 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_WORK_STEALING_EXECUTOR_H_
+#define MEDIAPIPE_FRAMEWORK_WORK_STEALING_EXECUTOR_H_
+
+#include "mediapipe/framework/deps/thread_options.h"
+#include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/port/work_stealing_threadpool.h"
+
+namespace mediapipe {
+
+// A multithreaded executor based on a work-stealing thread pool.
+//
+// Takes the same ThreadPoolExecutorOptions as ThreadPoolExecutor, but each
+// worker thread has its own task queue, so scheduling a task does not contend
+// on a pool-wide mutex. Prefer it over ThreadPoolExecutor on machines with
+// many cores. Select it in the graph config with:
+//
+//   executor {
+//     type: "WorkStealingExecutor"
+//     options {
+//       [mediapipe.ThreadPoolExecutorOptions.ext] { num_threads: 32 }
+//     }
+//   }
+class WorkStealingExecutor : public Executor {
+ public:
+  static absl::StatusOr<Executor*> Create(
+      const MediaPipeOptions& extendable_options);
+
+  explicit WorkStealingExecutor(int num_threads);
+  ~WorkStealingExecutor() override;
+  void Schedule(std::function<void()> task) override;
+
+  // For testing.
+  int num_threads() const { return thread_pool_.num_threads(); }
+
+ private:
+  WorkStealingExecutor(const ThreadOptions& thread_options, int num_threads);
+
+  mediapipe::WorkStealingThreadPool thread_pool_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_WORK_STEALING_EXECUTOR_H_
@@ -0,0 +1,172 @@
+/* Copyright 2023 The MediaPipe Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Startup tests and benchmarks for the hand landmarker task graph, comparing
+// initialization with subgraph expansion against initialization from a
+// config snapshot.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/api2/builder.h"
+#include "mediapipe/framework/api2/port.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/formats/classification.pb.h"
+#include "mediapipe/framework/formats/image.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/rect.pb.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/tasks/cc/core/mediapipe_builtin_op_resolver.h"
+#include "mediapipe/tasks/cc/core/model_resources_cache.h"
+#include "mediapipe/tasks/cc/core/proto/base_options.pb.h"
+#include "mediapipe/tasks/cc/core/proto/external_file.pb.h"
+#include "mediapipe/tasks/cc/vision/hand_detector/proto/hand_detector_graph_options.pb.h"
+#include "mediapipe/tasks/cc/vision/hand_landmarker/proto/hand_landmarker_graph_options.pb.h"
+
+namespace mediapipe {
+namespace tasks {
+namespace vision {
+namespace hand_landmarker {
+
+namespace {
+
+using ::mediapipe::NormalizedRect;
+using ::mediapipe::api2::Input;
+using ::mediapipe::api2::Output;
+using ::mediapipe::api2::builder::Graph;
+using ::mediapipe::file::JoinPath;
+using ::mediapipe::tasks::core::kModelResourcesCacheService;
+using ::mediapipe::tasks::core::ModelResourcesCache;
+using ::mediapipe::tasks::vision::hand_landmarker::proto::
+    HandLandmarkerGraphOptions;
+
+constexpr char kTestDataDirectory[] = "/mediapipe/tasks/testdata/vision/";
+constexpr char kHandLandmarkerModelBundle[] = "hand_landmarker.task";
+
+constexpr char kImageTag[] = "IMAGE";
+constexpr char kImageName[] = "image_in";
+constexpr char kNormRectTag[] = "NORM_RECT";
+constexpr char kNormRectName[] = "norm_rect_in";
+constexpr char kLandmarksTag[] = "LANDMARKS";
+constexpr char kLandmarksName[] = "landmarks";
+constexpr char kWorldLandmarksTag[] = "WORLD_LANDMARKS";
+constexpr char kWorldLandmarksName[] = "world_landmarks";
+constexpr char kHandednessTag[] = "HANDEDNESS";
+constexpr char kHandednessName[] = "handedness";
+
+constexpr int kMaxNumHands = 2;
+
+// Returns the unexpanded hand landmarker graph config, as built by the task
+// API.
+CalculatorGraphConfig HandLandmarkerGraphConfig() {
+  Graph graph;
+  auto& hand_landmarker_graph = graph.AddNode(
+      "mediapipe.tasks.vision.hand_landmarker.HandLandmarkerGraph");
+  auto& options =
+      hand_landmarker_graph.GetOptions<HandLandmarkerGraphOptions>();
+  options.mutable_base_options()->mutable_model_asset()->set_file_name(
+      JoinPath("./", kTestDataDirectory, kHandLandmarkerModelBundle));
+  options.mutable_hand_detector_graph_options()->set_num_hands(kMaxNumHands);
+
+  graph[Input<Image>(kImageTag)].SetName(kImageName) >>
+      hand_landmarker_graph.In(kImageTag);
+  graph[Input<NormalizedRect>(kNormRectTag)].SetName(kNormRectName) >>
+      hand_landmarker_graph.In(kNormRectTag);
+  hand_landmarker_graph.Out(kLandmarksTag).SetName(kLandmarksName) >>
+      graph[Output<std::vector<NormalizedLandmarkList>>(kLandmarksTag)];
+  hand_landmarker_graph.Out(kWorldLandmarksTag).SetName(kWorldLandmarksName) >>
+      graph[Output<std::vector<LandmarkList>>(kWorldLandmarksTag)];
+  hand_landmarker_graph.Out(kHandednessTag).SetName(kHandednessName) >>
+      graph[Output<std::vector<ClassificationList>>(kHandednessTag)];
+  return graph.GetConfig();
+}
+
+std::shared_ptr<ModelResourcesCache> CreateModelResourcesCache() {
+  return std::make_shared<ModelResourcesCache>(
+      absl::make_unique<core::MediaPipeBuiltinOpResolver>());
+}
+
+TEST(HandLandmarkerGraphStartupTest, InitializesFromSnapshot) {
+  auto model_resources_cache = CreateModelResourcesCache();
+  CalculatorGraph expanded;
+  MP_ASSERT_OK(expanded.SetServiceObject(kModelResourcesCacheService,
+                                         model_resources_cache));
+  MP_ASSERT_OK(expanded.Initialize(HandLandmarkerGraphConfig()));
+  MP_ASSERT_OK_AND_ASSIGN(std::string snapshot, expanded.GetConfigSnapshot());
+
+  // The model resources registered while expanding must be provided again,
+  // since the snapshot skips the subgraphs that load them.
+  CalculatorGraph restored;
+  MP_ASSERT_OK(restored.SetServiceObject(kModelResourcesCacheService,
+                                         model_resources_cache));
+  MP_ASSERT_OK(restored.InitializeFromSnapshot(snapshot));
+  MP_ASSERT_OK_AND_ASSIGN(std::string restored_snapshot,
+                          restored.GetConfigSnapshot());
+  EXPECT_EQ(restored_snapshot, snapshot);
+}
+
+// Both benchmarks share a model resources cache that is populated before
+// timing starts, so they measure graph initialization rather than model
+// loading.
+void BM_HandLandmarkerGraphInitializeExpanding(benchmark::State& state) {
+  const CalculatorGraphConfig config = HandLandmarkerGraphConfig();
+  auto model_resources_cache = CreateModelResourcesCache();
+  {
+    CalculatorGraph graph;
+    CHECK_OK(graph.SetServiceObject(kModelResourcesCacheService,
+                                    model_resources_cache));
+    CHECK_OK(graph.Initialize(config));
+  }
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    CHECK_OK(graph.SetServiceObject(kModelResourcesCacheService,
+                                    model_resources_cache));
+    CHECK_OK(graph.Initialize(config));
+  }
+}
+BENCHMARK(BM_HandLandmarkerGraphInitializeExpanding);
+
+void BM_HandLandmarkerGraphInitializeFromSnapshot(benchmark::State& state) {
+  auto model_resources_cache = CreateModelResourcesCache();
+  std::string snapshot;
+  {
+    CalculatorGraph graph;
+    CHECK_OK(graph.SetServiceObject(kModelResourcesCacheService,
+                                    model_resources_cache));
+    CHECK_OK(graph.Initialize(HandLandmarkerGraphConfig()));
+    snapshot = graph.GetConfigSnapshot().value();
+  }
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    CHECK_OK(graph.SetServiceObject(kModelResourcesCacheService,
+                                    model_resources_cache));
+    CHECK_OK(graph.InitializeFromSnapshot(snapshot));
+  }
+}
+BENCHMARK(BM_HandLandmarkerGraphInitializeFromSnapshot);
+
+}  // namespace
+
+}  // namespace hand_landmarker
+}  // namespace vision
+}  // namespace tasks
+}  // namespace mediapipe
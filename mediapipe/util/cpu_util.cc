@@ -30,6 +30,8 @@
 #include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
 #include "absl/strings/substitute.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/integral_types.h"
@@ -40,6 +42,11 @@ ABSL_FLAG(std::string, system_cpu_max_freq_file,
           "The file pattern for CPU max frequencies, where $0 will be replaced "
           "with the CPU id.");
 
+ABSL_FLAG(std::string, system_numa_node_cpulist_file,
+          "/sys/devices/system/node/node$0/cpulist",
+          "The file pattern for the CPU list of a NUMA node, where $0 will be "
+          "replaced with the NUMA node id.");
+
 namespace mediapipe {
 namespace {
 
@@ -136,4 +143,41 @@ std::set<int> InferHigherCoreIds() {
   return InferLowerOrHigherCoreIds(/* lower= */ false);
 }
 
+std::set<int> ParseCpuList(absl::string_view cpu_list) {
+  std::set<int> cpus;
+  for (absl::string_view range :
+       absl::StrSplit(absl::StripAsciiWhitespace(cpu_list), ',',
+                      absl::SkipEmpty())) {
+    std::vector<absl::string_view> bounds =
+        absl::StrSplit(range, absl::MaxSplits('-', 1));
+    int first, last;
+    if (!absl::SimpleAtoi(bounds[0], &first) || first < 0) return {};
+    if (bounds.size() == 1) {
+      last = first;
+    } else if (!absl::SimpleAtoi(bounds[1], &last) || last < first) {
+      return {};
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.insert(cpu);
+    }
+  }
+  return cpus;
+}
+
+std::set<int> NumaNodeCoreIds(int numa_node) {
+  if (numa_node < 0 ||
+      !absl::StrContains(absl::GetFlag(FLAGS_system_numa_node_cpulist_file),
+                         "$0")) {
+    return {};
+  }
+  std::ifstream file(absl::Substitute(
+      absl::GetFlag(FLAGS_system_numa_node_cpulist_file), numa_node));
+  if (!file.is_open()) {
+    return {};
+  }
+  std::string cpu_list;
+  std::getline(file, cpu_list);
+  return ParseCpuList(cpu_list);
+}
+
 }  // namespace mediapipe.
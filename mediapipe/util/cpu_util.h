@@ -17,6 +17,8 @@
 
 #include <set>
 
+#include "absl/strings/string_view.h"
+
 namespace mediapipe {
 // Returns the number of CPU cores. Compatible with Android.
 int NumCPUCores();
@@ -24,6 +26,13 @@ int NumCPUCores();
 std::set<int> InferLowerCoreIds();
 // Returns a set of inferred CPU ids of higher cores.
 std::set<int> InferHigherCoreIds();
+// Returns the ids of the CPUs that belong to the given NUMA node, or an empty
+// set if the node does not exist or the platform does not expose NUMA
+// topology.
+std::set<int> NumaNodeCoreIds(int numa_node);
+// Parses a Linux CPU list such as "0-3,8,10-11". Returns an empty set if the
+// list is malformed.
+std::set<int> ParseCpuList(absl::string_view cpu_list);
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_UTIL_CPU_UTIL_H_
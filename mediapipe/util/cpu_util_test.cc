@@ -0,0 +1,93 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/cpu_util.h"
+
+#include <fstream>
+#include <string>
+
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/reflection.h"
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+ABSL_DECLARE_FLAG(std::string, system_numa_node_cpulist_file);
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+TEST(CpuUtilTest, ParseCpuListSingleIds) {
+  EXPECT_THAT(ParseCpuList("0"), ElementsAre(0));
+  EXPECT_THAT(ParseCpuList("3,1,7"), ElementsAre(1, 3, 7));
+}
+
+TEST(CpuUtilTest, ParseCpuListRanges) {
+  EXPECT_THAT(ParseCpuList("0-3"), ElementsAre(0, 1, 2, 3));
+  EXPECT_THAT(ParseCpuList("0-1,4,6-7"), ElementsAre(0, 1, 4, 6, 7));
+  EXPECT_THAT(ParseCpuList("2-2"), ElementsAre(2));
+  // Overlapping ranges are merged.
+  EXPECT_THAT(ParseCpuList("0-2,1-3"), ElementsAre(0, 1, 2, 3));
+}
+
+TEST(CpuUtilTest, ParseCpuListWhitespace) {
+  // The sysfs files end with a newline.
+  EXPECT_THAT(ParseCpuList("0-1,4\n"), ElementsAre(0, 1, 4));
+  EXPECT_THAT(ParseCpuList(" 0 - 1 , 4 "), ElementsAre(0, 1, 4));
+  EXPECT_THAT(ParseCpuList("0,,1,"), ElementsAre(0, 1));
+}
+
+TEST(CpuUtilTest, ParseCpuListEmpty) {
+  EXPECT_THAT(ParseCpuList(""), IsEmpty());
+  EXPECT_THAT(ParseCpuList("\n"), IsEmpty());
+}
+
+TEST(CpuUtilTest, ParseCpuListMalformed) {
+  EXPECT_THAT(ParseCpuList("a"), IsEmpty());
+  EXPECT_THAT(ParseCpuList("0,x"), IsEmpty());
+  EXPECT_THAT(ParseCpuList("0-"), IsEmpty());
+  EXPECT_THAT(ParseCpuList("-3"), IsEmpty());
+  EXPECT_THAT(ParseCpuList("0--3"), IsEmpty());
+  EXPECT_THAT(ParseCpuList("3-1"), IsEmpty());
+  EXPECT_THAT(ParseCpuList("0-1-2"), IsEmpty());
+  EXPECT_THAT(ParseCpuList("99999999999"), IsEmpty());
+}
+
+TEST(CpuUtilTest, NumaNodeCoreIdsReadsCpuList) {
+  absl::FlagSaver flag_saver;
+  const std::string pattern =
+      file::JoinPath(::testing::TempDir(), "numa_node$0_cpulist");
+  absl::SetFlag(&FLAGS_system_numa_node_cpulist_file, pattern);
+  std::ofstream(file::JoinPath(::testing::TempDir(), "numa_node1_cpulist"))
+      << "2-3,6\n";
+
+  EXPECT_THAT(NumaNodeCoreIds(1), ElementsAre(2, 3, 6));
+  // Missing nodes and invalid node ids have no processors.
+  EXPECT_THAT(NumaNodeCoreIds(5), IsEmpty());
+  EXPECT_THAT(NumaNodeCoreIds(-1), IsEmpty());
+}
+
+TEST(CpuUtilTest, NumaNodeCoreIdsRejectsPatternWithoutNodeId) {
+  absl::FlagSaver flag_saver;
+  absl::SetFlag(&FLAGS_system_numa_node_cpulist_file,
+                file::JoinPath(::testing::TempDir(), "cpulist"));
+  EXPECT_THAT(NumaNodeCoreIds(0), IsEmpty());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,170 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tflite/tflite_model_cache.h"
+
+#include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
+#include "mediapipe/framework/deps/no_destructor.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+
+namespace mediapipe {
+
+XnnpackWeightsCache::XnnpackWeightsCache()
+    : cache_(TfLiteXNNPackDelegateWeightsCacheCreate()) {}
+
+XnnpackWeightsCache::~XnnpackWeightsCache() {
+  if (cache_) {
+    TfLiteXNNPackDelegateWeightsCacheDelete(cache_);
+  }
+}
+
+absl::Status XnnpackWeightsCache::Populate(
+    absl::FunctionRef<absl::Status()> create_interpreter) {
+  absl::MutexLock lock(&mutex_);
+  MP_RETURN_IF_ERROR(create_interpreter());
+  if (cache_ && !finalized_) {
+    // A soft-finalized cache still accepts the weights of later interpreters
+    // as long as they are already packed.
+    RET_CHECK(TfLiteXNNPackDelegateWeightsCacheFinalizeSoft(cache_))
+        << "Failed to finalize the XNNPACK weights cache.";
+    finalized_ = true;
+  }
+  return absl::OkStatus();
+}
+
+struct TfLiteModelCache::ModelEntry {
+  ModelKey key;
+  std::string blob;
+  // Set once `loaded` is true; null if the model failed to build.
+  std::unique_ptr<tflite::FlatBufferModel> model;
+  bool loaded = false;
+  int num_users = 0;
+  absl::flat_hash_map<uint32_t, std::shared_ptr<XnnpackWeightsCache>>
+      weights_caches;
+};
+
+TfLiteModelCache::TfLiteModelCache() = default;
+
+TfLiteModelCache::~TfLiteModelCache() = default;
+
+TfLiteModelCache& TfLiteModelCache::GetInstance() {
+  static NoDestructor<TfLiteModelCache> cache;
+  return *cache;
+}
+
+absl::StatusOr<api2::Packet<TfLiteModelPtr>> TfLiteModelCache::GetModel(
+    std::string model_blob) {
+  const ModelKey key(absl::Hash<absl::string_view>()(model_blob),
+                     model_blob.size());
+  ModelEntry* entry = nullptr;
+  bool load = false;
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = models_.find(key);
+    if (it == models_.end()) {
+      ++stats_.model_misses;
+      auto new_entry = std::make_unique<ModelEntry>();
+      new_entry->key = key;
+      new_entry->blob = std::move(model_blob);
+      it = models_.emplace(key, std::move(new_entry)).first;
+      load = true;
+    }
+    entry = it->second.get();
+    // Keeps the entry alive while it is loaded or compared without the lock.
+    ++entry->num_users;
+  }
+
+  if (load) {
+    // Built without the lock so that graphs can load different models in
+    // parallel. Callers asking for the same model wait for this one.
+    auto model = tflite::FlatBufferModel::VerifyAndBuildFromBuffer(
+        entry->blob.data(), entry->blob.size());
+    absl::MutexLock lock(&mutex_);
+    entry->model = std::move(model);
+    if (entry->model) models_by_pointer_[entry->model.get()] = entry;
+    entry->loaded = true;
+  } else if (entry->blob != model_blob) {
+    // Another model with the same key is cached, so this one is not shared.
+    Release(entry);
+    {
+      absl::MutexLock lock(&mutex_);
+      ++stats_.model_misses;
+    }
+    auto model = tflite::FlatBufferModel::VerifyAndBuildFromBuffer(
+        model_blob.data(), model_blob.size());
+    RET_CHECK(model) << "Failed to build model from buffer.";
+    return api2::MakePacket<TfLiteModelPtr>(
+        model.release(),
+        [model_blob = std::move(model_blob)](tflite::FlatBufferModel* model) {
+          delete model;
+        });
+  } else {
+    absl::MutexLock lock(&mutex_);
+    ++stats_.model_hits;
+    mutex_.Await(absl::Condition(&entry->loaded));
+  }
+
+  // The model does not change once loaded, so it can be read without the
+  // lock.
+  if (!entry->model) {
+    Release(entry);
+    RET_CHECK_FAIL() << "Failed to build model from buffer.";
+  }
+  return api2::MakePacket<TfLiteModelPtr>(
+      entry->model.get(),
+      [this, entry](tflite::FlatBufferModel*) { Release(entry); });
+}
+
+void TfLiteModelCache::Release(ModelEntry* entry) {
+  // Destroyed after the lock is released.
+  std::unique_ptr<ModelEntry> released;
+  absl::MutexLock lock(&mutex_);
+  if (--entry->num_users > 0) return;
+  if (entry->model) models_by_pointer_.erase(entry->model.get());
+  auto it = models_.find(entry->key);
+  released = std::move(it->second);
+  models_.erase(it);
+}
+
+std::shared_ptr<XnnpackWeightsCache> TfLiteModelCache::GetXnnpackWeightsCache(
+    const tflite::FlatBufferModel& model, uint32_t delegate_flags) {
+  absl::MutexLock lock(&mutex_);
+  auto it = models_by_pointer_.find(&model);
+  if (it == models_by_pointer_.end()) return nullptr;
+  std::shared_ptr<XnnpackWeightsCache>& weights_cache =
+      it->second->weights_caches[delegate_flags];
+  if (weights_cache) {
+    ++stats_.weights_cache_hits;
+  } else {
+    ++stats_.weights_cache_misses;
+    weights_cache = std::make_shared<XnnpackWeightsCache>();
+  }
+  return weights_cache;
+}
+
+TfLiteModelCacheStats TfLiteModelCache::GetStats() const {
+  absl::MutexLock lock(&mutex_);
+  TfLiteModelCacheStats stats = stats_;
+  for (const auto& [key, entry] : models_) {
+    ++stats.num_models;
+    stats.model_bytes += entry->blob.size();
+    stats.shared_model_bytes += (entry->num_users - 1) * entry->blob.size();
+    stats.num_weights_caches += entry->weights_caches.size();
+  }
+  return stats;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,130 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_TFLITE_TFLITE_MODEL_CACHE_H_
+#define MEDIAPIPE_UTIL_TFLITE_TFLITE_MODEL_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/api2/packet.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/util/tflite/tflite_model_loader.h"
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#include "tensorflow/lite/model.h"
+
+namespace mediapipe {
+
+// Weights packed by the XNNPACK delegates of interpreters that run the same
+// model with the same delegate flags.
+class XnnpackWeightsCache {
+ public:
+  XnnpackWeightsCache();
+  ~XnnpackWeightsCache();
+  XnnpackWeightsCache(const XnnpackWeightsCache&) = delete;
+  XnnpackWeightsCache& operator=(const XnnpackWeightsCache&) = delete;
+
+  // The cache to set in TfLiteXNNPackDelegateOptions::weights_cache. Can be
+  // nullptr if XNNPACK failed to create it.
+  TfLiteXNNPackDelegateWeightsCache* get() const { return cache_; }
+
+  // Calls `create_interpreter`, which creates an interpreter with an XNNPACK
+  // delegate that uses this cache. The first interpreter packs its weights
+  // into the cache, which is then finalized so that interpreters can run.
+  // Later interpreters only look up the packed weights, so they must run the
+  // same model.
+  absl::Status Populate(absl::FunctionRef<absl::Status()> create_interpreter);
+
+ private:
+  TfLiteXNNPackDelegateWeightsCache* const cache_;
+  absl::Mutex mutex_;
+  bool finalized_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+// Usage statistics of a TfLiteModelCache.
+struct TfLiteModelCacheStats {
+  // Number of model requests served with a model that was already loaded,
+  // and number of requests that loaded a model.
+  int64 model_hits = 0;
+  int64 model_misses = 0;
+  // Same for the XNNPACK weights caches of the models.
+  int64 weights_cache_hits = 0;
+  int64 weights_cache_misses = 0;
+  // Number of models currently held, and their total size in bytes.
+  int64 num_models = 0;
+  int64 model_bytes = 0;
+  // Bytes the held models would take in addition if every user had its own
+  // copy.
+  int64 shared_model_bytes = 0;
+  // Number of XNNPACK weights caches currently held.
+  int64 num_weights_caches = 0;
+};
+
+// Process-wide cache of TfLite models, keyed by a hash of their contents,
+// and of the XNNPACK weights packed for them, keyed by delegate flags. Entries
+// are dropped once the last packet of their model is released.
+class TfLiteModelCache {
+ public:
+  // Returns the process-wide cache.
+  static TfLiteModelCache& GetInstance();
+
+  TfLiteModelCache();
+  ~TfLiteModelCache();
+  TfLiteModelCache(const TfLiteModelCache&) = delete;
+  TfLiteModelCache& operator=(const TfLiteModelCache&) = delete;
+
+  // Returns a packet with the model stored in `model_blob`. If a model with
+  // the same contents is still in use, it is shared instead of being built
+  // again. Models are built without holding the cache lock; concurrent
+  // requests for the same model wait for the first one to build it. The cache
+  // must outlive the returned packet.
+  absl::StatusOr<api2::Packet<TfLiteModelPtr>> GetModel(
+      std::string model_blob);
+
+  // Returns the weights cache for XNNPACK delegates with `delegate_flags`
+  // that run `model`, or nullptr if `model` was not returned by GetModel.
+  // Only the flags change how weights are packed, so the other delegate
+  // options are not part of the key.
+  std::shared_ptr<XnnpackWeightsCache> GetXnnpackWeightsCache(
+      const tflite::FlatBufferModel& model, uint32_t delegate_flags);
+
+  TfLiteModelCacheStats GetStats() const;
+
+ private:
+  // The hash and size of the model contents.
+  using ModelKey = std::pair<size_t, size_t>;
+  struct ModelEntry;
+
+  // Called when a packet returned by GetModel is released.
+  void Release(ModelEntry* entry);
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<ModelKey, std::unique_ptr<ModelEntry>> models_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<const tflite::FlatBufferModel*, ModelEntry*>
+      models_by_pointer_ ABSL_GUARDED_BY(mutex_);
+  TfLiteModelCacheStats stats_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_TFLITE_TFLITE_MODEL_CACHE_H_
@@ -0,0 +1,107 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tflite/tflite_model_cache.h"
+
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/tflite/tflite_model_loader.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr char kModelPath[] = "mediapipe/calculators/tensor/testdata/add.bin";
+
+TEST(TfLiteModelCacheTest, SharesModelsWithSameContents) {
+  TfLiteModelCache cache;
+  MP_ASSERT_OK_AND_ASSIGN(std::string model_blob,
+                          TfLiteModelLoader::LoadContentsFromPath(kModelPath));
+  {
+    MP_ASSERT_OK_AND_ASSIGN(auto first, cache.GetModel(model_blob));
+    MP_ASSERT_OK_AND_ASSIGN(auto second, cache.GetModel(model_blob));
+    EXPECT_EQ(first.Get().get(), second.Get().get());
+
+    TfLiteModelCacheStats stats = cache.GetStats();
+    EXPECT_EQ(stats.model_hits, 1);
+    EXPECT_EQ(stats.model_misses, 1);
+    EXPECT_EQ(stats.num_models, 1);
+    EXPECT_EQ(stats.model_bytes, static_cast<int64>(model_blob.size()));
+    EXPECT_EQ(stats.shared_model_bytes,
+              static_cast<int64>(model_blob.size()));
+  }
+  // The model is dropped with its last packet.
+  TfLiteModelCacheStats stats = cache.GetStats();
+  EXPECT_EQ(stats.num_models, 0);
+  EXPECT_EQ(stats.model_bytes, 0);
+}
+
+TEST(TfLiteModelCacheTest, SharesModelsLoadedConcurrently) {
+  constexpr int kNumThreads = 8;
+  TfLiteModelCache cache;
+  MP_ASSERT_OK_AND_ASSIGN(std::string model_blob,
+                          TfLiteModelLoader::LoadContentsFromPath(kModelPath));
+  std::vector<absl::StatusOr<api2::Packet<TfLiteModelPtr>>> models(
+      kNumThreads, absl::UnknownError("Not loaded."));
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&cache, &model_blob, &models, i] {
+      models[i] = cache.GetModel(model_blob);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  for (const auto& model : models) {
+    MP_ASSERT_OK(model);
+    EXPECT_EQ(model->Get().get(), models[0]->Get().get());
+  }
+  TfLiteModelCacheStats stats = cache.GetStats();
+  EXPECT_EQ(stats.model_hits, kNumThreads - 1);
+  EXPECT_EQ(stats.model_misses, 1);
+  EXPECT_EQ(stats.num_models, 1);
+}
+
+TEST(TfLiteModelCacheTest, SharesXnnpackWeightsCachePerDelegateFlags) {
+  TfLiteModelCache cache;
+  MP_ASSERT_OK_AND_ASSIGN(std::string model_blob,
+                          TfLiteModelLoader::LoadContentsFromPath(kModelPath));
+  MP_ASSERT_OK_AND_ASSIGN(auto model, cache.GetModel(model_blob));
+  auto weights_cache = cache.GetXnnpackWeightsCache(*model.Get(), 0);
+  ASSERT_NE(weights_cache, nullptr);
+  EXPECT_EQ(cache.GetXnnpackWeightsCache(*model.Get(), 0), weights_cache);
+  EXPECT_NE(cache.GetXnnpackWeightsCache(*model.Get(), 1), weights_cache);
+
+  TfLiteModelCacheStats stats = cache.GetStats();
+  EXPECT_EQ(stats.weights_cache_hits, 1);
+  EXPECT_EQ(stats.weights_cache_misses, 2);
+  EXPECT_EQ(stats.num_weights_caches, 2);
+
+  // Models loaded outside of the cache get no weights cache.
+  MP_ASSERT_OK_AND_ASSIGN(auto uncached_model,
+                          TfLiteModelLoader::LoadFromPath(kModelPath));
+  EXPECT_EQ(cache.GetXnnpackWeightsCache(*uncached_model.Get(), 0), nullptr);
+}
+
+TEST(TfLiteModelCacheTest, FailsOnInvalidModel) {
+  TfLiteModelCache cache;
+  EXPECT_FALSE(cache.GetModel("not a model").ok());
+  EXPECT_EQ(cache.GetStats().num_models, 0);
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -19,7 +19,7 @@
 
 namespace mediapipe {
 
-absl::StatusOr<api2::Packet<TfLiteModelPtr>> TfLiteModelLoader::LoadFromPath(
+absl::StatusOr<std::string> TfLiteModelLoader::LoadContentsFromPath(
     const std::string& path) {
   std::string model_path = path;
 
@@ -35,6 +35,13 @@ absl::StatusOr<api2::Packet<TfLiteModelPtr>> TfLiteModelLoader::LoadFromPath(
     MP_RETURN_IF_ERROR(
         mediapipe::GetResourceContents(resolved_path, &model_blob));
   }
+  return model_blob;
+}
+
+absl::StatusOr<api2::Packet<TfLiteModelPtr>> TfLiteModelLoader::LoadFromPath(
+    const std::string& path) {
+  const std::string& model_path = path;
+  ASSIGN_OR_RETURN(std::string model_blob, LoadContentsFromPath(model_path));
 
   auto model = tflite::FlatBufferModel::VerifyAndBuildFromBuffer(
       model_blob.data(), model_blob.size());
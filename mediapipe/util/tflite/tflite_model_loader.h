@@ -32,6 +32,10 @@ class TfLiteModelLoader {
   // from the specified file path.
   static absl::StatusOr<api2::Packet<TfLiteModelPtr>> LoadFromPath(
       const std::string& path);
+
+  // Returns the contents of the model file at the specified path.
+  static absl::StatusOr<std::string> LoadContentsFromPath(
+      const std::string& path);
 };
 
 }  // namespace mediapipe